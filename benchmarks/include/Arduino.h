@@ -0,0 +1,121 @@
+#pragma once
+// Minimal Arduino core for the native benchmarks.
+// Only what the benchmarked kernels use. Time is virtual (advanced by the benchmarks) so the
+// runs are deterministic and the instruction counts stable between runs.
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+#define ARDUINO 100
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+#define HIGH 1
+#define LOW 0
+#define INPUT 0
+#define OUTPUT 1
+#define INPUT_PULLUP 2
+#define PI 3.1415926535897932384626433832795
+#define PROGMEM
+#define F(x) x
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#define pgm_read_word(addr) (*(const uint16_t *)(addr))
+#define pgm_read_byte_near(addr) pgm_read_byte(addr)
+#define pgm_read_word_near(addr) pgm_read_word(addr)
+
+#define constrain(amt, low, high) ((amt) < (low) ? (low) : ((amt) > (high) ? (high) : (amt)))
+using std::abs;
+using std::max;
+using std::min;
+
+inline long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+// Virtual time in microseconds
+extern unsigned long benchMicros;
+inline unsigned long micros() { return benchMicros; }
+inline unsigned long millis() { return benchMicros / 1000; }
+inline void delay(unsigned long ms) { benchMicros += ms * 1000; }
+inline void delayMicroseconds(unsigned int us) { benchMicros += us; }
+
+// Same behaviour as the SAMD core (newlib rand based)
+inline long random(long howbig) { return howbig == 0 ? 0 : rand() % howbig; }
+inline long random(long howsmall, long howbig) { return howsmall >= howbig ? howsmall : random(howbig - howsmall) + howsmall; }
+inline void randomSeed(unsigned long seed) { srand(seed); }
+
+inline void noInterrupts() {}
+inline void interrupts() {}
+inline void pinMode(int, int) {}
+inline void digitalWrite(int, int) {}
+inline int digitalRead(int) { return LOW; }
+inline void analogWrite(int, int) {}
+
+class String {
+  public:
+    String() {}
+    String(const char *s) : _s(s ? s : "") {}
+    String(const std::string &s) : _s(s) {}
+    String(char c) : _s(1, c) {}
+    String(int v) : _s(std::to_string(v)) {}
+    String(unsigned int v) : _s(std::to_string(v)) {}
+    String(long v) : _s(std::to_string(v)) {}
+    String(unsigned long v) : _s(std::to_string(v)) {}
+    String(float v, int decimals = 2) { Format(v, decimals); }
+    String(double v, int decimals = 2) { Format(v, decimals); }
+    unsigned int length() const { return _s.size(); }
+    const char *c_str() const { return _s.c_str(); }
+    char operator[](unsigned int i) const { return _s[i]; }
+    bool operator==(const String &o) const { return _s == o._s; }
+    String &operator+=(const String &o) {
+        _s += o._s;
+        return *this;
+    }
+    friend String operator+(const String &a, const String &b) { return String(a._s + b._s); }
+    friend String operator+(const char *a, const String &b) { return String(a + b._s); }
+    friend String operator+(const String &a, const char *b) { return String(a._s + b); }
+
+  private:
+    std::string _s;
+    void Format(double v, int decimals) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.*f", decimals, v);
+        _s = buf;
+    }
+};
+
+class Print {
+  public:
+    virtual ~Print() {}
+    virtual size_t write(uint8_t) = 0;
+    size_t write(const char *s) {
+        size_t n = 0;
+        while (*s) {
+            n += write((uint8_t)*s++);
+        }
+        return n;
+    }
+    size_t print(const char *s) { return write(s); }
+    size_t print(const String &s) { return write(s.c_str()); }
+    size_t print(int v) { return print(String(v)); }
+    size_t print(unsigned int v) { return print(String(v)); }
+    size_t print(long v) { return print(String(v)); }
+    size_t print(unsigned long v) { return print(String(v)); }
+    size_t print(double v, int decimals = 2) { return print(String(v, decimals)); }
+    size_t println(const char *s) { return print(s) + write('\n'); }
+    size_t println(const String &s) { return print(s) + write('\n'); }
+};
+
+class NullSerial : public Print {
+  public:
+    void begin(long) {}
+    size_t write(uint8_t) override { return 1; }
+    int available() { return 0; }
+    int read() { return -1; }
+};
+extern NullSerial Serial;
@@ -0,0 +1,3 @@
+#pragma once
+// Pre 1.0 Arduino core header, still used by some libraries
+#include <Arduino.h>
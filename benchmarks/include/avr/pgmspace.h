@@ -0,0 +1,8 @@
+#pragma once
+// Flash access is plain memory access on the native target
+#include <Arduino.h>
+
+typedef int8_t prog_int8_t;
+typedef int16_t prog_int16_t;
+typedef uint8_t prog_uint8_t;
+typedef uint16_t prog_uint16_t;
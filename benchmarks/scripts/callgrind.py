@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+"""Run the benchmarks natively and under callgrind and write the merged results.
+
+The callgrind instruction count (Ir) per operation is stable between runs and machines,
+unlike the timings, so it is the number to compare between commits. It also scales closely
+with the Cortex-M0 cycle count since both are simple in-order cores.
+
+Usage: callgrind.py [--binary PATH] [--iterations N] [--filter TEXT] [--json FILE] [--commit SHA]
+"""
+import argparse
+import glob
+import json
+import os
+import subprocess
+import sys
+import tempfile
+
+DEFAULT_BINARY = os.path.join(os.path.dirname(__file__), "..", ".pio", "build", "native", "program")
+
+
+def read_dumps(directory):
+    """Return {benchmark name: Ir} from the callgrind dumps in directory."""
+    counts = {}
+    for path in glob.glob(os.path.join(directory, "callgrind.out.*")):
+        name = None
+        total = None
+        with open(path) as f:
+            for line in f:
+                if line.startswith("desc: Trigger: Client Request: "):
+                    name = line.split("Client Request: ", 1)[1].strip()
+                elif line.startswith("summary:") or line.startswith("totals:"):
+                    total = int(line.split()[1])
+        if name is not None and total is not None:
+            counts[name] = total
+    return counts
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("--binary", default=DEFAULT_BINARY)
+    parser.add_argument("--iterations", type=int, default=1000, help="Iterations per benchmark under callgrind")
+    parser.add_argument("--filter", default="")
+    parser.add_argument("--json", help="Write the merged results to this file")
+    parser.add_argument("--commit", default=os.environ.get("GITHUB_SHA", ""))
+    args = parser.parse_args()
+
+    with tempfile.TemporaryDirectory() as tmp:
+        native_json = os.path.join(tmp, "native.json")
+        subprocess.run([args.binary, "--filter", args.filter, "--json", native_json], check=True, stdout=subprocess.DEVNULL)
+        subprocess.run(["valgrind", "--tool=callgrind", "--collect-atstart=no",
+                        "--callgrind-out-file=" + os.path.join(tmp, "callgrind.out.%p"),
+                        args.binary, "--filter", args.filter, "--iterations", str(args.iterations),
+                        "--json", os.path.join(tmp, "callgrind.json")],
+                       check=True, stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        counts = read_dumps(tmp)
+        with open(native_json) as f:
+            results = json.load(f)
+
+    results["commit"] = args.commit
+    print(f"{'Benchmark':40} {'ns/op':>12} {'Ir/op':>12}")
+    for bench in results["benchmarks"]:
+        ir = counts.get(bench["name"])
+        bench["instructions_per_op"] = round(ir / args.iterations, 1) if ir is not None else None
+        ir_text = f"{bench['instructions_per_op']:.1f}" if ir is not None else "-"
+        print(f"{bench['name']:40} {bench['ns_per_op']:12.2f} {ir_text:>12}")
+
+    if args.json:
+        with open(args.json, "w") as f:
+            json.dump(results, f, indent=2)
+            f.write("\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
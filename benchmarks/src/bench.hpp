@@ -0,0 +1,37 @@
+#pragma once
+#include <functional>
+#include <string>
+#include <vector>
+
+// Keep the compiler from optimizing away a benchmarked result
+template <typename T>
+inline void DoNotOptimize(T const &value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// A benchmark runs its kernel the requested amount of iterations
+typedef std::function<void(unsigned long iterations)> BenchFunction;
+
+struct Benchmark {
+    std::string name;
+    BenchFunction run;
+};
+
+inline std::vector<Benchmark> &Benchmarks() {
+    static std::vector<Benchmark> benchmarks;
+    return benchmarks;
+}
+
+inline bool RegisterBenchmark(const std::string &name, BenchFunction run) {
+    Benchmarks().push_back({name, run});
+    return true;
+}
+
+#define BENCH_CONCAT_(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_(a, b)
+
+// Register a benchmark body, `iterations` is available inside
+#define BENCHMARK(NAME)                                                                  \
+    static void BENCH_CONCAT(bench_, __LINE__)(unsigned long iterations);                \
+    static bool BENCH_CONCAT(registered_, __LINE__) = RegisterBenchmark(NAME, BENCH_CONCAT(bench_, __LINE__)); \
+    static void BENCH_CONCAT(bench_, __LINE__)(unsigned long iterations)
@@ -0,0 +1,165 @@
+// ClockForge kernels: output tick processing, envelopes and Euclidean patterns
+#include "../../firmware-CLK/src/engine.hpp"
+#include "../../firmware-CLK/src/outputs.hpp"
+
+#include "bench.hpp"
+#include "canvas.hpp"
+
+#define PPQN 192
+#define TICK_US 651       // Clock timer period at 120 BPM
+#define EUCLIDEAN_STEPS 64 // Output pattern buffer size
+
+extern unsigned long benchMicros;
+
+// Benchmark name from a waveform description ("AD Env" -> "ADEnv")
+static std::string WaveformName(WaveformType type) {
+    std::string name = WaveformTypeDescriptions[type].c_str();
+    name.erase(std::remove(name.begin(), name.end(), ' '), name.end());
+    return name;
+}
+
+// One clock tick of an output, as done by the timer ISR for each output
+template <OutputType Kind>
+static void RunPulse(Output &output, unsigned long iterations) {
+    for (unsigned long tick = 0; tick < iterations; tick++) {
+        output.Pulse<Kind, PPQN>(tick);
+        benchMicros += TICK_US;
+        DoNotOptimize(output.GetOutputLevel<Kind>());
+    }
+}
+
+static bool pulseBenchmarks = [] {
+    for (int i = 0; i < WaveformTypeLength; i++) {
+        std::string name = "Output::Pulse/" + WaveformName(static_cast<WaveformType>(i));
+        RegisterBenchmark(name, [i](unsigned long iterations) {
+            Output output(3, OutputType::DACOut);
+            output.SetWaveformType(static_cast<WaveformType>(i));
+            output.SetDivider(9); // Envelope types default to the "Env" divider which never fires from the clock
+            RunPulse<OutputType::DACOut>(output, iterations);
+        });
+    }
+    RegisterBenchmark("Output::Pulse/Gate", [](unsigned long iterations) {
+        Output output(1, OutputType::DigitalOut);
+        RunPulse<OutputType::DigitalOut>(output, iterations);
+    });
+    RegisterBenchmark("Output::Pulse/GateSwingProbability", [](unsigned long iterations) {
+        Output output(1, OutputType::DigitalOut);
+        output.SetSwingAmount(3);
+        output.SetPulseProbability(50);
+        RunPulse<OutputType::DigitalOut>(output, iterations);
+    });
+    RegisterBenchmark("Output::Pulse/Euclidean", [](unsigned long iterations) {
+        Output output(1, OutputType::DigitalOut);
+        output.SetEuclideanParams({true, 16, 5, 2, 0});
+        output.SetEuclidean(true);
+        RunPulse<OutputType::DigitalOut>(output, iterations);
+    });
+    return true;
+}();
+
+// Full timer ISR tick of a clock engine, scaling with the amount of outputs (4 is the module)
+template <int Size>
+static void RunEngine(unsigned long iterations) {
+    static ClockEngine<Size, PPQN> engine;
+    for (int i = Size / 2; i < Size; i++) {
+        engine.outputs[i].SetWaveformType(static_cast<WaveformType>(1 + i % 4)); // Mix of periodic waves
+    }
+    for (unsigned long tick = 0; tick < iterations; tick++) {
+        engine.Tick();
+        benchMicros += TICK_US;
+    }
+    DoNotOptimize(engine.GetTickCounter());
+}
+
+BENCHMARK("ClockEngine::Tick/4") { RunEngine<4>(iterations); }
+BENCHMARK("ClockEngine::Tick/8") { RunEngine<8>(iterations); }
+BENCHMARK("ClockEngine::Tick/16") { RunEngine<16>(iterations); }
+BENCHMARK("ClockEngine::Tick/64") { RunEngine<64>(iterations); }
+
+// Triggered envelopes are generated from the main loop, gate toggled every 200 ticks
+static bool envelopeBenchmarks = [] {
+    const WaveformType envelopes[] = {ADEnvelope, AREnvelope, ADSREnvelope};
+    for (WaveformType type : envelopes) {
+        std::string name = "Output::GenEnvelope/" + WaveformName(type);
+        RegisterBenchmark(name, [type](unsigned long iterations) {
+            Output output(3, OutputType::DACOut);
+            output.SetWaveformType(type);
+            output.SetCurve(0.8f);
+            for (unsigned long tick = 0; tick < iterations; tick++) {
+                output.SetExternalTrigger(tick % 400 < 200);
+                output.GenEnvelope();
+                benchMicros += TICK_US;
+                DoNotOptimize(output.GetOutputLevel<OutputType::DACOut>());
+            }
+        });
+    }
+    return true;
+}();
+
+BENCHMARK("Output::ApplyCurve") {
+    float input = 0.0f;
+    for (unsigned long i = 0; i < iterations; i++) {
+        DoNotOptimize(Output::ApplyCurve(input, 0.8f));
+        input += 0.001f;
+        if (input > 1.0f) {
+            input = 0.0f;
+        }
+    }
+}
+
+BENCHMARK("GeneratePattern/16-5") {
+    int rhythm[EUCLIDEAN_STEPS];
+    EuclideanParams params = {true, 16, 5, 2, 0};
+    for (unsigned long i = 0; i < iterations; i++) {
+        GeneratePattern(params, rhythm);
+        DoNotOptimize(rhythm[0]);
+    }
+}
+
+BENCHMARK("GeneratePattern/64-23") {
+    int rhythm[EUCLIDEAN_STEPS];
+    EuclideanParams params = {true, 64, 23, 7, 0};
+    for (unsigned long i = 0; i < iterations; i++) {
+        GeneratePattern(params, rhythm);
+        DoNotOptimize(rhythm[0]);
+    }
+}
+
+// Text of a settings menu: header and six labelled description lines
+static const char *const menuLines[] = {"CV 1: ", "CV 2: ", "OUT 1: ", "OUT 2: ", "OUT 3 WAV:", "OUT 4 WAV:"};
+
+BENCHMARK("Frame/MenuText/GFX") {
+    static Canvas display;
+    for (unsigned long n = 0; n < iterations; n++) {
+        display.clearDisplay();
+        display.setTextColor(WHITE);
+        display.setCursor(16, 1);
+        display.print("- " + String("CV INPUT TARGETS") + " -");
+        for (int i = 0; i < 6; i++) {
+            display.setCursor(10, 20 + i * 7);
+            display.print(menuLines[i]);
+            display.print(WaveformTypeDescriptions[i]);
+        }
+        DoNotOptimize(display.getBuffer()[0]);
+    }
+}
+
+BENCHMARK("Frame/MenuText/Glyphs") {
+    static Canvas display;
+    static LabelCache<16, 1024> labels;
+    uint8_t *buffer = display.getBuffer();
+    for (unsigned long n = 0; n < iterations; n++) {
+        display.clearDisplay();
+        int x = 16 + BlitText(buffer, Canvas::WIDTH, Canvas::HEIGHT, 16, 1, "- ", true, true);
+        int count = 0;
+        const uint8_t *columns = labels.Get("CV INPUT TARGETS", count);
+        BlitGlyphs(buffer, Canvas::WIDTH, Canvas::HEIGHT, x, 1, columns, count, true, true);
+        BlitText(buffer, Canvas::WIDTH, Canvas::HEIGHT, x + count, 1, " -", true, true);
+        for (int i = 0; i < 6; i++) {
+            x = 10 + BlitText(buffer, Canvas::WIDTH, Canvas::HEIGHT, 10, 20 + i * 7, menuLines[i], true, true);
+            columns = labels.Get(WaveformTypeDescriptions[i].c_str(), count);
+            BlitGlyphs(buffer, Canvas::WIDTH, Canvas::HEIGHT, x, 20 + i * 7, columns, count, true, true);
+        }
+        DoNotOptimize(buffer[0]);
+    }
+}
@@ -0,0 +1,98 @@
+// ForgeView kernels: spectrum analysis and frame rendering
+#include "../../firmware-SCP/lib/spectrum.cpp"
+
+#include "bench.hpp"
+#include "canvas.hpp"
+
+// Test signal: two sines plus a square, scaled as the spectrum mode samples the ADC
+static void FillSamples(char data[], char im[], unsigned long seed) {
+    for (int i = 0; i < SPECTRUM_SAMPLES; i++) {
+        float t = (i + seed) / float(SPECTRUM_SAMPLES);
+        float value = 60 * sin(2 * PI * 5 * t) + 30 * sin(2 * PI * 23 * t) + ((i / 8) % 2 ? 20 : -20);
+        data[i] = value;
+        im[i] = 0;
+    }
+}
+
+BENCHMARK("ComputeSpectrum") {
+    char samples[SPECTRUM_SAMPLES], data[SPECTRUM_SAMPLES], im[SPECTRUM_SAMPLES], zeros[SPECTRUM_SAMPLES];
+    int levels[SPECTRUM_BINS];
+    FillSamples(samples, zeros, 0);
+    for (unsigned long i = 0; i < iterations; i++) {
+        memcpy(data, samples, sizeof(data));
+        memcpy(im, zeros, sizeof(im));
+        ComputeSpectrum(data, im, levels);
+        DoNotOptimize(levels[0]);
+    }
+}
+
+// Same draw calls as the ForgeView grid
+static void DrawGrid(Canvas &display) {
+    for (int x = 0; x <= 128; x += 16) {
+        for (int i = 0; i < 64; i += 4) {
+            display.drawPixel(x == 128 ? 127 : x, i, WHITE);
+        }
+    }
+    for (int y = 0; y <= 64; y += 16) {
+        for (int i = 0; i < 128; i += 4) {
+            display.drawPixel(i, y == 64 ? 63 : y, WHITE);
+        }
+    }
+}
+
+// Dual trace scope frame with the parameter overlay
+BENCHMARK("Frame/Scope") {
+    static Canvas display;
+    char cv[2][128];
+    for (int i = 0; i < 128; i++) {
+        cv[0][i] = 32 + 24 * sin(i / 8.0);
+        cv[1][i] = 16 + 12 * sin(i / 3.0);
+    }
+    for (unsigned long n = 0; n < iterations; n++) {
+        display.clearDisplay();
+        for (int k = 0; k < 2; k++) {
+            for (int i = 126; i >= 0; i--) {
+                display.drawLine(127 - i, 63 - cv[k][i] - k * 28, 127 - (i + 1), 63 - cv[k][i + 1] - k * 28, WHITE);
+            }
+        }
+        DrawGrid(display);
+        display.fillRect(30, 8, 68, 44, BLACK);
+        display.drawLine(30, 8, 98, 8, WHITE);
+        display.drawLine(30, 8, 30, 52, WHITE);
+        display.drawLine(30, 52, 98, 52, WHITE);
+        display.drawLine(98, 8, 98, 52, WHITE);
+        display.setTextColor(WHITE);
+        display.setCursor(34, 12);
+        display.print("Mode: " + String(1));
+        display.setTextColor(BLACK, WHITE);
+        display.setCursor(34, 22);
+        display.print("Hori: " + String(2));
+        display.setTextColor(WHITE);
+        display.setCursor(34, 32);
+        display.print("Offs: " + String(1));
+        display.setCursor(34, 42);
+        display.print("Vert: " + String(1.0f, 2));
+        DoNotOptimize(display.getBuffer()[0]);
+    }
+}
+
+// Spectrum mode frame, FFT included
+BENCHMARK("Frame/Spectrum") {
+    static Canvas display;
+    char samples[SPECTRUM_SAMPLES], data[SPECTRUM_SAMPLES], im[SPECTRUM_SAMPLES], zeros[SPECTRUM_SAMPLES];
+    int levels[SPECTRUM_BINS];
+    FillSamples(samples, zeros, 0);
+    for (unsigned long n = 0; n < iterations; n++) {
+        memcpy(data, samples, sizeof(data));
+        memcpy(im, zeros, sizeof(im));
+        ComputeSpectrum(data, im, levels);
+        display.clearDisplay();
+        for (int i = 0; i < SPECTRUM_BINS; i++) {
+            int level = levels[i] + i / 8;
+            if (levels[i] >= 3) {
+                display.fillRect(i * 2, 63 - level, 2, level, WHITE);
+            }
+        }
+        DoNotOptimize(display.getBuffer()[0]);
+    }
+}
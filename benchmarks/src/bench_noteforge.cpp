@@ -0,0 +1,39 @@
+// NoteForge kernels: scale and quantizer table setup and the per sample quantization
+#include "../../firmware-DQ/lib/quantizer.cpp"
+#include "../../firmware-DQ/lib/scales.cpp"
+
+#include "bench.hpp"
+
+BENCHMARK("BuildScale") {
+    bool note[12];
+    for (unsigned long i = 0; i < iterations; i++) {
+        BuildScale(i % numScales, i % 12, note);
+        DoNotOptimize(note[0]);
+    }
+}
+
+BENCHMARK("BuildQuantBuffer") {
+    bool note[12];
+    int buff[62];
+    BuildScale(1, 0, note);
+    for (unsigned long i = 0; i < iterations; i++) {
+        BuildQuantBuffer(note, buff);
+        DoNotOptimize(buff[0]);
+    }
+}
+
+// Sweep the whole ADC range so every search length is covered
+BENCHMARK("QuantizeCV") {
+    bool note[12];
+    int buff[64] = {0}; // QuantizeCV reads up to two entries past the 62 entries table
+    float out = 0;
+    BuildScale(1, 0, note);
+    BuildQuantBuffer(note, buff);
+    float cv = 0;
+    for (unsigned long i = 0; i < iterations; i++) {
+        float next = (i * 97) % 4096;
+        QuantizeCV(next, cv, buff, 4, 3, &out);
+        cv = next;
+        DoNotOptimize(out);
+    }
+}
@@ -0,0 +1,109 @@
+#pragma once
+#include <Arduino.h>
+
+#include "glyphs.hpp"
+
+#define WHITE 1
+#define BLACK 0
+
+// 128x64 monochrome frame buffer with the SSD1306 page layout and the Adafruit GFX drawing
+// algorithms (Bresenham lines, per pixel writes, 5x7 font in 6x8 cells) used by the modules.
+// Adafruit GFX pulls the Wire/SPI bus drivers so it can't be built natively, this keeps the
+// per pixel cost of a frame representative.
+class Canvas {
+  public:
+    static const int WIDTH = 128;
+    static const int HEIGHT = 64;
+
+    void clearDisplay() { memset(_buffer, 0, sizeof(_buffer)); }
+    const uint8_t *getBuffer() const { return _buffer; }
+    uint8_t *getBuffer() { return _buffer; }
+
+    void drawPixel(int x, int y, int color) {
+        if (x < 0 || y < 0 || x >= WIDTH || y >= HEIGHT) {
+            return;
+        }
+        if (color) {
+            _buffer[x + (y / 8) * WIDTH] |= (1 << (y & 7));
+        } else {
+            _buffer[x + (y / 8) * WIDTH] &= ~(1 << (y & 7));
+        }
+    }
+
+    void drawLine(int x0, int y0, int x1, int y1, int color) {
+        bool steep = abs(y1 - y0) > abs(x1 - x0);
+        if (steep) {
+            std::swap(x0, y0);
+            std::swap(x1, y1);
+        }
+        if (x0 > x1) {
+            std::swap(x0, x1);
+            std::swap(y0, y1);
+        }
+        int dx = x1 - x0;
+        int dy = abs(y1 - y0);
+        int err = dx / 2;
+        int ystep = y0 < y1 ? 1 : -1;
+        for (; x0 <= x1; x0++) {
+            if (steep) {
+                drawPixel(y0, x0, color);
+            } else {
+                drawPixel(x0, y0, color);
+            }
+            err -= dy;
+            if (err < 0) {
+                y0 += ystep;
+                err += dx;
+            }
+        }
+    }
+
+    void drawFastVLine(int x, int y, int h, int color) { drawLine(x, y, x, y + h - 1, color); }
+    void drawFastHLine(int x, int y, int w, int color) { drawLine(x, y, x + w - 1, y, color); }
+
+    void fillRect(int x, int y, int w, int h, int color) {
+        for (int i = x; i < x + w; i++) {
+            drawFastVLine(i, y, h, color);
+        }
+    }
+
+    void setCursor(int x, int y) {
+        _cursorX = x;
+        _cursorY = y;
+    }
+    void setTextColor(int color) { _textColor = _textBackground = color; }
+    void setTextColor(int color, int background) {
+        _textColor = color;
+        _textBackground = background;
+    }
+
+    void print(const String &text) {
+        for (unsigned int i = 0; i < text.length(); i++) {
+            drawChar(_cursorX, _cursorY, text[i]);
+            _cursorX += 6;
+        }
+    }
+
+  private:
+    uint8_t _buffer[WIDTH * HEIGHT / 8];
+    int _cursorX = 0;
+    int _cursorY = 0;
+    int _textColor = WHITE;
+    int _textBackground = WHITE;
+
+    void drawChar(int x, int y, char c) {
+        for (int i = 0; i < 5; i++) {
+            uint8_t line = pgm_read_byte(&GlyphFont[(HasGlyph(c) ? c : '?') - GLYPH_FIRST][i]);
+            for (int j = 0; j < 8; j++, line >>= 1) {
+                if (line & 1) {
+                    drawPixel(x + i, y + j, _textColor);
+                } else if (_textBackground != _textColor) {
+                    drawPixel(x + i, y + j, _textBackground);
+                }
+            }
+        }
+        if (_textBackground != _textColor) {
+            drawFastVLine(x + 5, y, 8, _textBackground);
+        }
+    }
+};
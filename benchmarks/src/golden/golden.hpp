@@ -0,0 +1,164 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "trace.hpp"
+
+// Golden output scenarios
+//
+// A scenario runs firmware code tick by tick with virtual time and a fixed seed, and records every
+// output change as a trace event with the tick as time. The runs are compared with the golden files
+// checked in under benchmarks/golden, the first tick where they differ is reported.
+//
+// Golden file: "FGLD", version, varint ticks, varint channels, then per event varint tick delta,
+// channel byte and zigzag varint value delta to the previous value of the channel.
+
+#define GOLDEN_VERSION 1
+
+struct GoldenRun {
+    unsigned long ticks = 0;
+    unsigned long tickMicros = 0; // Tick length at the scenario tempo, for the VCD export
+    std::vector<TraceChannel> channels;
+    std::vector<TraceEvent> events; // In recording order, time is the tick
+    bool overflow = false;          // More events than the recorder holds, the run is incomplete
+    std::string error;              // The scenario couldn't run, as a missing recording
+};
+
+typedef std::function<void(GoldenRun &run)> ScenarioFunction;
+
+struct Scenario {
+    std::string name; // Also the golden file path, "<firmware>/<group>-<variant>"
+    ScenarioFunction run;
+};
+
+inline std::vector<Scenario> &Scenarios() {
+    static std::vector<Scenario> scenarios;
+    return scenarios;
+}
+
+inline bool RegisterScenario(const std::string &name, ScenarioFunction run) {
+    Scenarios().push_back({name, run});
+    return true;
+}
+
+// Copy the events of a recorder into a run
+template <int Size>
+void CollectEvents(const TraceRecorder<Size> &trace, GoldenRun &run) {
+    run.events.clear();
+    for (int i = 0; i < trace.GetCount(); i++) {
+        run.events.push_back(trace.Get(i));
+    }
+    run.overflow = trace.GetOverwritten() > 0;
+}
+
+inline void PutVarint(std::vector<uint8_t> &out, uint32_t value) {
+    while (value >= 0x80) {
+        out.push_back(value | 0x80);
+        value >>= 7;
+    }
+    out.push_back(value);
+}
+
+inline bool GetVarint(const std::vector<uint8_t> &in, size_t &pos, uint32_t &value) {
+    value = 0;
+    for (int shift = 0; shift < 35; shift += 7) {
+        if (pos >= in.size()) {
+            return false;
+        }
+        uint8_t byte = in[pos++];
+        value |= uint32_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+inline std::vector<uint8_t> EncodeGolden(const GoldenRun &run) {
+    std::vector<uint8_t> out = {'F', 'G', 'L', 'D', GOLDEN_VERSION};
+    PutVarint(out, run.ticks);
+    PutVarint(out, run.channels.size());
+    uint32_t time = 0;
+    std::vector<int> last(run.channels.size(), 0);
+    for (const TraceEvent &event : run.events) {
+        int delta = event.value - last[event.channel];
+        last[event.channel] = event.value;
+        PutVarint(out, event.time - time);
+        out.push_back(event.channel);
+        PutVarint(out, delta < 0 ? ~(uint32_t(delta) << 1) : uint32_t(delta) << 1);
+        time = event.time;
+    }
+    return out;
+}
+
+// Decode a golden file into the ticks and events of run, false if it is corrupted
+inline bool DecodeGolden(const std::vector<uint8_t> &in, GoldenRun &run) {
+    size_t pos = 5;
+    uint32_t ticks, channels;
+    if (in.size() < pos || in[0] != 'F' || in[1] != 'G' || in[2] != 'L' || in[3] != 'D' || in[4] != GOLDEN_VERSION ||
+        !GetVarint(in, pos, ticks) || !GetVarint(in, pos, channels) || channels > TRACE_CHANNELS) {
+        return false;
+    }
+    run.ticks = ticks;
+    run.events.clear();
+    uint32_t time = 0;
+    std::vector<int> last(channels, 0);
+    while (pos < in.size()) {
+        uint32_t delta, zigzag;
+        if (!GetVarint(in, pos, delta) || pos >= in.size()) {
+            return false;
+        }
+        uint8_t channel = in[pos++];
+        if (channel >= channels || !GetVarint(in, pos, zigzag)) {
+            return false;
+        }
+        time += delta;
+        last[channel] += zigzag & 1 ? ~int(zigzag >> 1) : int(zigzag >> 1);
+        run.events.push_back({time, uint16_t(last[channel]), channel});
+    }
+    return true;
+}
+
+struct GoldenDiff {
+    long tick; // First divergent tick, -1 when the runs match
+    int channel;
+    int expected;
+    int actual;
+};
+
+// Find the first tick where the outputs of two runs differ. The events are the changes in a fixed
+// order, so the runs match as long as their events do.
+inline GoldenDiff CompareGolden(const GoldenRun &expected, const GoldenRun &actual) {
+    std::vector<int> values(TRACE_CHANNELS, 0);
+    const std::vector<TraceEvent> &a = expected.events;
+    const std::vector<TraceEvent> &b = actual.events;
+    size_t i = 0;
+    for (; i < a.size() && i < b.size(); i++) {
+        if (a[i].time != b[i].time || a[i].channel != b[i].channel || a[i].value != b[i].value) {
+            break;
+        }
+        values[a[i].channel] = a[i].value;
+    }
+    if (i == a.size() && i == b.size()) {
+        if (expected.ticks != actual.ticks) {
+            return {long(std::min(expected.ticks, actual.ticks)), -1, 0, 0};
+        }
+        return {-1, -1, 0, 0};
+    }
+
+    // Earliest of the two differing events, then the value of its channel at that tick in each run
+    const TraceEvent *first = i == b.size() || (i < a.size() && (a[i].time < b[i].time || (a[i].time == b[i].time && a[i].channel <= b[i].channel))) ? &a[i] : &b[i];
+    auto valueAt = [&](const std::vector<TraceEvent> &events) {
+        int value = values[first->channel];
+        for (size_t j = i; j < events.size() && events[j].time <= first->time; j++) {
+            if (events[j].channel == first->channel) {
+                value = events[j].value;
+            }
+        }
+        return value;
+    };
+    return {long(first->time), first->channel, valueAt(a), valueAt(b)};
+}
@@ -0,0 +1,475 @@
+// ClockForge scenarios: the clock engine of the module (2 gate and 2 DAC outputs) run tick by tick
+#include "../../../firmware-CLK/src/engine.hpp"
+#include "../../../firmware-CLK/src/outputs.hpp"
+
+#include "cvreplay.hpp"
+#include "cvtarget.hpp"
+
+#include "golden.hpp"
+
+#define PPQN 192
+#define GOLDEN_SEED 0x5EED
+#define GOLDEN_EVENTS (1 << 17)
+
+extern unsigned long benchMicros;
+
+typedef ClockEngine<4, PPQN, 2> ModuleEngine;
+
+static const TraceChannel channels[] = {{"out1", 1}, {"out2", 1}, {"out3", 12}, {"out4", 12}};
+
+struct ClockScenario {
+    unsigned int bpm = 120;
+    unsigned long quarters = 8;
+    std::function<void(ModuleEngine &)> setup;
+    std::function<void(ModuleEngine &, unsigned long tick)> beforeTick; // Triggers and transport, optional
+};
+
+// Timer ISR tick then the outputs task of the loop, which runs once per tick here
+static void RunClock(const ClockScenario &scenario, GoldenRun &run) {
+    static TraceRecorder<GOLDEN_EVENTS> trace;
+    ModuleEngine engine;
+    for (int i = 0; i < ModuleEngine::OutputCount; i++) {
+        engine.outputs[i].SeedRandom(GOLDEN_SEED + i);
+    }
+    scenario.setup(engine);
+
+    trace.Clear();
+    benchMicros = 0;
+    run.ticks = scenario.quarters * PPQN;
+    run.tickMicros = 60L * 1000 * 1000 / scenario.bpm / PPQN / 4; // As UpdateBPM()
+    run.channels.assign(channels, channels + 4);
+    for (unsigned long tick = 0; tick < run.ticks; tick++) {
+        if (scenario.beforeTick) {
+            scenario.beforeTick(engine, tick);
+        }
+        engine.Tick();
+        engine.WriteOutputs(
+            [tick](uint32_t gates) {
+                for (int i = 0; i < ModuleEngine::GateCount; i++) {
+                    trace.Record(tick, i, (gates >> i) & 1);
+                }
+            },
+            [tick](int i, int level) { trace.Record(tick, i, level); });
+        benchMicros += run.tickMicros;
+    }
+    CollectEvents(trace, run);
+}
+
+// Waveforms of the DAC outputs, set before the other parameters as it resets the divider
+static void SetWaveforms(ModuleEngine &engine, WaveformType out3, WaveformType out4) {
+    engine.outputs[2].SetWaveformType(out3);
+    engine.outputs[3].SetWaveformType(out4);
+}
+
+template <typename Setter>
+static void SetAll(ModuleEngine &engine, Setter set) {
+    for (Output &output : engine.outputs) {
+        set(output);
+    }
+}
+
+// File name friendly description: "/1.5" -> "d1.5", "AD Env" -> "ADEnv", "S&H" -> "SnH"
+static std::string Name(const String &description) {
+    std::string name;
+    for (char c : std::string(description.c_str())) {
+        if (c == '/') {
+            name += 'd';
+        } else if (c == '&') {
+            name += 'n';
+        } else if (c != ' ') {
+            name += c;
+        }
+    }
+    return name;
+}
+
+static void Add(const std::string &name, const ClockScenario &scenario) {
+    RegisterScenario("clockforge/" + name, [scenario](GoldenRun &run) { RunClock(scenario, run); });
+}
+
+static bool clockScenarios = [] {
+    Output reference(1, OutputType::DACOut);
+
+    // Every divider, two periods of the slow ones
+    for (int divider = 0; divider < Output::DividerAmount; divider++) {
+        reference.SetDivider(divider);
+        String description = reference.GetDividerDescription();
+        ClockScenario scenario;
+        scenario.quarters = description.c_str()[0] == '/' ? std::max(8.0, 2 * ceil(atof(description.c_str() + 1))) : 8;
+        scenario.setup = [divider](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Square, divider <= 3 ? WaveformType::Square : WaveformType::Triangle);
+            SetAll(engine, [divider](Output &output) { output.SetDivider(divider); });
+        };
+        Add("divider-" + Name(description), scenario);
+    }
+
+    // Custom ratios whose periods aren't whole ticks, over a full cycle of the master
+    const int ratios[][2] = {{5, 7}, {7, 5}, {3, 8}, {64, 63}};
+    for (const auto &ratio : ratios) {
+        ClockScenario scenario;
+        scenario.quarters = std::max(8, ratio[1]);
+        scenario.setup = [ratio](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Square, WaveformType::Sawtooth);
+            SetAll(engine, [ratio](Output &output) { output.SetRatio(ratio[0], ratio[1]); });
+            engine.outputs[1].SetDutyCycle(25);
+        };
+        Add("ratio-" + std::to_string(ratio[0]) + "-" + std::to_string(ratio[1]), scenario);
+    }
+
+    for (int duty : {1, 10, 25, 50, 75, 90, 99}) {
+        ClockScenario scenario;
+        scenario.setup = [duty](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Triangle, WaveformType::Square);
+            SetAll(engine, [duty](Output &output) {
+                output.SetDivider(11); // x2
+                output.SetDutyCycle(duty);
+            });
+        };
+        Add("duty-" + std::to_string(duty), scenario);
+    }
+
+    // Swing of the 1/16ths, the pattern repeats every "every" periods. A wave on out4 for the usual every 2.
+    for (int amount = 0; amount < Output::SwingAmount; amount++) {
+        for (int every : {1, 2, 3, 4, 16}) {
+            if (amount == 0 && every != 2) {
+                continue;
+            }
+            ClockScenario scenario;
+            scenario.quarters = every == 16 ? 8 : 4;
+            scenario.setup = [amount, every](ModuleEngine &engine) {
+                SetWaveforms(engine, WaveformType::Square, every == 2 ? WaveformType::Sine : WaveformType::Square);
+                SetAll(engine, [amount, every](Output &output) {
+                    output.SetDivider(13); // x4
+                    output.SetSwingAmount(amount);
+                    output.SetSwingEvery(every);
+                });
+            };
+            Add("swing-" + std::to_string(amount) + "-" + std::to_string(every), scenario);
+        }
+    }
+
+    // Groove templates on the 1/16ths: each MPC swing, and a user groove of 6 steps against the 4 of a beat
+    for (int groove = 1; groove < Output::GrooveAmount; groove++) {
+        ClockScenario scenario;
+        scenario.setup = [groove](ModuleEngine &engine) {
+            const uint8_t offsets[] = {0, 8, 4, 0, 16, 2};
+            GrooveTable user = UserGroove(offsets, sizeof(offsets));
+            Output::SetUserGroove(user);
+            SetWaveforms(engine, WaveformType::Square, WaveformType::Triangle);
+            SetAll(engine, [groove](Output &output) {
+                output.SetDivider(13); // x4
+                output.SetGroove(groove);
+            });
+        };
+        Add(groove <= MPCSwingAmount ? "groove-mpc-" + std::to_string(MPCSwings[groove - 1]) : "groove-user", scenario);
+    }
+
+    // User groove offsets longer than the 1/16th are limited to one tick less than it
+    ClockScenario longGroove;
+    longGroove.setup = [](ModuleEngine &engine) {
+        const uint8_t offsets[] = {0, 100, 255, 30};
+        Output::SetUserGroove(UserGroove(offsets, sizeof(offsets)));
+        SetWaveforms(engine, WaveformType::Square, WaveformType::Sawtooth);
+        SetAll(engine, [](Output &output) {
+            output.SetDivider(13); // x4
+            output.SetGroove(Output::GrooveAmount - 1);
+        });
+    };
+    Add("groove-user-long", longGroove);
+
+    for (int phase : {0, 10, 25, 33, 50, 75, 99, 100}) {
+        ClockScenario scenario;
+        scenario.setup = [phase](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Square, WaveformType::Sawtooth);
+            SetAll(engine, [phase](Output &output) {
+                output.SetDivider(7); // /2
+                output.SetPhase(phase);
+            });
+            engine.outputs[0].SetPhase(0); // Reference
+        };
+        Add("phase-" + std::to_string(phase), scenario);
+    }
+
+    const EuclideanParams euclidean[] = {{true, 16, 5, 2, 0}, {true, 8, 3, 0, 0}, {true, 10, 6, 1, 0}, {true, 13, 7, 3, 3},
+                                         {true, 64, 17, 5, 0}, {true, 1, 1, 0, 0}, {true, 5, 5, 0, 3}, {true, 12, 1, 11, 4}};
+    for (const EuclideanParams &params : euclidean) {
+        ClockScenario scenario;
+        scenario.quarters = 32;
+        scenario.setup = [params](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Square, WaveformType::SampleHold);
+            SetAll(engine, [params](Output &output) {
+                output.SetDivider(13); // x4
+                output.SetEuclideanParams(params);
+                output.SetEuclidean(true);
+            });
+        };
+        Add("euclidean-" + std::to_string(params.steps) + "-" + std::to_string(params.triggers) + "-" + std::to_string(params.rotation) + "-" + std::to_string(params.pad), scenario);
+    }
+
+    for (int probability : {0, 25, 50, 75, 100}) {
+        ClockScenario scenario;
+        scenario.setup = [probability](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Square, WaveformType::Noise);
+            SetAll(engine, [probability](Output &output) {
+                output.SetDivider(13); // x4
+                output.SetPulseProbability(probability);
+            });
+        };
+        Add("probability-" + std::to_string(probability), scenario);
+    }
+
+    // Clocked waveforms, out3 at x1 and out4 at /2
+    for (int type = WaveformType::Square; type <= WaveformType::SampleHold; type++) {
+        ClockScenario scenario;
+        scenario.setup = [type](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType(type), WaveformType(type));
+            engine.outputs[3].SetDivider(7);
+        };
+        Add("waveform-" + Name(WaveformTypeDescriptions[type]), scenario);
+    }
+
+    // Triggered envelopes depend on the time, not the ticks: each at several tempos. out3 is
+    // triggered for a quarter every 4 quarters, out4 for 3 quarters every 8 with a retrigger.
+    for (int type = WaveformType::ADEnvelope; type <= WaveformType::ADSREnvelope; type++) {
+        for (unsigned int bpm : {40, 120, 300}) {
+            ClockScenario scenario;
+            scenario.bpm = bpm;
+            scenario.quarters = 16;
+            scenario.setup = [type](ModuleEngine &engine) {
+                SetWaveforms(engine, WaveformType(type), WaveformType(type));
+                EnvelopeParams params = engine.outputs[3].GetEnvelopeParams();
+                params.retrigger = true;
+                engine.outputs[3].SetEnvelopeParams(params);
+            };
+            scenario.beforeTick = [](ModuleEngine &engine, unsigned long tick) {
+                engine.outputs[2].SetExternalTrigger(tick % (4 * PPQN) < PPQN);
+                engine.outputs[3].SetExternalTrigger(tick % (8 * PPQN) < 3 * PPQN && tick % (8 * PPQN) != 2 * PPQN);
+            };
+            Add("envelope-" + Name(WaveformTypeDescriptions[type]) + "-" + std::to_string(bpm), scenario);
+        }
+    }
+
+    // Waveform types past the table, as a full scale CV used to set, are clamped to the last envelope
+    ClockScenario range;
+    range.quarters = 8;
+    range.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType(WaveformTypeLength), WaveformType(WaveformTypeLength + 100));
+    };
+    range.beforeTick = [](ModuleEngine &engine, unsigned long tick) {
+        engine.outputs[2].SetExternalTrigger(tick % (4 * PPQN) < PPQN);
+        engine.outputs[3].SetExternalTrigger(tick % (2 * PPQN) < PPQN);
+    };
+    Add("waveform-range", range);
+
+    ClockScenario levels;
+    levels.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType::Triangle, WaveformType::Square);
+        engine.outputs[2].SetLevel(50);
+        engine.outputs[2].SetOffset(25);
+        engine.outputs[3].SetLevel(80);
+        engine.outputs[3].SetOffset(30);
+    };
+    Add("levels", levels);
+
+    // Mixed settings at the tempo limits
+    for (unsigned int bpm : {10, 120, 300}) {
+        ClockScenario scenario;
+        scenario.bpm = bpm;
+        scenario.setup = [](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Sine, WaveformType::SmoothNoise);
+            engine.outputs[0].SetDivider(12); // x3
+            engine.outputs[0].SetSwingAmount(3);
+            engine.outputs[1].SetDivider(8); // /1.5
+            engine.outputs[1].SetDutyCycle(20);
+            engine.outputs[2].SetDivider(10); // x1.5
+            engine.outputs[2].SetPhase(25);
+            engine.outputs[3].SetDivider(11); // x2
+        };
+        Add("bpm-" + std::to_string(bpm), scenario);
+    }
+
+    // Master stop and start, an output switched off and on
+    ClockScenario transport;
+    transport.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType::Triangle, WaveformType::Square);
+        SetAll(engine, [](Output &output) { output.SetDivider(11); });
+    };
+    transport.beforeTick = [](ModuleEngine &engine, unsigned long tick) {
+        if (tick == 700 || tick == 1100) {
+            engine.SetMasterState(tick == 1100);
+        }
+        if (tick == 300 || tick == 500) {
+            engine.outputs[1].SetOutputState(tick == 500);
+        }
+    };
+    Add("transport", transport);
+
+    // Transport commands quantized by the clock ISR: stop posted mid bar, start on the next beat,
+    // then a reset restarting the Euclidean steps and the waveforms mid beat
+    ClockScenario quantized;
+    quantized.quarters = 12;
+    quantized.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType::Sawtooth, WaveformType::Triangle);
+        engine.outputs[0].SetDivider(13); // x4
+        engine.outputs[0].SetEuclideanParams({true, 5, 3, 0, 0});
+        engine.outputs[0].SetEuclidean(true);
+        engine.outputs[1].SetDivider(11); // x2
+    };
+    quantized.beforeTick = [](ModuleEngine &engine, unsigned long tick) {
+        if (tick == 300) {
+            engine.PostMasterState(false, TransportBar);
+        } else if (tick == 1000) {
+            engine.PostMasterState(true, TransportBeat);
+        } else if (tick == 1500) {
+            engine.PostReset(TransportTick);
+        }
+    };
+    Add("transport-quantized", quantized);
+
+    // Bar synced stop and start under an external clock, one divided pulse per beat. The pulses come
+    // before (150 ticks) or after (250 ticks) the internal timer reaches a beat, the bars count pulses
+    // either way: the stop applies on the 5th pulse and the start on the 9th.
+    for (unsigned long pulse : {150, 250}) {
+        ClockScenario scenario;
+        scenario.quarters = 12;
+        scenario.setup = [](ModuleEngine &engine) {
+            SetWaveforms(engine, WaveformType::Sawtooth, WaveformType::Square);
+            SetAll(engine, [](Output &output) { output.SetDivider(11); }); // x2
+        };
+        scenario.beforeTick = [pulse](ModuleEngine &engine, unsigned long tick) {
+            if (tick % pulse == 0) {
+                engine.ExternalClock(1);
+            }
+            if (tick == 320 || tick == 1100) {
+                engine.PostMasterState(tick == 1100, TransportBar);
+            }
+        };
+        Add("transport-external-" + std::to_string(pulse), scenario);
+    }
+    return true;
+}();
+
+// CV replay: a recording in the CSV format of forgectl.py drives the engine through the CV targets
+// of the module, at the virtual time of the ticks. The samples go through the gate detectors as
+// they come and the CV task reads the inputs every CV_TASK_MICROS. The tempo and scene targets
+// don't reach the engine, the ticks keep the scenario tempo.
+
+#define CV_TASK_MICROS 2000 // As the "cv" task of the module
+#define CV_INPUTS 2
+
+struct CVScenario {
+    std::string recording; // CSV file, from the repository root as the golden files
+    CVTarget targets[CV_INPUTS] = {CVTarget::None, CVTarget::None};
+    int attenuation[CV_INPUTS] = {0, 0};
+    int offset[CV_INPUTS] = {0, 0};
+    ClockScenario clock;
+};
+
+// The engine as the CV targets change it
+struct ReplayModule {
+    static const int GateCount = ModuleEngine::GateCount;
+    static const int MinBPM = 10;
+    static const int MaxBPM = 300;
+    static const int SceneCount = 1;
+    static const int WaveformCount = WaveformTypeLength;
+    typedef WaveformType Waveform;
+
+    ModuleEngine &engine;
+    Output (&outputs)[ModuleEngine::OutputCount];
+
+    void Transport(bool run) { engine.PostMasterState(run, TransportTick); }
+    void Reset() { engine.PostReset(TransportTick); }
+    void SetBPM(int) {}
+    void SelectScene(int) {}
+};
+
+static std::vector<TraceEvent> cvRecording;
+
+static const TraceEvent &CVRecordingSample(int index) {
+    return cvRecording[index];
+}
+
+static void RunCV(const CVScenario &scenario, GoldenRun &run) {
+    if (!LoadCVRecording(scenario.recording.c_str(), cvRecording)) {
+        run.error = "can't read " + scenario.recording;
+        return;
+    }
+    const int adcOffset = 23;      // Calibration defaults of the module
+    const float adcCal = 1.0180f;
+    GateDetector gates[CV_INPUTS];
+    float values[CV_INPUTS] = {};
+    CVTargetState states[CV_INPUTS];
+    CVPlayer player;
+    unsigned long nextTask = 0;
+
+    ClockScenario clock = scenario.clock;
+    clock.beforeTick = [&](ModuleEngine &engine, unsigned long tick) {
+        ReplayModule module = {engine, engine.outputs};
+        if (tick == 0) {
+            for (int i = 0; i < CV_INPUTS; i++) {
+                gates[i].Configure(CVGateThresholds(adcOffset, adcCal, scenario.attenuation[i], scenario.offset[i]), IsGateTarget(scenario.targets[i]));
+            }
+            player.Start(CVRecordingSample, cvRecording.size(), benchMicros);
+        }
+        player.Play(benchMicros, [&](int ch, uint16_t value) {
+            int edge = ch < CV_INPUTS ? gates[ch].Update(value) : 0;
+            if (edge != 0) {
+                CVGateApply(module, scenario.targets[ch], edge, benchMicros);
+            }
+        });
+        if (benchMicros >= nextTask) {
+            nextTask += CV_TASK_MICROS;
+            for (int i = 0; i < CV_INPUTS; i++) {
+                uint16_t raw;
+                if (player.Read(benchMicros, i, raw) && CVSmooth(values[i], CVCalibrate(raw, adcOffset, adcCal))) {
+                    float scaled = CVScale(values[i], scenario.attenuation[i], scenario.offset[i]);
+                    CVTargetApply(module, scenario.targets[i], scaled, gates[i].IsEnabled(), states[i]);
+                }
+            }
+        }
+    };
+    RunClock(clock, run);
+}
+
+static void AddCV(const std::string &name, const CVScenario &scenario) {
+    RegisterScenario("clockforge/cv-" + name, [scenario](GoldenRun &run) { RunCV(scenario, run); });
+}
+
+static bool cvScenarios = [] {
+    // Start/stop gate with slow edges and reset pulses
+    CVScenario gates;
+    gates.recording = "benchmarks/cv/gates.csv";
+    gates.targets[0] = CVTarget::StartStop;
+    gates.targets[1] = CVTarget::Reset;
+    gates.clock.quarters = 32; // The 4 s of the recording
+    gates.clock.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType::Sawtooth, WaveformType::Square);
+        engine.outputs[0].SetDivider(11); // x2
+        engine.outputs[1].SetDivider(4);  // /3
+        engine.outputs[2].SetDivider(5);  // /2
+    };
+    AddCV("gates", gates);
+
+    // The same gates triggering the envelopes
+    CVScenario envelopes = gates;
+    envelopes.targets[0] = CVTarget::Envelope1;
+    envelopes.targets[1] = CVTarget::Envelope2;
+    envelopes.clock.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType::ADSREnvelope, WaveformType::ADEnvelope);
+    };
+    AddCV("envelopes", envelopes);
+
+    // Continuous targets, attenuated and offset
+    CVScenario modulation;
+    modulation.recording = "benchmarks/cv/modulation.csv";
+    modulation.targets[0] = CVTarget::Div1;
+    modulation.targets[1] = CVTarget::Output3Level;
+    modulation.attenuation[1] = 20;
+    modulation.offset[1] = 10;
+    modulation.clock.quarters = 32;
+    modulation.clock.setup = [](ModuleEngine &engine) {
+        SetWaveforms(engine, WaveformType::Triangle, WaveformType::Square);
+    };
+    AddCV("modulation", modulation);
+    return true;
+}();
@@ -0,0 +1,154 @@
+// Golden output regression runs for the Forge firmwares
+//
+// Usage: golden [--filter TEXT] [--dir DIR] [--update] [--vcd DIR]
+//
+// Runs the scenarios and compares them with the golden files in DIR (benchmarks/golden by
+// default), reporting the first divergent tick of each differing scenario. --update rewrites the
+// golden files from the current code instead. --vcd writes the runs as VCD files for GTKWave,
+// with the golden run next to it when they differ.
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+
+#include <Arduino.h>
+
+#include "golden.hpp"
+
+unsigned long benchMicros = 0;
+NullSerial Serial;
+
+static bool ReadFile(const std::string &path, std::vector<uint8_t> &data) {
+    FILE *f = fopen(path.c_str(), "rb");
+    if (!f) {
+        return false;
+    }
+    uint8_t buffer[4096];
+    size_t length;
+    data.clear();
+    while ((length = fread(buffer, 1, sizeof(buffer), f)) > 0) {
+        data.insert(data.end(), buffer, buffer + length);
+    }
+    fclose(f);
+    return true;
+}
+
+// Create the directories of path
+static void MakeDirectories(const std::string &path) {
+    for (size_t slash = path.find('/', 1); slash != std::string::npos; slash = path.find('/', slash + 1)) {
+        mkdir(path.substr(0, slash).c_str(), 0755);
+    }
+}
+
+static bool WriteFile(const std::string &path, const std::vector<uint8_t> &data) {
+    MakeDirectories(path);
+    FILE *f = fopen(path.c_str(), "wb");
+    if (!f) {
+        return false;
+    }
+    bool ok = fwrite(data.data(), 1, data.size(), f) == data.size();
+    return fclose(f) == 0 && ok;
+}
+
+// VCD file of a run, ticks converted to us at the scenario tempo
+static bool WriteRunVCD(const std::string &path, const GoldenRun &run) {
+    MakeDirectories(path);
+    FILE *f = fopen(path.c_str(), "w");
+    if (!f) {
+        return false;
+    }
+    auto event = [&run](int i) {
+        TraceEvent e = run.events[i];
+        e.time *= run.tickMicros;
+        return e;
+    };
+    WriteVCD(event, run.events.size(), run.channels.data(), run.channels.size(), [f](const char *text) { fputs(text, f); });
+    return fclose(f) == 0;
+}
+
+int main(int argc, char **argv) {
+    const char *filter = "";
+    std::string dir = "benchmarks/golden";
+    std::string vcdDir;
+    bool update = false;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--dir") && i + 1 < argc) {
+            dir = argv[++i];
+        } else if (!strcmp(argv[i], "--vcd") && i + 1 < argc) {
+            vcdDir = argv[++i];
+        } else if (!strcmp(argv[i], "--update")) {
+            update = true;
+        } else {
+            fprintf(stderr, "Usage: %s [--filter TEXT] [--dir DIR] [--update] [--vcd DIR]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    int count = 0, failed = 0;
+    for (const Scenario &scenario : Scenarios()) {
+        if (scenario.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        count++;
+        GoldenRun run;
+        scenario.run(run);
+        if (!run.error.empty()) {
+            printf("%-40s %s\n", scenario.name.c_str(), run.error.c_str());
+            failed++;
+            continue;
+        }
+        if (run.overflow) {
+            printf("%-40s too many events, the run is incomplete\n", scenario.name.c_str());
+            failed++;
+            continue;
+        }
+        std::string path = dir + "/" + scenario.name + ".golden";
+        if (!vcdDir.empty()) {
+            WriteRunVCD(vcdDir + "/" + scenario.name + ".vcd", run);
+        }
+        if (update) {
+            if (!WriteFile(path, EncodeGolden(run))) {
+                printf("%-40s can't write %s: %s\n", scenario.name.c_str(), path.c_str(), strerror(errno));
+                failed++;
+            }
+            continue;
+        }
+
+        std::vector<uint8_t> data;
+        GoldenRun golden;
+        if (!ReadFile(path, data)) {
+            printf("%-40s missing %s\n", scenario.name.c_str(), path.c_str());
+            failed++;
+            continue;
+        }
+        if (!DecodeGolden(data, golden)) {
+            printf("%-40s corrupted %s\n", scenario.name.c_str(), path.c_str());
+            failed++;
+            continue;
+        }
+        golden.tickMicros = run.tickMicros;
+        golden.channels = run.channels;
+        GoldenDiff diff = CompareGolden(golden, run);
+        if (diff.tick < 0) {
+            continue;
+        }
+        failed++;
+        if (diff.channel < 0) {
+            printf("%-40s ran %lu ticks, golden %lu\n", scenario.name.c_str(), run.ticks, golden.ticks);
+        } else {
+            printf("%-40s differs at tick %ld (%lu us): %s is %d, golden %d\n", scenario.name.c_str(), diff.tick, diff.tick * run.tickMicros,
+                   run.channels[diff.channel].name, diff.actual, diff.expected);
+        }
+        if (!vcdDir.empty()) {
+            WriteRunVCD(vcdDir + "/" + scenario.name + ".golden.vcd", golden);
+        }
+    }
+
+    if (update) {
+        printf("%d golden files written to %s\n", count - failed, dir.c_str());
+    } else {
+        printf("%d scenarios, %d differ\n", count, failed);
+    }
+    return failed > 0 ? 1 : 0;
+}
@@ -0,0 +1,192 @@
+// Native micro-benchmarks for the hot kernels of the Forge firmwares
+//
+// Usage: bench [--filter TEXT] [--min-time MS] [--iterations N] [--json FILE] [--commit SHA]
+//
+// Reports ns/op and, where the kernel allows hardware counters (Linux perf), instructions/op.
+// Under valgrind --tool=callgrind each benchmark is dumped separately, scripts/callgrind.py
+// runs that and merges the instruction counts into the JSON results.
+#include <chrono>
+#include <cstring>
+
+#include <Arduino.h>
+
+#include "bench.hpp"
+
+#if __has_include(<valgrind/callgrind.h>)
+#include <valgrind/callgrind.h>
+#else
+#define RUNNING_ON_VALGRIND 0
+#define CALLGRIND_TOGGLE_COLLECT
+#define CALLGRIND_DUMP_STATS_AT(name)
+#endif
+
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+unsigned long benchMicros = 0;
+NullSerial Serial;
+
+// User space instruction counter, unavailable in most containers and CI runners
+class InstructionCounter {
+  public:
+    InstructionCounter() {
+#if defined(__linux__)
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.type = PERF_TYPE_HARDWARE;
+        attr.size = sizeof(attr);
+        attr.config = PERF_COUNT_HW_INSTRUCTIONS;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        _fd = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+    }
+    ~InstructionCounter() {
+#if defined(__linux__)
+        if (_fd >= 0) {
+            close(_fd);
+        }
+#endif
+    }
+    bool Available() const { return _fd >= 0; }
+    void Start() {
+#if defined(__linux__)
+        if (_fd >= 0) {
+            ioctl(_fd, PERF_EVENT_IOC_RESET, 0);
+            ioctl(_fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+#endif
+    }
+    long long Stop() {
+        long long count = 0;
+#if defined(__linux__)
+        if (_fd >= 0) {
+            ioctl(_fd, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(_fd, &count, sizeof(count)) != sizeof(count)) {
+                count = 0;
+            }
+        }
+#endif
+        return count;
+    }
+
+  private:
+    int _fd = -1;
+};
+
+struct Result {
+    std::string name;
+    unsigned long iterations;
+    double nsPerOp;
+    double instructionsPerOp; // Negative when not measured
+};
+
+static double RunTimed(const Benchmark &bench, unsigned long iterations) {
+    auto start = std::chrono::steady_clock::now();
+    bench.run(iterations);
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count();
+}
+
+// Escape a benchmark name for JSON (names are plain ASCII)
+static std::string JsonString(const std::string &text) {
+    std::string out = "\"";
+    for (char c : text) {
+        if (c == '"' || c == '\\') {
+            out += '\\';
+        }
+        out += c;
+    }
+    return out + "\"";
+}
+
+static void WriteJson(FILE *f, const std::vector<Result> &results, const char *commit) {
+    fprintf(f, "{\n  \"commit\": %s,\n  \"benchmarks\": [\n", JsonString(commit).c_str());
+    for (size_t i = 0; i < results.size(); i++) {
+        const Result &r = results[i];
+        fprintf(f, "    {\"name\": %s, \"iterations\": %lu, \"ns_per_op\": %.3f, \"instructions_per_op\": ", JsonString(r.name).c_str(), r.iterations, r.nsPerOp);
+        if (r.instructionsPerOp < 0) {
+            fprintf(f, "null}");
+        } else {
+            fprintf(f, "%.1f}", r.instructionsPerOp);
+        }
+        fprintf(f, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+    fprintf(f, "  ]\n}\n");
+}
+
+int main(int argc, char **argv) {
+    const char *filter = "";
+    const char *jsonFile = nullptr;
+    const char *commit = getenv("GITHUB_SHA") ? getenv("GITHUB_SHA") : "";
+    double minTimeNs = 200e6;
+    unsigned long fixedIterations = RUNNING_ON_VALGRIND ? 1000 : 0;
+    for (int i = 1; i < argc; i++) {
+        if (!strcmp(argv[i], "--filter") && i + 1 < argc) {
+            filter = argv[++i];
+        } else if (!strcmp(argv[i], "--json") && i + 1 < argc) {
+            jsonFile = argv[++i];
+        } else if (!strcmp(argv[i], "--commit") && i + 1 < argc) {
+            commit = argv[++i];
+        } else if (!strcmp(argv[i], "--min-time") && i + 1 < argc) {
+            minTimeNs = atof(argv[++i]) * 1e6;
+        } else if (!strcmp(argv[i], "--iterations") && i + 1 < argc) {
+            fixedIterations = strtoul(argv[++i], nullptr, 10);
+        } else {
+            fprintf(stderr, "Usage: %s [--filter TEXT] [--min-time MS] [--iterations N] [--json FILE] [--commit SHA]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    InstructionCounter counter;
+    std::vector<Result> results;
+    printf("%-40s %12s %14s %16s\n", "Benchmark", "Iterations", "ns/op", "instructions/op");
+    for (const Benchmark &bench : Benchmarks()) {
+        if (bench.name.find(filter) == std::string::npos) {
+            continue;
+        }
+        unsigned long iterations = fixedIterations;
+        if (iterations == 0) {
+            // Grow the iterations until the run is long enough to be timed reliably
+            iterations = 1;
+            double elapsed;
+            while ((elapsed = RunTimed(bench, iterations)) < minTimeNs / 10 && iterations < (1ul << 30)) {
+                iterations *= 2;
+            }
+            iterations = std::max(1.0, iterations * minTimeNs / std::max(elapsed, 1.0));
+        } else {
+            bench.run(iterations); // Warm up
+        }
+
+        CALLGRIND_TOGGLE_COLLECT;
+        counter.Start();
+        double elapsed = RunTimed(bench, iterations);
+        long long instructions = counter.Stop();
+        CALLGRIND_TOGGLE_COLLECT;
+        CALLGRIND_DUMP_STATS_AT(bench.name.c_str());
+
+        Result r = {bench.name, iterations, elapsed / iterations, counter.Available() ? double(instructions) / iterations : -1};
+        results.push_back(r);
+        if (r.instructionsPerOp < 0) {
+            printf("%-40s %12lu %14.2f %16s\n", r.name.c_str(), r.iterations, r.nsPerOp, "-");
+        } else {
+            printf("%-40s %12lu %14.2f %16.1f\n", r.name.c_str(), r.iterations, r.nsPerOp, r.instructionsPerOp);
+        }
+    }
+
+    if (jsonFile) {
+        FILE *f = fopen(jsonFile, "w");
+        if (!f) {
+            fprintf(stderr, "Can't write %s\n", jsonFile);
+            return 1;
+        }
+        WriteJson(f, results, commit);
+        fclose(f);
+    }
+    return 0;
+}
@@ -4,7 +4,10 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "fastio.hpp"
+#include "i2carbiter.hpp"
 #include "pinouts.hpp"
+#include "trace.hpp"
 
 // Add prototypes for functions defined in this file
 void InitIO();
@@ -15,9 +18,20 @@ void PWM1(int duty1);
 void PWM2(int duty2);
 void PWMWrite(int pin, int value);
 void SetPin(int pin, int value);
+void SetGates(uint32_t levels);
+void TraceGate(uint32_t time, int gate, bool level);
+void IdleSleep();
+
+// Output activity trace, channels are the SetPin() pins: gates then internal DAC and MCP DAC.
+// The DACs are recorded by the refresh timer ISR, the gates by the loop with the interrupts off.
+#define TRACE_EVENTS 512
+#define TRACE_INTERNAL_DAC NUM_GATE_OUTS
+#define TRACE_MCP_DAC (NUM_GATE_OUTS + 1)
+TraceRecorder<TRACE_EVENTS> trace;
 
 // Create the MCP4725 object
 Adafruit_MCP4725 dac;
+#define MCP4725_ADDRESS 0x60
 #define DAC_RESOLUTION (12)
 
 // Handle IO devices initialization
@@ -38,27 +52,37 @@ void InitIO() {
     for (int i = 0; i < NUM_GATE_OUTS; i++) {
         pinMode(OUT_PINS[i], OUTPUT); // Gate out
     }
+    FastGatesInit(OUT_PINS, NUM_GATE_OUTS);
+    FastDACInit(DAC_INTERNAL_PIN);
 
     // Initialize the DAC
-    if (!dac.begin(0x60)) { // 0x60 is the default I2C address for MCP4725
+    if (!dac.begin(MCP4725_ADDRESS)) {
         Serial.println("MCP4725 not found!");
         while (1)
             ;
     }
     Serial.println("MCP4725 initialized.");
-    MCP(0);                       // Set the DAC output to 0
-    InternalDAC(0);               // Set the internal DAC output to 0
-    digitalWrite(OUT_PIN_1, LOW); // Initialize the output pins to low
-    digitalWrite(OUT_PIN_2, LOW); // Initialize the output pins to low
+    MCP(0);            // Set the DAC output to 0
+    InternalDAC(0);    // Set the internal DAC output to 0
+    FastGatesWrite(0); // Initialize the output pins to low
 }
 
 // Handle DAC Outputs
 void InternalDAC(int value) {
-    analogWrite(DAC_INTERNAL_PIN, value / 4); // "/4" -> 12bit to 10bit
+    trace.Record(micros(), TRACE_INTERNAL_DAC, value);
+    FastDACWrite(value >> 2); // 12bit to 10bit
 }
 
+// Once the arbiter runs the write goes ahead of the display transfers, a newer value replaces
+// the one still waiting
 void MCP(int value) {
-    dac.setVoltage(value, false);
+    trace.Record(micros(), TRACE_MCP_DAC, value);
+    if (!i2cArbiter.Running()) {
+        dac.setVoltage(value, false);
+        return;
+    }
+    uint8_t fastWrite[2] = {uint8_t((value >> 8) & 0x0F), uint8_t(value)}; // Fast mode, no power down
+    i2cArbiter.Submit(I2CClientDAC, MCP4725_ADDRESS, fastWrite, 2, nullptr, 0, true);
 }
 
 // Write to DAC pins indexed by 0
@@ -96,10 +120,9 @@ void PWMWrite(int pin, int value) {
 void SetPin(int pin, int value) {
     switch (pin) {
     case 0: // Gate Output 1
-        digitalWrite(OUT_PINS[0], value > 0 ? LOW : HIGH);
-        break;
     case 1: // Gate Output 2
-        digitalWrite(OUT_PINS[1], value > 0 ? LOW : HIGH);
+        TraceGate(micros(), pin, value > 0);
+        FastGateWrite(pin, value <= 0); // Gate outputs are inverted by the output stage
         break;
     case 2: // Internal DAC Output
         DACWrite(0, value);
@@ -112,3 +135,27 @@ void SetPin(int pin, int value) {
         break;
     }
 }
+
+// Set all gate outputs at once, bit i high sets gate output i. The edges change together.
+void SetGates(uint32_t levels) {
+    uint32_t time = micros();
+    for (int i = 0; i < NUM_GATE_OUTS; i++) {
+        TraceGate(time, i, (levels >> i) & 1);
+    }
+    FastGatesWrite(~levels); // Gate outputs are inverted by the output stage
+}
+
+void TraceGate(uint32_t time, int gate, bool level) {
+    noInterrupts();
+    trace.Record(time, gate, level);
+    interrupts();
+}
+
+// Stop the CPU until the next interrupt (SysTick, clock timer, EIC, DMA, USB). Only the CPU clock
+// is stopped: standby would stop the timer generating the clock and the I2C DMA.
+void IdleSleep() {
+    SCB->SCR &= ~SCB_SCR_SLEEPDEEP_Msk;
+    PM->SLEEP.reg = PM_SLEEP_IDLE_CPU;
+    __DSB();
+    __WFI();
+}
@@ -0,0 +1,144 @@
+#pragma once
+#include <stdint.h>
+
+// Background conversions of the CV inputs
+//
+// analogRead() blocks for a whole averaged conversion (0.7 ms with 128 samples) and only runs when
+// the loop gets to the CV task. Here a timer event starts the conversions at CVADC_RATE per input,
+// 8 averaged samples (about 45 us) per result, and the result interrupt selects the next input.
+// Every result goes to the onSample callback inside the interrupt, and CVADC_SUM results are
+// averaged for CVADCRead() so the loop keeps the precision of the 128 sample reading without
+// waiting for it.
+// Native builds use a fake, the tests feed it with CVADCFakeConvert().
+
+#define CVADC_MAX_INPUTS 4
+#define CVADC_SUM 16    // Results averaged for CVADCRead()
+#define CVADC_RATE 4000 // Conversions per second of each input
+
+typedef void (*CVSampleHandler)(int input, uint16_t value);
+
+void CVADCInit(const int pins[], int count, CVSampleHandler onSample);
+uint16_t CVADCRead(int input); // Latest average, 12 bit
+
+struct CVADCState {
+    CVSampleHandler onSample;
+    int count;
+    volatile int input;                   // Being converted
+    uint8_t channels[CVADC_MAX_INPUTS];   // ADC input of each pin
+    uint32_t sums[CVADC_MAX_INPUTS];
+    uint8_t summed[CVADC_MAX_INPUTS];
+    volatile uint16_t averages[CVADC_MAX_INPUTS];
+};
+CVADCState cvADC;
+
+void CVADCSelect(int input);
+
+// Result of the input being converted (interrupt), the next input is selected before onSample so
+// the next timer event converts it
+void CVADCResult(uint16_t value) {
+    int input = cvADC.input;
+    cvADC.sums[input] += value;
+    if (++cvADC.summed[input] == CVADC_SUM) {
+        cvADC.averages[input] = cvADC.sums[input] / CVADC_SUM;
+        cvADC.sums[input] = 0;
+        cvADC.summed[input] = 0;
+    }
+    cvADC.input = (input + 1) % cvADC.count;
+    CVADCSelect(cvADC.input);
+    if (cvADC.onSample != nullptr) {
+        cvADC.onSample(input, value);
+    }
+}
+
+uint16_t CVADCRead(int input) {
+    return cvADC.averages[input];
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include <Arduino.h>
+#include <wiring_private.h>
+
+#define CVADC_EVENT_CHANNEL 0 // Event system channel from TC4 to the ADC
+
+// Take over the ADC, analogRead() must not be used afterwards
+void CVADCInit(const int pins[], int count, CVSampleHandler onSample) {
+    cvADC = CVADCState();
+    cvADC.count = count < CVADC_MAX_INPUTS ? count : CVADC_MAX_INPUTS;
+    cvADC.onSample = onSample;
+    for (int i = 0; i < cvADC.count; i++) {
+        pinPeripheral(pins[i], PIO_ANALOG);
+        cvADC.channels[i] = g_APinDescription[pins[i]].ulADCChannelNumber;
+    }
+
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    ADC->CTRLA.bit.ENABLE = 0;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_8 | ADC_AVGCTRL_ADJRES(3); // 12 bit average of 8
+    ADC->CTRLB.bit.RESSEL = ADC_CTRLB_RESSEL_16BIT_Val;                   // Required to average
+    ADC->CTRLB.bit.FREERUN = 0;
+    ADC->EVCTRL.reg = ADC_EVCTRL_STARTEI; // Started by the timer event
+    ADC->INTFLAG.reg = ADC_INTFLAG_RESRDY;
+    ADC->INTENSET.reg = ADC_INTENSET_RESRDY;
+    NVIC_SetPriority(ADC_IRQn, 1); // Below the clock timers, the clock ticks don't wait for it
+    NVIC_EnableIRQ(ADC_IRQn);
+    CVADCSelect(0);
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+    ADC->CTRLA.bit.ENABLE = 1;
+    while (ADC->STATUS.bit.SYNCBUSY)
+        ;
+
+    // The TC4 overflow starts a conversion through the event system, no interrupt on the way
+    PM->APBCMASK.reg |= PM_APBCMASK_EVSYS | PM_APBCMASK_TC4;
+    EVSYS->USER.reg = EVSYS_USER_CHANNEL(CVADC_EVENT_CHANNEL + 1) | EVSYS_USER_USER(EVSYS_ID_USER_ADC_START);
+    EVSYS->CHANNEL.reg = EVSYS_CHANNEL_CHANNEL(CVADC_EVENT_CHANNEL) | EVSYS_CHANNEL_EVGEN(EVSYS_ID_GEN_TC4_OVF) |
+                         EVSYS_CHANNEL_PATH_ASYNCHRONOUS;
+
+    GCLK->CLKCTRL.reg = GCLK_CLKCTRL_CLKEN | GCLK_CLKCTRL_GEN_GCLK0 | GCLK_CLKCTRL_ID_TC4_TC5;
+    while (GCLK->STATUS.bit.SYNCBUSY)
+        ;
+    TC4->COUNT16.CTRLA.bit.ENABLE = 0;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+    TC4->COUNT16.CTRLA.reg = TC_CTRLA_MODE_COUNT16 | TC_CTRLA_WAVEGEN_MFRQ | TC_CTRLA_PRESCALER_DIV8;
+    TC4->COUNT16.EVCTRL.reg = TC_EVCTRL_OVFEO;
+    TC4->COUNT16.CC[0].reg = VARIANT_MCK / 8 / (CVADC_RATE * cvADC.count) - 1;
+    while (TC4->COUNT16.STATUS.bit.SYNCBUSY)
+        ;
+    TC4->COUNT16.CTRLA.bit.ENABLE = 1;
+}
+
+// Without waiting for the synchronization in the interrupt, the conversion just ended so none is
+// pending and the next event comes much later
+void CVADCSelect(int input) {
+    ADC->INPUTCTRL.bit.MUXPOS = cvADC.channels[input];
+}
+
+void ADC_Handler() {
+    CVADCResult(ADC->RESULT.reg); // Reading the result clears the interrupt
+}
+
+#else
+// Native fake, conversions happen when the tests call CVADCFakeConvert() instead of the timer events
+unsigned long cvADCFakeSelects = 0;
+
+void CVADCInit(const int pins[], int count, CVSampleHandler onSample) {
+    (void)pins;
+    cvADC = CVADCState();
+    cvADC.count = count < CVADC_MAX_INPUTS ? count : CVADC_MAX_INPUTS;
+    cvADC.onSample = onSample;
+    cvADCFakeSelects = 0;
+}
+
+void CVADCSelect(int input) {
+    (void)input;
+    cvADCFakeSelects++;
+}
+
+// Result of the input being converted
+void CVADCFakeConvert(uint16_t value) {
+    CVADCResult(value);
+}
+#endif
@@ -0,0 +1,66 @@
+#pragma once
+#include <stdint.h>
+
+// Gate detection on the CV inputs
+//
+// The gate-type CV targets (start/stop, reset, envelope triggers) switch when the scaled CV value
+// crosses the middle of the range. Instead of scaling every reading, the crossing is turned into
+// raw ADC thresholds once per calibration, attenuation and offset, so the ADC interrupt only
+// compares the result. The thresholds are apart by the hysteresis so a slow or noisy edge switches
+// once.
+
+struct GateThresholds {
+    int32_t high; // Rising above
+    int32_t low;  // Falling below
+};
+
+class GateDetector {
+  public:
+    // New thresholds, the level restarts low when the detector is enabled
+    void Configure(GateThresholds thresholds, bool enabled) {
+        _thresholds = thresholds;
+        if (enabled && !_enabled) {
+            _level = false;
+        }
+        _enabled = enabled;
+    }
+
+    bool IsEnabled() const { return _enabled; }
+    bool Level() const { return _level; }
+
+    // Edge of a new reading: 1 rising, -1 falling, 0 none or disabled
+    int Update(int32_t value) {
+        if (!_enabled) {
+            return 0;
+        }
+        if (!_level && value > _thresholds.high) {
+            _level = true;
+            return 1;
+        }
+        if (_level && value < _thresholds.low) {
+            _level = false;
+            return -1;
+        }
+        return 0;
+    }
+
+  private:
+    GateThresholds _thresholds = {INT32_MAX, INT32_MIN};
+    bool _level = false;
+    bool _enabled = false;
+};
+
+// Raw thresholds of level on the scaled value max((raw - adcOffset) * adcCal, 0) * gain + shift,
+// with the hysteresis (scaled) on each side. A scaled value that can't reach level never rises,
+// one that is always above never falls.
+inline GateThresholds GateRawThresholds(float level, float hysteresis, float adcOffset, float adcCal, float gain, float shift) {
+    auto raw = [&](float scaled) -> int32_t {
+        float calibrated = gain > 0 && adcCal > 0 ? (scaled - shift) / gain : (shift > scaled ? -1.0f : 1e9f);
+        if (calibrated < 0) {
+            return -1; // Any reading is above
+        }
+        float value = calibrated / adcCal + adcOffset;
+        return value > 65535 ? 65536 : int32_t(value);
+    };
+    return {raw(level + hysteresis), raw(level - hysteresis)};
+}
@@ -0,0 +1,106 @@
+#pragma once
+#include <stdint.h>
+
+#include "trace.hpp"
+
+#define CV_CAPTURE_SAMPLES 384
+#define CV_REPLAY_INPUTS 8
+
+// Recorded CV input
+//
+// The CV readings can be captured into a RAM buffer and replayed later in place of the ADC at the
+// same time offsets, so the modulation that caused a problem runs again sample for sample. A
+// recording is a list of trace events in time order: time in us, CV input as channel, raw ADC
+// value. The module keeps capturing the live inputs into a TraceRecorder (changes only, the latest
+// samples are kept) so the capture holds what led to a glitch. It is read with
+// "forgectl.py trace --cv capture.csv", native builds load such a CSV file.
+
+enum CVSource : uint8_t {
+    CVLive,   // ADC, the latest values are captured
+    CVReplay, // Recording
+};
+
+class CVPlayer {
+  public:
+    typedef const TraceEvent &(*SampleReader)(int index);
+
+    // Replay count samples read with sample(), the first one is at now
+    void Start(SampleReader sample, int count, uint32_t now) {
+        _sample = sample;
+        _count = count;
+        _next = 0;
+        _known = 0;
+        _start = now;
+        _origin = count > 0 ? sample(0).time : 0;
+        _running = true;
+    }
+
+    void Stop() { _running = false; }
+    bool Running() const { return _running; }
+    bool Finished() const { return _running && _next >= _count; } // The last values are held
+
+    // Play the samples due at now, each one also goes to onSample(input, value) in time order
+    template <typename Handler>
+    void Play(uint32_t now, Handler onSample) {
+        if (!_running) {
+            return;
+        }
+        uint32_t elapsed = now - _start;
+        while (_next < _count && _sample(_next).time - _origin <= elapsed) {
+            const TraceEvent &sample = _sample(_next++);
+            if (sample.channel < CV_REPLAY_INPUTS) {
+                _values[sample.channel] = sample.value;
+                _known |= 1u << sample.channel;
+                onSample(sample.channel, sample.value);
+            }
+        }
+    }
+
+    // Value of input at now, false when no replay runs or the input has no sample yet
+    bool Read(uint32_t now, int input, uint16_t &value) {
+        if (!_running || input >= CV_REPLAY_INPUTS) {
+            return false;
+        }
+        Play(now, [](int, uint16_t) {});
+        if (!(_known & (1u << input))) {
+            return false;
+        }
+        value = _values[input];
+        return true;
+    }
+
+  private:
+    SampleReader _sample = nullptr;
+    int _count = 0;
+    int _next = 0;
+    uint32_t _start = 0;
+    uint32_t _origin = 0; // Time of the first sample
+    uint16_t _values[CV_REPLAY_INPUTS];
+    uint32_t _known = 0; // Inputs with a value
+    bool _running = false;
+};
+
+#if !defined(ARDUINO_ARCH_SAMD)
+#include <stdio.h>
+
+#include <vector>
+
+// Load a "time,input,value" CSV recording, lines not starting with a digit (header) are skipped
+inline bool LoadCVRecording(const char *path, std::vector<TraceEvent> &samples) {
+    FILE *f = fopen(path, "r");
+    if (f == nullptr) {
+        return false;
+    }
+    samples.clear();
+    char line[64];
+    while (fgets(line, sizeof(line), f)) {
+        unsigned long time;
+        unsigned int input, value;
+        if (line[0] >= '0' && line[0] <= '9' && sscanf(line, "%lu,%u,%u", &time, &input, &value) == 3) {
+            samples.push_back({uint32_t(time), uint16_t(value), uint8_t(input)});
+        }
+    }
+    fclose(f);
+    return true;
+}
+#endif
@@ -0,0 +1,211 @@
+#pragma once
+#include <stdint.h>
+
+#include "cvgate.hpp"
+
+// CV modulation targets
+//
+// A CV reading is calibrated, smoothed by the CV task, attenuated and offset (CVScale) and then
+// changes its target (CVTargetApply). The gate targets are detected on every raw ADC result
+// instead, against the raw thresholds of the same scaling (CVGateThresholds), and an edge is
+// applied by CVGateApply. The module firmware and the native replay runner share these steps, the
+// Module type gives them what the targets change:
+//   outputs[]               Outputs of the clock engine
+//   GateCount               Gate outputs before the DAC outputs
+//   MinBPM, MaxBPM          Range of the tempo target
+//   SceneCount              Scenes of the scene select target
+//   Waveform, WaveformCount Waveform type of the DAC outputs and its number of values
+//   Transport(bool run)     Start or stop
+//   Reset()
+//   SetBPM(int bpm)
+//   SelectScene(int scene)
+
+#define CV_MAX 4095                      // Scaled value range, as the DAC
+#define CV_GATE_HYSTERESIS (CV_MAX / 50) // 2% of the range on each side of the middle
+#define CV_CHANGE 10                     // Smoothed change that updates a target
+
+enum CVTarget {
+    None = 0,
+    StartStop,
+    Reset,
+    SetBPM,
+    Div1,
+    Div2,
+    Div3,
+    Div4,
+    Output1Prob,
+    Output2Prob,
+    Output3Prob,
+    Output4Prob,
+    Swing1Amount,
+    Swing1Every,
+    Swing2Amount,
+    Swing2Every,
+    Swing3Amount,
+    Swing3Every,
+    Swing4Amount,
+    Swing4Every,
+    Output3Level,
+    Output4Level,
+    Output3Offset,
+    Output4Offset,
+    Output3Waveform,
+    Output4Waveform,
+    Output1Duty,
+    Output2Duty,
+    Output3Duty,
+    Output4Duty,
+    Envelope1,
+    Envelope2,
+    SceneSelect,
+};
+
+// Start/stop, reset and the envelope triggers switch on the middle of the scaled CV range
+inline bool IsGateTarget(CVTarget target) {
+    return target == CVTarget::StartStop || target == CVTarget::Reset || target == CVTarget::Envelope1 || target == CVTarget::Envelope2;
+}
+
+// Calibrated value of a raw ADC reading
+inline float CVCalibrate(uint16_t raw, int adcOffset, float adcCal) {
+    float calibrated = (raw - adcOffset) * adcCal;
+    return calibrated > 0 ? calibrated : 0.0f;
+}
+
+// One pole smoothing of the calibrated readings of the CV task, true when the value moved enough
+// to update its target
+inline bool CVSmooth(float &value, float calibrated) {
+    float old = value;
+    value = calibrated + 0.5f * (old - calibrated);
+    return value - old > CV_CHANGE || old - value > CV_CHANGE;
+}
+
+// Attenuated (%) and offset (% of the range) value, within the range
+inline float CVScale(float value, int attenuation, int offset) {
+    float scaled = value * ((100 - attenuation) / 100.0f) + offset / 100.0f * CV_MAX;
+    return scaled < 0 ? 0.0f : scaled > CV_MAX ? float(CV_MAX) : scaled;
+}
+
+// Raw gate thresholds of the middle of the range through the calibration and CVScale()
+inline GateThresholds CVGateThresholds(int adcOffset, float adcCal, int attenuation, int offset) {
+    return GateRawThresholds(CV_MAX / 2, CV_GATE_HYSTERESIS, adcOffset, adcCal, (100 - attenuation) / 100.0f, offset / 100.0f * CV_MAX);
+}
+
+// Scaled value mapped to low..high as map(value, 0, full, low, high)
+inline long CVMap(float value, long low, long high, long full = CV_MAX) {
+    return long(value) * (high - low) / full + low;
+}
+
+inline long CVConstrain(long value, long low, long high) {
+    return value < low ? low : value > high ? high : value;
+}
+
+// Continuous target state of an input
+struct CVTargetState {
+    bool resetHigh = false; // Above the middle with the reset target, it resets once per rise
+};
+
+// Change the target of a scaled value from the CV task. The gate targets do nothing when their
+// detector is enabled, they are applied from its edges.
+template <typename Module>
+void CVTargetApply(Module &module, CVTarget target, float value, bool gateDetected, CVTargetState &state) {
+    if (IsGateTarget(target) && gateDetected) {
+        return;
+    }
+    switch (target) {
+    case CVTarget::None:
+        break;
+    case CVTarget::StartStop:
+        module.Transport(value > CV_MAX / 2);
+        break;
+    case CVTarget::Reset:
+        if (value > CV_MAX / 2 && !state.resetHigh) {
+            module.Reset();
+            state.resetHigh = true;
+        } else if (value < CV_MAX / 2) {
+            state.resetHigh = false;
+        }
+        break;
+    case CVTarget::SetBPM:
+        module.SetBPM(CVMap(value, Module::MinBPM, Module::MaxBPM));
+        break;
+    // Per output targets are consecutive, the output index is the offset in the group
+    case CVTarget::Div1:
+    case CVTarget::Div2:
+    case CVTarget::Div3:
+    case CVTarget::Div4: {
+        auto &output = module.outputs[target - CVTarget::Div1];
+        output.SetDivider(CVConstrain(CVMap(value, 0, output.GetDividerAmounts()), 0, output.GetDividerAmounts() - 1));
+        break;
+    }
+    case CVTarget::Output1Prob:
+    case CVTarget::Output2Prob:
+    case CVTarget::Output3Prob:
+    case CVTarget::Output4Prob:
+        module.outputs[target - CVTarget::Output1Prob].SetPulseProbability(CVMap(value, 1, 100));
+        break;
+    case CVTarget::Swing1Amount:
+    case CVTarget::Swing2Amount:
+    case CVTarget::Swing3Amount:
+    case CVTarget::Swing4Amount: {
+        auto &output = module.outputs[(target - CVTarget::Swing1Amount) / 2];
+        output.SetSwingAmount(CVMap(value, 0, output.GetSwingAmounts()));
+        break;
+    }
+    case CVTarget::Swing1Every:
+    case CVTarget::Swing2Every:
+    case CVTarget::Swing3Every:
+    case CVTarget::Swing4Every: {
+        auto &output = module.outputs[(target - CVTarget::Swing1Every) / 2];
+        output.SetSwingEvery(CVMap(value, 1, output.GetSwingEveryAmounts()));
+        break;
+    }
+    case CVTarget::Output3Offset:
+    case CVTarget::Output4Offset:
+        module.outputs[Module::GateCount + target - CVTarget::Output3Offset].SetOffset(CVMap(value, 0, 100));
+        break;
+    case CVTarget::Output3Level:
+    case CVTarget::Output4Level:
+        module.outputs[Module::GateCount + target - CVTarget::Output3Level].SetLevel(CVMap(value, 0, 100));
+        break;
+    case CVTarget::Output3Waveform:
+    case CVTarget::Output4Waveform:
+        module.outputs[Module::GateCount + target - CVTarget::Output3Waveform].SetWaveformType(
+            static_cast<typename Module::Waveform>(CVMap(value, 0, Module::WaveformCount - 1)));
+        break;
+    case CVTarget::Output1Duty:
+    case CVTarget::Output2Duty:
+    case CVTarget::Output3Duty:
+    case CVTarget::Output4Duty:
+        module.outputs[target - CVTarget::Output1Duty].SetDutyCycle(CVMap(value, 0, 100));
+        break;
+    case CVTarget::Envelope1:
+    case CVTarget::Envelope2:
+        module.outputs[Module::GateCount + target - CVTarget::Envelope1].SetExternalTrigger(value > CV_MAX / 2);
+        break;
+    case CVTarget::SceneSelect:
+        module.SelectScene(CVMap(value, 0, Module::SceneCount, CV_MAX + 1));
+        break;
+    }
+}
+
+// Edge of the gate detector of an input (1 rising, -1 falling) at time (us), from the ADC interrupt
+// or a replayed sample
+template <typename Module>
+void CVGateApply(Module &module, CVTarget target, int edge, unsigned long time) {
+    switch (target) {
+    case CVTarget::StartStop:
+        module.Transport(edge > 0);
+        break;
+    case CVTarget::Reset:
+        if (edge > 0) {
+            module.Reset();
+        }
+        break;
+    case CVTarget::Envelope1:
+    case CVTarget::Envelope2:
+        module.outputs[Module::GateCount + target - CVTarget::Envelope1].QueueExternalTrigger(edge > 0, time);
+        break;
+    default:
+        break;
+    }
+}
@@ -0,0 +1,50 @@
+#pragma once
+#include <stdint.h>
+
+// DAC refresh ramps
+//
+// The waveforms are computed on the clock ticks, from about 130 Hz at 10 BPM to 3.8 kHz at 300 BPM,
+// while the DACs are written by a fixed rate timer. Between two ticks a DAC output glides from its
+// level to the level of the latest tick: the phase, in Q16 fractions of a tick, advances by the
+// refresh period over the tick period at every refresh. Slow tempos don't step and the output
+// doesn't depend on the loop timing, at the cost of one tick of latency. Levels that jump (square,
+// noise, sample and hold, period starts) are written at once.
+
+#define RAMP_ONE (1ul << 16) // A whole tick
+
+// Phase advance per refresh for the tick period, both in us
+inline uint32_t RampStep(uint32_t refreshMicros, uint32_t tickMicros) {
+    if (tickMicros == 0 || refreshMicros >= tickMicros) {
+        return RAMP_ONE;
+    }
+    return (uint64_t(refreshMicros) << 16) / tickMicros;
+}
+
+class DACRamp {
+  public:
+    // New level on a tick, glide to it from the current level or jump
+    void Target(int level, bool glide) {
+        _from = glide ? Level() : level;
+        _to = level;
+        _phase = 0;
+    }
+
+    // Advance one refresh, true when the level to write changed
+    bool Next(uint32_t step, int &level) {
+        _phase = _phase + step >= RAMP_ONE ? RAMP_ONE : _phase + step;
+        level = Level();
+        if (level == _written) {
+            return false;
+        }
+        _written = level;
+        return true;
+    }
+
+    int Level() const { return _from + (_to - _from) * int32_t(_phase) / int32_t(RAMP_ONE); }
+
+  private:
+    int _from = 0;
+    int _to = 0;
+    uint32_t _phase = RAMP_ONE;
+    int _written = -1; // Last level written, none at first
+};
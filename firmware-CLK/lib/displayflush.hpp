@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "i2carbiter.hpp"
+
+// SSD1306 frame flush in the background
+//
+// The frame is sent in chunks of half a page, each chunk is one arbiter transaction chained from
+// the completion of the previous one. Short chunks keep the wait of a DAC write between them
+// under a millisecond. Flushing needs a stable copy of the frame, the display draws into one
+// buffer while the other one is sent.
+
+#define DISPLAY_FLUSH_CHUNK 64
+
+class DisplayFlush {
+  public:
+    void Begin(uint8_t address, int width, int height, void (*onDone)()) {
+        _address = address;
+        _size = width * ((height + 7) / 8);
+        _commands[5] = width - 1;
+        _chunk = -1;
+        i2cArbiter.SetClient(I2CClientDisplay, onDone);
+    }
+
+    // Start sending a frame, false if the previous one is still being sent
+    bool Start(const uint8_t *frame) {
+        if (Busy()) {
+            return false;
+        }
+        _frame = frame;
+        _chunk = 0;
+        if (!i2cArbiter.Submit(I2CClientDisplay, _address, &CommandStream, 1, _commands, sizeof(_commands))) {
+            _chunk = -1;
+            return false;
+        }
+        return true;
+    }
+
+    // Send the next chunk, called by the arbiter done callback
+    void OnTransferDone() {
+        if (_chunk < 0) {
+            return;
+        }
+        int offset = _chunk * DISPLAY_FLUSH_CHUNK;
+        if (offset >= _size) {
+            _chunk = -1;
+            _frames++;
+            return;
+        }
+        _chunk++;
+        int length = _size - offset < DISPLAY_FLUSH_CHUNK ? _size - offset : DISPLAY_FLUSH_CHUNK;
+        if (!i2cArbiter.Submit(I2CClientDisplay, _address, &DataStream, 1, _frame + offset, length)) {
+            _chunk = -1;
+        }
+    }
+
+    bool Busy() const { return _chunk >= 0; }
+    unsigned long GetFrames() const { return _frames; } // Frames completely sent
+
+  private:
+    static constexpr uint8_t CommandStream = 0x00; // Control byte of a command list
+    static constexpr uint8_t DataStream = 0x40;    // Control byte of display data
+
+    uint8_t _address = 0;
+    int _size = 0;
+    const uint8_t *_frame = nullptr;
+    volatile int _chunk = -1; // Next data chunk, -1 when idle
+    volatile unsigned long _frames = 0;
+    // Page and column address range of the whole display (SSD1306_PAGEADDR, SSD1306_COLUMNADDR)
+    uint8_t _commands[6] = {0x22, 0, 0xFF, 0x21, 0, 127};
+};
@@ -0,0 +1,104 @@
+#pragma once
+#include <Adafruit_SSD1306.h>
+#include <stdlib.h>
+
+#include "displayflush.hpp"
+#include "glyphs.hpp"
+
+#define LABEL_CACHE_ENTRIES 48
+#define LABEL_CACHE_BYTES 2048
+
+// SSD1306 display with the size 1 text blitted straight into the frame buffer
+//
+// Everything printed with the classic font at text size 1 and no rotation goes through the
+// glyph renderer, other text sizes, fonts and the inverse color fall back to Adafruit GFX.
+// Static labels (menu headers, descriptions) are rendered once and kept in a label cache.
+// After beginBackground() frames are sent by the I2C DMA while the next one is drawn into a
+// second buffer.
+class FastDisplay : public Adafruit_SSD1306 {
+  public:
+    FastDisplay(uint8_t w, uint8_t h, TwoWire *twi, int8_t rst) : Adafruit_SSD1306(w, h, twi, rst) {}
+
+    size_t write(uint8_t c) override {
+        if (!FastText() || (c != '\n' && c != '\r' && !HasGlyph(c))) {
+            return Adafruit_SSD1306::write(c);
+        }
+        if (c == '\n') {
+            cursor_x = 0;
+            cursor_y += GLYPH_HEIGHT;
+        } else if (c != '\r') {
+            if (wrap && cursor_x + GLYPH_WIDTH > _width) {
+                cursor_x = 0;
+                cursor_y += GLYPH_HEIGHT;
+            }
+            char text[2] = {char(c), 0};
+            BlitText(getBuffer(), WIDTH, HEIGHT, cursor_x, cursor_y, text, textcolor, textbgcolor);
+            cursor_x += GLYPH_WIDTH;
+        }
+        return 1;
+    }
+
+    // Send the frames in the background, after begin() and the Wire clock setting
+    bool beginBackground(uint8_t address) {
+        _back = (uint8_t *)malloc(BufferSize());
+        if (_back == nullptr) {
+            return false;
+        }
+        _background = this;
+        _flush.Begin(address, WIDTH, HEIGHT, OnFlushDone);
+        return true;
+    }
+
+    // Send the frame in the background and keep drawing on a copy of it in the other buffer.
+    // Returns false while the previous frame is still being sent, try again later.
+    bool displayBackground() {
+        if (_back == nullptr) {
+            Adafruit_SSD1306::display();
+            return true;
+        }
+        if (_flush.Busy()) {
+            return false;
+        }
+        uint8_t *front = buffer;
+        buffer = _back;
+        _back = front;
+        memcpy(buffer, front, BufferSize());
+        _flush.Start(front);
+        return true;
+    }
+
+    // Same as Adafruit_SSD1306::display(), waits for the previous frame only
+    void display() {
+        while (!displayBackground())
+            ;
+    }
+
+    bool displayBusy() const { return _flush.Busy(); }
+    unsigned long getFramesSent() const { return _flush.GetFrames(); }
+
+    // Print a constant string through the label cache, the string must stay at the same address
+    void printLabel(const char *label) {
+        int count;
+        const uint8_t *columns = FastText() ? _labels.Get(label, count) : nullptr;
+        if (columns == nullptr) {
+            print(label);
+            return;
+        }
+        BlitGlyphs(getBuffer(), WIDTH, HEIGHT, cursor_x, cursor_y, columns, count, textcolor, textbgcolor);
+        cursor_x += count;
+    }
+
+  private:
+    LabelCache<LABEL_CACHE_ENTRIES, LABEL_CACHE_BYTES> _labels;
+    DisplayFlush _flush;
+    uint8_t *_back = nullptr; // Buffer being sent
+    static inline FastDisplay *_background = nullptr;
+
+    int BufferSize() const { return WIDTH * ((HEIGHT + 7) / 8); }
+
+    static void OnFlushDone() { _background->_flush.OnTransferDone(); }
+
+    bool FastText() const {
+        return gfxFont == nullptr && textsize_x == 1 && textsize_y == 1 && rotation == 0 && textcolor <= SSD1306_WHITE && textbgcolor <= SSD1306_WHITE;
+    }
+};
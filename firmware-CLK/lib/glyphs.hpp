@@ -0,0 +1,213 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#ifdef ARDUINO
+#include <Arduino.h>
+#endif
+#ifndef PROGMEM
+#define PROGMEM
+#endif
+#ifndef pgm_read_byte
+#define pgm_read_byte(addr) (*(const uint8_t *)(addr))
+#endif
+
+// Glyph renderer for SSD1306 page format buffers (byte x + (y / 8) * width, bit y & 7)
+//
+// Adafruit GFX draws each character pixel by pixel through drawPixel(). Here glyph columns
+// are shifted into the one or two pages they cover, a 6x8 character costs about a dozen
+// byte writes. Output is the same as Adafruit GFX text size 1 with the classic font.
+
+#define GLYPH_WIDTH 6 // 5 columns and 1 of spacing
+#define GLYPH_HEIGHT 8
+#define GLYPH_FIRST ' '
+#define GLYPH_LAST '~'
+
+// Classic 5x7 font of Adafruit GFX (glcdfont), printable ASCII only
+const uint8_t GlyphFont[][5] PROGMEM = {
+    {0x00, 0x00, 0x00, 0x00, 0x00}, // ' '
+    {0x00, 0x00, 0x5F, 0x00, 0x00}, // !
+    {0x00, 0x07, 0x00, 0x07, 0x00}, // "
+    {0x14, 0x7F, 0x14, 0x7F, 0x14}, // #
+    {0x24, 0x2A, 0x7F, 0x2A, 0x12}, // $
+    {0x23, 0x13, 0x08, 0x64, 0x62}, // %
+    {0x36, 0x49, 0x56, 0x20, 0x50}, // &
+    {0x00, 0x08, 0x07, 0x03, 0x00}, // '
+    {0x00, 0x1C, 0x22, 0x41, 0x00}, // (
+    {0x00, 0x41, 0x22, 0x1C, 0x00}, // )
+    {0x2A, 0x1C, 0x7F, 0x1C, 0x2A}, // *
+    {0x08, 0x08, 0x3E, 0x08, 0x08}, // +
+    {0x00, 0x80, 0x70, 0x30, 0x00}, // ,
+    {0x08, 0x08, 0x08, 0x08, 0x08}, // -
+    {0x00, 0x00, 0x60, 0x60, 0x00}, // .
+    {0x20, 0x10, 0x08, 0x04, 0x02}, // /
+    {0x3E, 0x51, 0x49, 0x45, 0x3E}, // 0
+    {0x00, 0x42, 0x7F, 0x40, 0x00}, // 1
+    {0x72, 0x49, 0x49, 0x49, 0x46}, // 2
+    {0x21, 0x41, 0x49, 0x4D, 0x33}, // 3
+    {0x18, 0x14, 0x12, 0x7F, 0x10}, // 4
+    {0x27, 0x45, 0x45, 0x45, 0x39}, // 5
+    {0x3C, 0x4A, 0x49, 0x49, 0x31}, // 6
+    {0x41, 0x21, 0x11, 0x09, 0x07}, // 7
+    {0x36, 0x49, 0x49, 0x49, 0x36}, // 8
+    {0x46, 0x49, 0x49, 0x29, 0x1E}, // 9
+    {0x00, 0x00, 0x14, 0x00, 0x00}, // :
+    {0x00, 0x40, 0x34, 0x00, 0x00}, // ;
+    {0x00, 0x08, 0x14, 0x22, 0x41}, // <
+    {0x14, 0x14, 0x14, 0x14, 0x14}, // =
+    {0x00, 0x41, 0x22, 0x14, 0x08}, // >
+    {0x02, 0x01, 0x59, 0x09, 0x06}, // ?
+    {0x3E, 0x41, 0x5D, 0x59, 0x4E}, // @
+    {0x7C, 0x12, 0x11, 0x12, 0x7C}, // A
+    {0x7F, 0x49, 0x49, 0x49, 0x36}, // B
+    {0x3E, 0x41, 0x41, 0x41, 0x22}, // C
+    {0x7F, 0x41, 0x41, 0x41, 0x3E}, // D
+    {0x7F, 0x49, 0x49, 0x49, 0x41}, // E
+    {0x7F, 0x09, 0x09, 0x09, 0x01}, // F
+    {0x3E, 0x41, 0x41, 0x51, 0x73}, // G
+    {0x7F, 0x08, 0x08, 0x08, 0x7F}, // H
+    {0x00, 0x41, 0x7F, 0x41, 0x00}, // I
+    {0x20, 0x40, 0x41, 0x3F, 0x01}, // J
+    {0x7F, 0x08, 0x14, 0x22, 0x41}, // K
+    {0x7F, 0x40, 0x40, 0x40, 0x40}, // L
+    {0x7F, 0x02, 0x1C, 0x02, 0x7F}, // M
+    {0x7F, 0x04, 0x08, 0x10, 0x7F}, // N
+    {0x3E, 0x41, 0x41, 0x41, 0x3E}, // O
+    {0x7F, 0x09, 0x09, 0x09, 0x06}, // P
+    {0x3E, 0x41, 0x51, 0x21, 0x5E}, // Q
+    {0x7F, 0x09, 0x19, 0x29, 0x46}, // R
+    {0x26, 0x49, 0x49, 0x49, 0x32}, // S
+    {0x03, 0x01, 0x7F, 0x01, 0x03}, // T
+    {0x3F, 0x40, 0x40, 0x40, 0x3F}, // U
+    {0x1F, 0x20, 0x40, 0x20, 0x1F}, // V
+    {0x3F, 0x40, 0x38, 0x40, 0x3F}, // W
+    {0x63, 0x14, 0x08, 0x14, 0x63}, // X
+    {0x03, 0x04, 0x78, 0x04, 0x03}, // Y
+    {0x61, 0x59, 0x49, 0x4D, 0x43}, // Z
+    {0x00, 0x7F, 0x41, 0x41, 0x41}, // [
+    {0x02, 0x04, 0x08, 0x10, 0x20}, // backslash
+    {0x00, 0x41, 0x41, 0x41, 0x7F}, // ]
+    {0x04, 0x02, 0x01, 0x02, 0x04}, // ^
+    {0x40, 0x40, 0x40, 0x40, 0x40}, // _
+    {0x00, 0x03, 0x07, 0x08, 0x00}, // `
+    {0x20, 0x54, 0x54, 0x78, 0x40}, // a
+    {0x7F, 0x28, 0x44, 0x44, 0x38}, // b
+    {0x38, 0x44, 0x44, 0x44, 0x28}, // c
+    {0x38, 0x44, 0x44, 0x28, 0x7F}, // d
+    {0x38, 0x54, 0x54, 0x54, 0x18}, // e
+    {0x00, 0x08, 0x7E, 0x09, 0x02}, // f
+    {0x18, 0xA4, 0xA4, 0x9C, 0x78}, // g
+    {0x7F, 0x08, 0x04, 0x04, 0x78}, // h
+    {0x00, 0x44, 0x7D, 0x40, 0x00}, // i
+    {0x20, 0x40, 0x40, 0x3D, 0x00}, // j
+    {0x7F, 0x10, 0x28, 0x44, 0x00}, // k
+    {0x00, 0x41, 0x7F, 0x40, 0x00}, // l
+    {0x7C, 0x04, 0x78, 0x04, 0x78}, // m
+    {0x7C, 0x08, 0x04, 0x04, 0x78}, // n
+    {0x38, 0x44, 0x44, 0x44, 0x38}, // o
+    {0xFC, 0x18, 0x24, 0x24, 0x18}, // p
+    {0x18, 0x24, 0x24, 0x18, 0xFC}, // q
+    {0x7C, 0x08, 0x04, 0x04, 0x08}, // r
+    {0x48, 0x54, 0x54, 0x54, 0x24}, // s
+    {0x04, 0x04, 0x3F, 0x44, 0x24}, // t
+    {0x3C, 0x40, 0x40, 0x20, 0x7C}, // u
+    {0x1C, 0x20, 0x40, 0x20, 0x1C}, // v
+    {0x3C, 0x40, 0x30, 0x40, 0x3C}, // w
+    {0x44, 0x28, 0x10, 0x28, 0x44}, // x
+    {0x4C, 0x90, 0x90, 0x90, 0x7C}, // y
+    {0x44, 0x64, 0x54, 0x4C, 0x44}, // z
+    {0x00, 0x08, 0x36, 0x41, 0x00}, // {
+    {0x00, 0x00, 0x77, 0x00, 0x00}, // |
+    {0x00, 0x41, 0x36, 0x08, 0x00}, // }
+    {0x02, 0x01, 0x02, 0x04, 0x02}, // ~
+};
+
+inline bool HasGlyph(char c) {
+    return c >= GLYPH_FIRST && c <= GLYPH_LAST;
+}
+
+// Render the columns of a text (GLYPH_WIDTH per character), returns the amount of columns
+inline int RenderGlyphs(const char *text, uint8_t columns[], int maxColumns) {
+    int count = 0;
+    for (; *text && count + GLYPH_WIDTH <= maxColumns; text++) {
+        char c = HasGlyph(*text) ? *text : '?';
+        for (int i = 0; i < 5; i++) {
+            columns[count++] = pgm_read_byte(&GlyphFont[c - GLYPH_FIRST][i]);
+        }
+        columns[count++] = 0;
+    }
+    return count;
+}
+
+// Draw glyph columns at x, y. With color == background the text is transparent (only the set
+// pixels are drawn), like Adafruit GFX setTextColor(color).
+inline void BlitGlyphs(uint8_t *buffer, int width, int height, int x, int y, const uint8_t columns[], int count, bool color, bool background) {
+    int shift = y & 7;
+    int page = (y - shift) / 8;
+    int pages = height / 8;
+    bool opaque = color != background;
+    for (int i = 0; i < count; i++, x++) {
+        if (x < 0) {
+            continue;
+        }
+        if (x >= width) {
+            break;
+        }
+        uint16_t bits = uint16_t(color ? columns[i] : uint8_t(~columns[i])) << shift;
+        uint16_t mask = opaque ? uint16_t(0xFF << shift) : uint16_t(columns[i] << shift);
+        for (int p = 0; p < 2; p++, bits >>= 8, mask >>= 8) {
+            if (page + p >= 0 && page + p < pages && (mask & 0xFF)) {
+                uint8_t &b = buffer[x + (page + p) * width];
+                b = (b & ~mask) | (bits & mask);
+            }
+        }
+    }
+}
+
+// Draw a text, returns the width in pixels
+inline int BlitText(uint8_t *buffer, int width, int height, int x, int y, const char *text, bool color, bool background) {
+    uint8_t columns[GLYPH_WIDTH];
+    int drawn = 0;
+    for (; *text; text++, drawn += GLYPH_WIDTH) {
+        char c[2] = {*text, 0};
+        RenderGlyphs(c, columns, GLYPH_WIDTH);
+        BlitGlyphs(buffer, width, height, x + drawn, y, columns, GLYPH_WIDTH, color, background);
+    }
+    return drawn;
+}
+
+// Cache of rendered static labels (menu headers, descriptions), keyed by the label string
+// address so the strings must be constant. Full cache entries are simply not cached.
+template <int Entries, int Bytes>
+class LabelCache {
+  public:
+    // Columns of a label, rendered on first use. Returns nullptr when the cache is full.
+    const uint8_t *Get(const char *label, int &count) {
+        for (int i = 0; i < _entries; i++) {
+            if (_keys[i] == label) {
+                count = _lengths[i];
+                return &_columns[_offsets[i]];
+            }
+        }
+        int length = strlen(label) * GLYPH_WIDTH;
+        if (_entries == Entries || _used + length > Bytes) {
+            return nullptr;
+        }
+        _keys[_entries] = label;
+        _offsets[_entries] = _used;
+        _lengths[_entries] = RenderGlyphs(label, &_columns[_used], length);
+        count = _lengths[_entries];
+        _used += count;
+        return &_columns[_offsets[_entries++]];
+    }
+
+    int GetEntries() const { return _entries; }
+
+  private:
+    const char *_keys[Entries];
+    uint16_t _offsets[Entries];
+    uint16_t _lengths[Entries];
+    uint8_t _columns[Bytes];
+    int _entries = 0;
+    int _used = 0;
+};
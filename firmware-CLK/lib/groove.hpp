@@ -0,0 +1,54 @@
+#pragma once
+#include <stdint.h>
+
+// Groove templates
+//
+// A groove delays the steps of an output, one step being one period of its divider, by a table of
+// offsets in 1/192 of a beat repeating every steps. The table is built from the groove settings
+// when they change, the clock ISR looks up the offset of a step once when the step changes and
+// limits it to one tick less than the step, a later step must not start before the delayed one.
+
+#define GROOVE_MAX_STEPS 32
+#define GROOVE_RESOLUTION 192 // Offsets per beat
+
+struct GrooveTable {
+    uint8_t steps; // Length of the pattern, 0 when no step is delayed
+    uint8_t offsets[GROOVE_MAX_STEPS];
+};
+
+// MPC swing percentages of the MPC grooves
+constexpr uint8_t MPCSwings[] = {54, 58, 62, 66, 71, 75};
+constexpr int MPCSwingAmount = sizeof(MPCSwings) / sizeof(MPCSwings[0]);
+
+// TR-909 shuffle: the first of every "every" steps delayed by amount/96 of a beat
+inline GrooveTable ShuffleGroove(int amount96, int every) {
+    GrooveTable groove = {};
+    if (amount96 > 0 && every > 0 && every <= GROOVE_MAX_STEPS) {
+        groove.steps = every;
+        groove.offsets[0] = amount96 * GROOVE_RESOLUTION / 96;
+    }
+    return groove;
+}
+
+// MPC swing: the second of each pair of 1/16ths placed at percent of the 1/8th instead of 50%
+inline GrooveTable SwingGroove(int percent) {
+    GrooveTable groove = {};
+    if (percent > 50) {
+        groove.steps = 2;
+        groove.offsets[1] = ((percent - 50) * GROOVE_RESOLUTION / 2 + 50) / 100;
+    }
+    return groove;
+}
+
+// User pattern, the steps past GROOVE_MAX_STEPS are dropped
+inline GrooveTable UserGroove(const uint8_t offsets[], int steps) {
+    GrooveTable groove = {};
+    if (steps > GROOVE_MAX_STEPS) {
+        steps = GROOVE_MAX_STEPS;
+    }
+    groove.steps = steps > 0 ? steps : 0;
+    for (int i = 0; i < groove.steps; i++) {
+        groove.offsets[i] = offsets[i];
+    }
+    return groove;
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+
+#include "i2cdma.hpp"
+
+// Priority arbiter for the background I2C transfers
+//
+// Each client has a small queue of transactions. When the bus is free the oldest transaction of
+// the highest priority client is sent, so a DAC write waits at most for the transaction already
+// on the bus (one display chunk, about 0.6 ms at 1 MHz) instead of a whole frame. Clients chain
+// their next transaction from their done callback, it is queued before the next pick.
+// The stats give the deepest queue and the longest wait of each client.
+
+#define I2C_QUEUE_LENGTH 4
+#define I2C_HEADER_LENGTH 3 // Header bytes are copied, the data is sent from the caller's buffer
+
+enum I2CClient { I2CClientDAC, I2CClientDisplay, I2CClients }; // Priority order
+
+struct I2CTransaction {
+    uint8_t address;
+    uint8_t headerLength;
+    uint8_t header[I2C_HEADER_LENGTH];
+    const uint8_t *data;
+    int length;
+    unsigned long queued; // Time (us) it entered the queue
+};
+
+struct I2CClientStats {
+    unsigned long sent;
+    unsigned long dropped; // Queue full or transaction too long
+    unsigned long maxWait; // Longest time (us) from the queue to the bus
+    int maxDepth;          // Most transactions waiting at once
+};
+
+class I2CArbiter {
+  public:
+    void Begin() {
+        _running = true;
+        I2CDMAInit(Service);
+    }
+
+    bool Running() const { return _running; }
+
+    void SetClient(I2CClient client, void (*onDone)()) { _queues[client].onDone = onDone; }
+
+    // Queue a write, replace overwrites the last waiting one of the client (latest value wins)
+    bool Submit(I2CClient client, uint8_t address, const uint8_t *header, int headerLength, const uint8_t *data, int length, bool replace = false) {
+        if (headerLength < 1 || headerLength > I2C_HEADER_LENGTH || headerLength + length > I2CDMA_MAX_LENGTH) {
+            _stats[client].dropped++;
+            return false;
+        }
+        uint32_t state = I2CDMAEnterCritical();
+        Queue &queue = _queues[client];
+        I2CTransaction *transaction;
+        if (replace && queue.count > 0) {
+            transaction = &queue.items[(queue.first + queue.count - 1) % I2C_QUEUE_LENGTH];
+        } else if (queue.count == I2C_QUEUE_LENGTH) {
+            _stats[client].dropped++;
+            I2CDMAExitCritical(state);
+            return false;
+        } else {
+            transaction = &queue.items[(queue.first + queue.count) % I2C_QUEUE_LENGTH];
+            transaction->queued = I2CDMAMicros();
+            queue.count++;
+            if (queue.count > _stats[client].maxDepth) {
+                _stats[client].maxDepth = queue.count;
+            }
+        }
+        transaction->address = address;
+        transaction->headerLength = headerLength;
+        memcpy(transaction->header, header, headerLength);
+        transaction->data = data;
+        transaction->length = length;
+        if (!_servicing) {
+            Dispatch();
+        }
+        I2CDMAExitCritical(state);
+        return true;
+    }
+
+    int GetDepth(I2CClient client) const { return _queues[client].count; }
+    const I2CClientStats &GetStats(I2CClient client) const { return _stats[client]; }
+
+    void ResetStats() {
+        uint32_t state = I2CDMAEnterCritical();
+        memset(_stats, 0, sizeof(_stats));
+        I2CDMAExitCritical(state);
+    }
+
+  private:
+    struct Queue {
+        I2CTransaction items[I2C_QUEUE_LENGTH];
+        int first;
+        int count;
+        void (*onDone)();
+    };
+
+    Queue _queues[I2CClients] = {};
+    I2CClientStats _stats[I2CClients] = {};
+    I2CTransaction _current = {}; // On the bus, its header must outlive the queue slot
+    int _owner = -1;              // Client of the transaction on the bus
+    bool _servicing = false;
+    bool _running = false;
+
+    // Send the next transaction if the bus is free, with the interrupts disabled
+    void Dispatch() {
+        if (_owner >= 0 || I2CDMABusy() || i2cDMA.locked) {
+            return;
+        }
+        for (int client = 0; client < I2CClients; client++) {
+            Queue &queue = _queues[client];
+            if (queue.count == 0) {
+                continue;
+            }
+            _current = queue.items[queue.first];
+            queue.first = (queue.first + 1) % I2C_QUEUE_LENGTH;
+            queue.count--;
+            unsigned long wait = I2CDMAMicros() - _current.queued;
+            if (wait > _stats[client].maxWait) {
+                _stats[client].maxWait = wait;
+            }
+            if (I2CDMAWrite(_current.address, _current.header, _current.headerLength, _current.data, _current.length)) {
+                _owner = client;
+                return;
+            }
+            _stats[client].dropped++;
+            client--; // Try the next one of the same client
+        }
+    }
+
+    // Transaction ended or bus unlocked: let the owner chain its next one, then pick by priority
+    void OnBusFree() {
+        if (I2CDMABusy()) {
+            return;
+        }
+        uint32_t state = I2CDMAEnterCritical();
+        _servicing = true;
+        if (_owner >= 0) {
+            int client = _owner;
+            _owner = -1;
+            _stats[client].sent++;
+            if (_queues[client].onDone) {
+                _queues[client].onDone();
+            }
+        }
+        _servicing = false;
+        Dispatch();
+        I2CDMAExitCritical(state);
+    }
+
+    static void Service();
+};
+
+I2CArbiter i2cArbiter;
+
+void I2CArbiter::Service() {
+    i2cArbiter.OnBusFree();
+}
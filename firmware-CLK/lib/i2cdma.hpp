@@ -0,0 +1,200 @@
+#pragma once
+#include <stdint.h>
+
+// Background I2C writes on the Wire bus with the DMA
+//
+// A transfer is a single I2C write transaction (header and data, up to 255 bytes) fed to the
+// SERCOM by a DMA channel, the CPU only sets it up. onDone is called from the DMA interrupt
+// when the transaction ended, to chain the next one. Blocking Wire transfers on the same bus
+// must hold the bus lock: it waits for the running transaction and holds the chained ones
+// until the bus is unlocked. Unlocking an idle bus also calls onDone, to start the held ones.
+// Native builds (unit tests) use a fake that records the transfers and completes them on demand.
+
+#define I2CDMA_MAX_LENGTH 255
+
+void I2CDMAInit(void (*onDone)());
+bool I2CDMAWrite(uint8_t address, const uint8_t *header, int headerLength, const uint8_t *data, int length);
+bool I2CDMABusy(); // A transaction is running
+void I2CBusLock();
+void I2CBusUnlock();
+unsigned long I2CDMAMicros();
+uint32_t I2CDMAEnterCritical(); // Disable the interrupts, returns the previous state
+void I2CDMAExitCritical(uint32_t state);
+
+// Done callback and bus lock, shared by the hardware and the fake
+struct I2CDMAState {
+    void (*onDone)();
+    volatile bool busy;
+    volatile bool locked;
+    volatile bool donePending; // Transaction ended while locked, onDone runs on unlock
+};
+I2CDMAState i2cDMA;
+
+// Called when a transaction ended (interrupt context)
+void I2CDMAFinished() {
+    i2cDMA.busy = false;
+    if (i2cDMA.locked) {
+        i2cDMA.donePending = true;
+    } else if (i2cDMA.onDone) {
+        i2cDMA.onDone();
+    }
+}
+
+bool I2CDMABusy() {
+    return i2cDMA.busy;
+}
+
+void I2CBusUnlock() {
+    i2cDMA.locked = false;
+    i2cDMA.donePending = false;
+    if (!i2cDMA.busy && i2cDMA.onDone) {
+        i2cDMA.onDone();
+    }
+}
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include <Arduino.h>
+
+#define I2CDMA_CHANNEL 0
+#define I2CDMA_SERCOM SERCOM2 // Wire of the XIAO (PA08/PA09)
+#define I2CDMA_TRIGGER SERCOM2_DMAC_ID_TX
+
+// First descriptor of each channel, its write-back and the linked data descriptor
+__attribute__((aligned(16))) DmacDescriptor i2cDMADescriptors[I2CDMA_CHANNEL + 1];
+__attribute__((aligned(16))) DmacDescriptor i2cDMAWriteback[I2CDMA_CHANNEL + 1];
+__attribute__((aligned(16))) DmacDescriptor i2cDMAData;
+
+void I2CDMAInit(void (*onDone)()) {
+    i2cDMA = I2CDMAState();
+    i2cDMA.onDone = onDone;
+
+    PM->AHBMASK.bit.DMAC_ = 1;
+    PM->APBBMASK.bit.DMAC_ = 1;
+    DMAC->CTRL.bit.DMAENABLE = 0;
+    DMAC->CTRL.bit.SWRST = 1;
+    while (DMAC->CTRL.bit.SWRST)
+        ;
+    DMAC->BASEADDR.reg = uint32_t(i2cDMADescriptors);
+    DMAC->WRBADDR.reg = uint32_t(i2cDMAWriteback);
+    DMAC->CTRL.reg = DMAC_CTRL_DMAENABLE | DMAC_CTRL_LVLEN(0xF);
+
+    DMAC->CHID.reg = DMAC_CHID_ID(I2CDMA_CHANNEL);
+    DMAC->CHCTRLA.bit.ENABLE = 0;
+    DMAC->CHCTRLA.bit.SWRST = 1;
+    DMAC->CHCTRLB.reg = DMAC_CHCTRLB_LVL(0) | DMAC_CHCTRLB_TRIGSRC(I2CDMA_TRIGGER) | DMAC_CHCTRLB_TRIGACT_BEAT;
+    DMAC->CHINTENSET.reg = DMAC_CHINTENSET_TCMPL | DMAC_CHINTENSET_TERR;
+    NVIC_SetPriority(DMAC_IRQn, 2);
+    NVIC_EnableIRQ(DMAC_IRQn);
+}
+
+// Byte transfer into the SERCOM data register, the source address is the end of the block
+void I2CDMADescriptor(DmacDescriptor &descriptor, const uint8_t *source, int length, DmacDescriptor *next) {
+    descriptor.BTCTRL.reg = DMAC_BTCTRL_VALID | DMAC_BTCTRL_SRCINC | DMAC_BTCTRL_BEATSIZE_BYTE | DMAC_BTCTRL_BLOCKACT_NOACT;
+    descriptor.BTCNT.reg = length;
+    descriptor.SRCADDR.reg = uint32_t(source + length);
+    descriptor.DSTADDR.reg = uint32_t(&I2CDMA_SERCOM->I2CM.DATA.reg);
+    descriptor.DESCADDR.reg = uint32_t(next);
+}
+
+bool I2CDMAWrite(uint8_t address, const uint8_t *header, int headerLength, const uint8_t *data, int length) {
+    if (i2cDMA.busy || i2cDMA.locked || headerLength + length > I2CDMA_MAX_LENGTH || headerLength < 1) {
+        return false;
+    }
+    i2cDMA.busy = true;
+    I2CDMADescriptor(i2cDMAData, data, length, nullptr);
+    I2CDMADescriptor(i2cDMADescriptors[I2CDMA_CHANNEL], header, headerLength, length > 0 ? &i2cDMAData : nullptr);
+
+    DMAC->CHID.reg = DMAC_CHID_ID(I2CDMA_CHANNEL);
+    DMAC->CHCTRLA.bit.ENABLE = 1;
+    // Start, the SERCOM sends the address and a stop after the last byte
+    while (I2CDMA_SERCOM->I2CM.SYNCBUSY.bit.SYSOP)
+        ;
+    I2CDMA_SERCOM->I2CM.ADDR.reg = SERCOM_I2CM_ADDR_ADDR(address << 1) | SERCOM_I2CM_ADDR_LENEN | SERCOM_I2CM_ADDR_LEN(headerLength + length);
+    return true;
+}
+
+void I2CBusLock() {
+    i2cDMA.locked = true;
+    while (i2cDMA.busy)
+        ;
+}
+
+unsigned long I2CDMAMicros() {
+    return micros();
+}
+
+uint32_t I2CDMAEnterCritical() {
+    uint32_t state = __get_PRIMASK();
+    __disable_irq();
+    return state;
+}
+
+void I2CDMAExitCritical(uint32_t state) {
+    __set_PRIMASK(state);
+}
+
+// The last byte is in the data register when the DMA completes, wait for the stop (2 bytes at most)
+void DMAC_Handler() {
+    DMAC->CHID.reg = DMAC_CHID_ID(I2CDMA_CHANNEL);
+    uint8_t flags = DMAC->CHINTFLAG.reg;
+    DMAC->CHINTFLAG.reg = flags;
+    if (flags & (DMAC_CHINTFLAG_TCMPL | DMAC_CHINTFLAG_TERR)) {
+        for (int i = 0; i < 1000 && I2CDMA_SERCOM->I2CM.STATUS.bit.BUSSTATE != 1; i++) // 1: idle
+            ;
+        I2CDMAFinished();
+    }
+}
+
+#else
+// Native fake, transfers stay busy until I2CDMAFakeComplete()
+#define I2CDMA_FAKE_LOG 2048
+
+struct I2CDMAFake {
+    uint8_t address;
+    unsigned long transfers;
+    unsigned long micros; // Time seen by the callers, set by the tests
+    int logLength;
+    uint8_t log[I2CDMA_FAKE_LOG]; // Bytes of all transfers
+};
+I2CDMAFake i2cDMAFake;
+
+void I2CDMAInit(void (*onDone)()) {
+    i2cDMA = I2CDMAState();
+    i2cDMA.onDone = onDone;
+    i2cDMAFake = I2CDMAFake();
+}
+
+bool I2CDMAWrite(uint8_t address, const uint8_t *header, int headerLength, const uint8_t *data, int length) {
+    if (i2cDMA.busy || i2cDMA.locked || headerLength + length > I2CDMA_MAX_LENGTH || headerLength < 1) {
+        return false;
+    }
+    i2cDMA.busy = true;
+    i2cDMAFake.address = address;
+    i2cDMAFake.transfers++;
+    for (int i = 0; i < headerLength + length && i2cDMAFake.logLength < I2CDMA_FAKE_LOG; i++) {
+        i2cDMAFake.log[i2cDMAFake.logLength++] = i < headerLength ? header[i] : data[i - headerLength];
+    }
+    return true;
+}
+
+void I2CBusLock() {
+    i2cDMA.locked = true;
+}
+
+unsigned long I2CDMAMicros() {
+    return i2cDMAFake.micros;
+}
+
+uint32_t I2CDMAEnterCritical() {
+    return 0;
+}
+
+void I2CDMAExitCritical(uint32_t) {}
+
+// End the running transaction as the DMA interrupt does
+void I2CDMAFakeComplete() {
+    if (i2cDMA.busy) {
+        I2CDMAFinished();
+    }
+}
+#endif
@@ -6,6 +6,7 @@
 #include "outputs.hpp"
 
 #define NUM_SLOTS 4
+#define PRESET_VERSION 0x46470002 // "FG" and the layout version, fields are appended after it
 
 // Struct to hold params that are saved/loaded to/from EEPROM
 struct LoadSaveParams {
@@ -27,6 +28,10 @@ struct LoadSaveParams {
     int CVInputAttenuation[NUM_CV_INS];
     int CVInputOffset[NUM_CV_INS];
     EnvelopeParams envParams[NUM_OUTPUTS];
+    // Presets without the version end here
+    uint32_t version;
+    int groove[NUM_OUTPUTS];
+    GrooveTable userGroove;
 };
 
 // Create 4 slots for saving settings
@@ -61,6 +66,7 @@ void Save(const LoadSaveParams &p, int slot) { // save setting data to flash mem
 // Load default setting data
 LoadSaveParams LoadDefaultParams() {
     LoadSaveParams p;
+    p.version = PRESET_VERSION;
     p.BPM = 120;
     p.externalClockDivIdx = 0;
     for (int i = 0; i < NUM_OUTPUTS; i++) {
@@ -76,7 +82,9 @@ LoadSaveParams LoadDefaultParams() {
         p.phaseShift[i] = 0;
         p.waveformType[i] = 0;
         p.envParams[i] = {200.0f, 200.0f, 70.0f, 250.0f, 0.5f, 0.5f, 0.5f, false};
+        p.groove[i] = 0;
     }
+    p.userGroove = {};
     for (int i = 0; i < NUM_CV_INS; i++) {
         p.CVInputTarget[i] = 0;
         p.CVInputAttenuation[i] = 0;
@@ -85,6 +93,17 @@ LoadSaveParams LoadDefaultParams() {
     return p;
 }
 
+// Default the fields a preset of another version doesn't have (flash or protocol upload)
+void UpgradeParams(LoadSaveParams &p) {
+    if (p.version == PRESET_VERSION) {
+        return;
+    }
+    LoadSaveParams defaults = LoadDefaultParams();
+    memcpy(p.groove, defaults.groove, sizeof(p.groove));
+    p.userGroove = defaults.userGroove;
+    p.version = PRESET_VERSION;
+}
+
 // Load setting data from flash memory
 LoadSaveParams Load(int slot) {
     if (slot < 0 || slot >= NUM_SLOTS)
@@ -111,5 +130,6 @@ LoadSaveParams Load(int slot) {
     if (!p.valid) {
         return LoadDefaultParams();
     }
+    UpgradeParams(p);
     return p;
 }
@@ -0,0 +1,214 @@
+#pragma once
+#include <stdint.h>
+
+// Table driven menu: navigation, editing and rendering of a list of menu items
+//
+// Every item is one row of a constant table (kept in flash) with its label, position, range
+// and the callbacks to read, write and print its value. Consecutive items are grouped in pages,
+// only the items of the current page are drawn. A page can draw extra content (column titles,
+// patterns) with its own function, items without label and formatter are drawn by it.
+
+#define MENU_NO_CURSOR 0xFF
+
+// What a click on the item does
+enum class MenuKind : uint8_t {
+    Edit,   // Enter edit mode, the encoder changes the value
+    Select, // Edit mode on a copy of the value, set when leaving edit mode
+    Action, // Step the value once (toggles, cycles) or run the setter
+};
+
+// Item flags
+#define MENU_WRAP 0x01   // Wrap around the range and ignore the encoder speed
+#define MENU_PRESET 0x02 // Value is stored in the presets, changes are unsaved changes
+
+struct MenuItem {
+    const char *label;                          // nullptr: value only (second column) or drawn by the page
+    uint8_t x, y;                               // Label position
+    uint8_t valueX;                             // Value position, 0 right after the label
+    uint8_t cursorX;                            // Selection triangle position, MENU_NO_CURSOR if drawn by the page
+    uint8_t arg;                                // Output or CV input index passed to the callbacks
+    MenuKind kind;
+    uint8_t flags;
+    int16_t min, max;                           // Range, the setters may clamp further
+    int16_t step;                               // Change per encoder step, multiplied by the encoder speed
+    int32_t (*get)(int arg);                    // nullptr for actions without value
+    void (*set)(int arg, int32_t value);
+    void (*print)(int arg, int32_t value);      // Print the value at the display cursor, nullptr: none
+    bool (*accept)(int arg, int32_t value);     // Wrapped values to skip, nullptr: all accepted
+};
+
+struct MenuPage {
+    const char *header;          // nullptr: no header
+    uint8_t items;               // Amount of consecutive items on the page
+    void (*draw)(int selected);  // Extra content, selected is the item index in the page, nullptr: none
+};
+
+class Menu {
+  public:
+    Menu(const MenuItem *items, int itemCount, const MenuPage *pages, int pageCount, int start)
+        : _items(items), _itemCount(itemCount), _pages(pages), _pageCount(pageCount), _item(start) {}
+
+    int GetItem() const { return _item; } // Selected item index
+    int GetItemCount() const { return _itemCount; }
+    bool IsEditing() const { return _editing; }
+    const MenuItem &GetSelected() const { return _items[_item]; }
+
+    // Select an item and leave edit mode without applying a pending selection
+    void Select(int item) {
+        _item = item;
+        _editing = false;
+    }
+
+    // Page of the selected item and the index of its first item
+    int GetPage() const {
+        int first;
+        return FindPage(first);
+    }
+    int GetPageFirstItem() const {
+        int first;
+        FindPage(first);
+        return first;
+    }
+
+    // Encoder turn by direction (+1/-1) at speed. Returns true if a preset value changed.
+    bool Turn(int direction, int speed) {
+        if (!_editing) {
+            _item = (_item + direction + _itemCount) % _itemCount;
+            return false;
+        }
+        const MenuItem &item = _items[_item];
+        int32_t value = item.kind == MenuKind::Select ? _pending : item.get(item.arg);
+        if (item.flags & MENU_WRAP) {
+            value = Wrap(item, value, direction * item.step);
+        } else {
+            value = Clamp(value + int32_t(direction) * item.step * speed, item.min, item.max);
+        }
+        if (item.kind == MenuKind::Select) {
+            _pending = value;
+            return false;
+        }
+        item.set(item.arg, value);
+        return item.flags & MENU_PRESET;
+    }
+
+    // Encoder click. Returns true if a preset value changed.
+    bool Click() {
+        const MenuItem &item = _items[_item];
+        if (_editing) {
+            _editing = false;
+            if (item.kind == MenuKind::Select) {
+                item.set(item.arg, _pending);
+                return item.flags & MENU_PRESET;
+            }
+            return false;
+        }
+        switch (item.kind) {
+        case MenuKind::Edit:
+            _editing = true;
+            return false;
+        case MenuKind::Select:
+            _pending = item.get(item.arg);
+            _editing = true;
+            return false;
+        case MenuKind::Action:
+            item.set(item.arg, item.get ? Wrap(item, item.get(item.arg), item.step) : 0);
+            return item.flags & MENU_PRESET;
+        }
+        return false;
+    }
+
+    // Value shown for an item, the pending selection while it's edited
+    int32_t GetValue(int index) const {
+        const MenuItem &item = _items[index];
+        if (_editing && index == _item && item.kind == MenuKind::Select) {
+            return _pending;
+        }
+        return item.get ? item.get(item.arg) : 0;
+    }
+
+    // Draw the page of the selected item, header and selection cursor included.
+    // Display needs setCursor(), print(), printLabel(), drawTriangle() and fillTriangle().
+    template <typename Display>
+    void Draw(Display &display) const {
+        int first;
+        const MenuPage &page = _pages[FindPage(first)];
+        if (page.header) {
+            DrawHeader(display, page.header);
+        }
+        for (int i = first; i < first + page.items; i++) {
+            const MenuItem &item = _items[i];
+            if (item.label) {
+                display.setCursor(item.x, item.y);
+                display.printLabel(item.label);
+            }
+            if (item.print) {
+                if (item.valueX) {
+                    display.setCursor(item.valueX, item.y);
+                }
+                item.print(item.arg, GetValue(i));
+            }
+        }
+        if (page.draw) {
+            page.draw(_item - first);
+        }
+        const MenuItem &selected = _items[_item];
+        if (selected.cursorX != MENU_NO_CURSOR) {
+            int x = selected.cursorX, y = selected.y;
+            if (_editing) {
+                display.fillTriangle(x, y - 1, x, y + 7, x + 4, y + 3, 1);
+            } else {
+                display.drawTriangle(x, y - 1, x, y + 7, x + 4, y + 3, 1);
+            }
+        }
+    }
+
+  private:
+    const MenuItem *_items;
+    int _itemCount;
+    const MenuPage *_pages;
+    int _pageCount;
+    int _item;
+    bool _editing = false;
+    int32_t _pending = 0; // Select items value while editing
+
+    int FindPage(int &first) const {
+        first = 0;
+        for (int page = 0; page < _pageCount; page++) {
+            if (_item < first + _pages[page].items) {
+                return page;
+            }
+            first += _pages[page].items;
+        }
+        first = 0;
+        return 0;
+    }
+
+    static int32_t Clamp(int32_t value, int32_t min, int32_t max) {
+        return value < min ? min : (value > max ? max : value);
+    }
+
+    // Step within min..max wrapping around, skipping the values the item doesn't accept
+    static int32_t Wrap(const MenuItem &item, int32_t value, int32_t step) {
+        int32_t range = item.max - item.min + 1;
+        for (int32_t i = 0; i < range; i++) {
+            value = item.min + ((value - item.min + step) % range + range) % range;
+            if (!item.accept || item.accept(item.arg, value)) {
+                break;
+            }
+        }
+        return value;
+    }
+
+    // Centered "- HEADER -" on the first line
+    template <typename Display>
+    static void DrawHeader(Display &display, const char *header) {
+        int length = 0;
+        while (header[length]) {
+            length++;
+        }
+        display.setCursor((display.width() - (length * 6 + 24)) / 2, 1);
+        display.print("- ");
+        display.printLabel(header);
+        display.print(" -");
+    }
+};
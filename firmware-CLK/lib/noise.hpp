@@ -0,0 +1,44 @@
+#pragma once
+#include <stdint.h>
+
+#include "prng.hpp"
+
+// Interpolated value noise in Q15 (0 to 32767)
+//
+// Every segment picks a random target and glides to it from the current value with a
+// smoothstep curve, so the output is continuous with no slope jumps at the segment ends.
+// The segment length sets the rate: one random point per divider period gives noise with
+// most of its energy below the output frequency. Integer math only, one division per segment.
+class ValueNoise {
+  public:
+    // Start a new segment that reaches a random target after periodTicks ticks
+    void Start(Prng &prng, uint32_t periodTicks) {
+        _from = _value;
+        _to = prng.Below(Max + 1);
+        _phase = 0;
+        _step = periodTicks > 0 ? PhaseOne / periodTicks : PhaseOne;
+    }
+
+    // Advance one tick and return the new value
+    int32_t Tick() {
+        _phase = _phase + _step < PhaseOne ? _phase + _step : PhaseOne;
+        uint32_t t = _phase >> 9; // Q15
+        // Smoothstep 3t^2 - 2t^3
+        uint32_t curve = (((t * t) >> 15) * (3 * 32768 - 2 * t)) >> 15;
+        _value = _from + (((_to - _from) * int32_t(curve)) >> 15);
+        return _value;
+    }
+
+    int32_t GetValue() const { return _value; }
+
+    static constexpr int32_t Max = 32767;
+
+  private:
+    static constexpr uint32_t PhaseOne = 1ul << 24; // Segment phase in Q24
+
+    int32_t _from = 0;
+    int32_t _to = 0;
+    int32_t _value = 0;
+    uint32_t _phase = 0;
+    uint32_t _step = 0;
+};
@@ -0,0 +1,453 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+
+// Binary serial protocol
+//
+// Frames are COBS encoded and delimited by 0x00 on both sides so any text printed on the same port
+// (debug messages) ends up in its own frame and is dropped by the CRC check.
+// Decoded frame layout: [type][seq][payload...][crc16 lo][crc16 hi]
+// The CRC is CRC-16/CCITT-FALSE over type, seq and payload. Multi-byte values are little endian.
+// Replies echo the request seq, events sent by the module use seq 0.
+
+#define PROTOCOL_VERSION 1
+#define PROTOCOL_MAX_PAYLOAD 192
+#define PROTOCOL_CHUNK_SIZE 128 // Preset data bytes per chunk frame
+#define PROTOCOL_MAX_PRESET_SIZE 512
+#define PROTOCOL_TRACE_EVENT 7   // Bytes per trace event
+#define PROTOCOL_TRACE_EVENTS 24 // Trace events per chunk frame
+#define PROTOCOL_MAX_FRAME (PROTOCOL_MAX_PAYLOAD + 4)                                // Type, seq, payload and CRC
+#define PROTOCOL_MAX_ENCODED (PROTOCOL_MAX_FRAME + (PROTOCOL_MAX_FRAME / 254) + 3) // COBS overhead and delimiters
+
+enum MessageType : uint8_t {
+    MsgPing = 0x01,        // -> MsgPong
+    MsgPong = 0x02,        // [version][preset count][preset size u16]
+    MsgGetParam = 0x10,    // [id][ch] -> MsgParam
+    MsgSetParam = 0x11,    // [id][ch][value i32] -> MsgParam with the applied value
+    MsgParam = 0x12,       // [id][ch][value i32], also streamed on changes
+    MsgReadPresets = 0x20, // [first slot][count] -> MsgPresetChunk... MsgAck
+    MsgPresetChunk = 0x21, // [slot][offset u16][data...], the last chunk of an upload is acked
+    MsgStream = 0x30,      // [enabled] -> MsgAck
+    MsgReadTrace = 0x40,   // [clear][source, optional] -> MsgTraceChunk... MsgAck, clear empties the trace after the read
+    MsgTraceChunk = 0x41,  // [first u16][time u32, channel, value u16]...
+    MsgCVSource = 0x42,    // [source] -> MsgAck, live (captured) or replayed CV inputs
+    MsgCVSamples = 0x43,   // [first u16][time u32, input, value u16]... -> MsgAck, loads a recording to replay
+    MsgGroove = 0x44,      // [steps][offset]... -> MsgAck, loads the user groove, empty -> MsgGroove with the user groove
+    MsgAck = 0x7E,         // [request type]
+    MsgNack = 0x7F,        // [request type][error]
+};
+
+enum TraceSource : uint8_t {
+    TraceOutputs,  // Gate and DAC outputs
+    TraceCVInputs, // CV input capture
+};
+
+enum ProtocolError : uint8_t {
+    ErrUnknownMessage = 1,
+    ErrBadLength,
+    ErrBadParam,
+    ErrBadSlot,
+    ErrOutOfOrder,
+    ErrWriteFailed,
+};
+
+// CRC-16/CCITT-FALSE using a nibble table to keep flash usage small
+inline uint16_t Crc16(const uint8_t *data, size_t length, uint16_t crc = 0xFFFF) {
+    static const uint16_t table[16] = {
+        0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+        0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF};
+    for (size_t i = 0; i < length; i++) {
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] >> 4)];
+        crc = (crc << 4) ^ table[(crc >> 12) ^ (data[i] & 0x0F)];
+    }
+    return crc;
+}
+
+// COBS encode, returns the encoded length (without delimiters)
+inline size_t CobsEncode(const uint8_t *in, size_t length, uint8_t *out) {
+    size_t codeIdx = 0;
+    size_t outIdx = 1;
+    uint8_t code = 1;
+    for (size_t i = 0; i < length; i++) {
+        if (in[i] == 0) {
+            out[codeIdx] = code;
+            codeIdx = outIdx++;
+            code = 1;
+        } else {
+            out[outIdx++] = in[i];
+            code++;
+            if (code == 0xFF) {
+                out[codeIdx] = code;
+                codeIdx = outIdx++;
+                code = 1;
+            }
+        }
+    }
+    out[codeIdx] = code;
+    return outIdx;
+}
+
+// COBS decode, returns the decoded length or 0 if the input is malformed
+inline size_t CobsDecode(const uint8_t *in, size_t length, uint8_t *out) {
+    size_t outIdx = 0;
+    size_t i = 0;
+    while (i < length) {
+        uint8_t code = in[i++];
+        if (code == 0 || i + code - 1 > length) {
+            return 0;
+        }
+        for (uint8_t j = 1; j < code; j++) {
+            out[outIdx++] = in[i++];
+        }
+        if (code != 0xFF && i < length) {
+            out[outIdx++] = 0;
+        }
+    }
+    return outIdx;
+}
+
+// Build a complete frame ready to be written to the port, returns its length
+inline size_t EncodeFrame(uint8_t type, uint8_t seq, const uint8_t *payload, size_t length, uint8_t *out) {
+    uint8_t raw[PROTOCOL_MAX_FRAME];
+    if (length > PROTOCOL_MAX_PAYLOAD) {
+        return 0;
+    }
+    raw[0] = type;
+    raw[1] = seq;
+    if (length > 0) {
+        memcpy(&raw[2], payload, length);
+    }
+    uint16_t crc = Crc16(raw, length + 2);
+    raw[length + 2] = crc & 0xFF;
+    raw[length + 3] = crc >> 8;
+    out[0] = 0;
+    size_t encoded = CobsEncode(raw, length + 4, &out[1]);
+    out[encoded + 1] = 0;
+    return encoded + 2;
+}
+
+inline void PutU16(uint8_t *buf, uint16_t value) {
+    buf[0] = value & 0xFF;
+    buf[1] = value >> 8;
+}
+
+inline uint16_t GetU16(const uint8_t *buf) {
+    return buf[0] | (buf[1] << 8);
+}
+
+inline void PutI32(uint8_t *buf, int32_t value) {
+    uint32_t v = static_cast<uint32_t>(value);
+    for (int i = 0; i < 4; i++) {
+        buf[i] = (v >> (i * 8)) & 0xFF;
+    }
+}
+
+inline void PutU32(uint8_t *buf, uint32_t value) {
+    PutI32(buf, static_cast<int32_t>(value));
+}
+
+inline int32_t GetI32(const uint8_t *buf) {
+    return static_cast<int32_t>(buf[0] | (buf[1] << 8) | (buf[2] << 16) | (static_cast<uint32_t>(buf[3]) << 24));
+}
+
+// Accumulates received bytes and validates frames
+class FrameDecoder {
+  public:
+    // Feed one byte, returns true when a valid frame was completed
+    bool Receive(uint8_t byte) {
+        if (byte != 0) {
+            if (_length < sizeof(_encoded)) {
+                _encoded[_length++] = byte;
+            } else {
+                _overflow = true;
+            }
+            return false;
+        }
+        size_t encodedLength = _length;
+        bool overflow = _overflow;
+        _length = 0;
+        _overflow = false;
+        if (encodedLength == 0 || overflow) {
+            return false;
+        }
+        size_t decoded = CobsDecode(_encoded, encodedLength, _frame);
+        if (decoded < 4) {
+            _errors++;
+            return false;
+        }
+        uint16_t crc = _frame[decoded - 2] | (_frame[decoded - 1] << 8);
+        if (Crc16(_frame, decoded - 2) != crc) {
+            _errors++;
+            return false;
+        }
+        _frameLength = decoded - 4;
+        return true;
+    }
+    uint8_t Type() const { return _frame[0]; }
+    uint8_t Seq() const { return _frame[1]; }
+    const uint8_t *Payload() const { return &_frame[2]; }
+    size_t PayloadLength() const { return _frameLength; }
+    unsigned long Errors() const { return _errors; }
+
+  private:
+    uint8_t _encoded[PROTOCOL_MAX_ENCODED];
+    uint8_t _frame[PROTOCOL_MAX_ENCODED];
+    size_t _length = 0;
+    size_t _frameLength = 0;
+    bool _overflow = false;
+    unsigned long _errors = 0;
+};
+
+// Firmware callbacks used by the protocol
+struct ProtocolHandler {
+    bool (*getParam)(uint8_t id, uint8_t ch, int32_t &value);
+    bool (*setParam)(uint8_t id, uint8_t ch, int32_t &value); // Value is updated to the applied value
+    bool (*readPreset)(uint8_t slot, uint8_t *data);
+    bool (*writePreset)(uint8_t slot, const uint8_t *data);
+    void (*write)(const uint8_t *data, size_t length);
+    uint8_t presetCount;
+    uint16_t presetSize;
+    // Optional traces: events from first (oldest is 0) as PROTOCOL_TRACE_EVENT bytes, returns the count or -1 for an unknown source
+    int (*readTrace)(uint8_t source, int first, uint8_t *out, int max);
+    void (*clearTrace)(uint8_t source);
+    // Optional CV recording: select the CV source, store count samples of a recording from first
+    bool (*setCVSource)(uint8_t source);
+    bool (*writeCVSamples)(int first, const uint8_t *data, int count);
+    // Optional user groove: read the step offsets returning the steps, load steps offsets
+    int (*readGroove)(uint8_t *offsets);
+    bool (*writeGroove)(const uint8_t *offsets, int steps);
+};
+
+// Module side of the protocol
+class SerialProtocol {
+  public:
+    SerialProtocol(const ProtocolHandler &handler) : _handler(handler) {}
+
+    // Feed received bytes
+    void Receive(const uint8_t *data, size_t length) {
+        for (size_t i = 0; i < length; i++) {
+            if (_decoder.Receive(data[i])) {
+                HandleFrame();
+            }
+        }
+    }
+
+    // Send a parameter change event if streaming is enabled
+    void NotifyParam(uint8_t id, uint8_t ch, int32_t value) {
+        if (_streaming) {
+            SendParam(0, id, ch, value);
+        }
+    }
+
+    bool Streaming() const { return _streaming; }
+    unsigned long Errors() const { return _decoder.Errors(); }
+
+  private:
+    const ProtocolHandler &_handler;
+    FrameDecoder _decoder;
+    bool _streaming = false;
+    uint8_t _preset[PROTOCOL_MAX_PRESET_SIZE]; // Preset staging buffer for dumps and uploads
+    int _uploadSlot = -1;
+    uint16_t _uploadOffset = 0;
+
+    void Send(uint8_t type, uint8_t seq, const uint8_t *payload, size_t length) {
+        uint8_t out[PROTOCOL_MAX_ENCODED];
+        size_t encoded = EncodeFrame(type, seq, payload, length, out);
+        if (encoded > 0) {
+            _handler.write(out, encoded);
+        }
+    }
+
+    void SendAck(uint8_t seq, uint8_t type) {
+        Send(MsgAck, seq, &type, 1);
+    }
+
+    void SendNack(uint8_t seq, uint8_t type, ProtocolError error) {
+        uint8_t payload[2] = {type, error};
+        Send(MsgNack, seq, payload, 2);
+    }
+
+    void SendParam(uint8_t seq, uint8_t id, uint8_t ch, int32_t value) {
+        uint8_t payload[6] = {id, ch};
+        PutI32(&payload[2], value);
+        Send(MsgParam, seq, payload, sizeof(payload));
+    }
+
+    void HandleFrame() {
+        uint8_t type = _decoder.Type();
+        uint8_t seq = _decoder.Seq();
+        const uint8_t *payload = _decoder.Payload();
+        size_t length = _decoder.PayloadLength();
+
+        switch (type) {
+        case MsgPing: {
+            uint8_t pong[4] = {PROTOCOL_VERSION, _handler.presetCount};
+            PutU16(&pong[2], _handler.presetSize);
+            Send(MsgPong, seq, pong, sizeof(pong));
+            break;
+        }
+        case MsgGetParam:
+        case MsgSetParam: {
+            if (length != (type == MsgGetParam ? 2u : 6u)) {
+                SendNack(seq, type, ErrBadLength);
+                break;
+            }
+            int32_t value = type == MsgSetParam ? GetI32(&payload[2]) : 0;
+            bool ok = type == MsgSetParam ? _handler.setParam(payload[0], payload[1], value) : _handler.getParam(payload[0], payload[1], value);
+            if (ok) {
+                SendParam(seq, payload[0], payload[1], value);
+            } else {
+                SendNack(seq, type, ErrBadParam);
+            }
+            break;
+        }
+        case MsgReadPresets: {
+            if (length != 2) {
+                SendNack(seq, type, ErrBadLength);
+                break;
+            }
+            if (payload[0] + payload[1] > _handler.presetCount) {
+                SendNack(seq, type, ErrBadSlot);
+                break;
+            }
+            uint8_t first = payload[0];
+            uint8_t count = payload[1];
+            for (uint8_t slot = first; slot < first + count; slot++) {
+                _handler.readPreset(slot, _preset);
+                for (uint16_t offset = 0; offset < _handler.presetSize; offset += PROTOCOL_CHUNK_SIZE) {
+                    uint16_t chunk = _handler.presetSize - offset < PROTOCOL_CHUNK_SIZE ? _handler.presetSize - offset : PROTOCOL_CHUNK_SIZE;
+                    uint8_t out[PROTOCOL_CHUNK_SIZE + 3];
+                    out[0] = slot;
+                    PutU16(&out[1], offset);
+                    memcpy(&out[3], &_preset[offset], chunk);
+                    Send(MsgPresetChunk, seq, out, chunk + 3);
+                }
+            }
+            SendAck(seq, type);
+            break;
+        }
+        case MsgPresetChunk: {
+            // Chunks must arrive in order, only the chunk completing a preset is acked
+            if (length < 4 || length - 3 > PROTOCOL_CHUNK_SIZE) {
+                SendNack(seq, type, ErrBadLength);
+                break;
+            }
+            uint8_t slot = payload[0];
+            uint16_t offset = GetU16(&payload[1]);
+            uint16_t chunk = length - 3;
+            if (slot >= _handler.presetCount) {
+                SendNack(seq, type, ErrBadSlot);
+                break;
+            }
+            if (offset == 0) {
+                _uploadSlot = slot;
+                _uploadOffset = 0;
+            }
+            if (slot != _uploadSlot || offset != _uploadOffset || offset + chunk > _handler.presetSize) {
+                _uploadSlot = -1;
+                SendNack(seq, type, ErrOutOfOrder);
+                break;
+            }
+            memcpy(&_preset[offset], &payload[3], chunk);
+            _uploadOffset += chunk;
+            if (_uploadOffset == _handler.presetSize) {
+                _uploadSlot = -1;
+                if (_handler.writePreset(slot, _preset)) {
+                    SendAck(seq, type);
+                } else {
+                    SendNack(seq, type, ErrWriteFailed);
+                }
+            }
+            break;
+        }
+        case MsgStream:
+            if (length != 1) {
+                SendNack(seq, type, ErrBadLength);
+                break;
+            }
+            _streaming = payload[0] != 0;
+            SendAck(seq, type);
+            break;
+        case MsgReadTrace: {
+            if (_handler.readTrace == nullptr) {
+                SendNack(seq, type, ErrUnknownMessage);
+                break;
+            }
+            if (length != 1 && length != 2) {
+                SendNack(seq, type, ErrBadLength);
+                break;
+            }
+            uint8_t source = length == 2 ? payload[1] : uint8_t(TraceOutputs);
+            uint8_t out[2 + PROTOCOL_TRACE_EVENTS * PROTOCOL_TRACE_EVENT];
+            int first = 0;
+            int count = _handler.readTrace(source, first, &out[2], PROTOCOL_TRACE_EVENTS);
+            if (count < 0) {
+                SendNack(seq, type, ErrBadParam);
+                break;
+            }
+            for (; count > 0; count = _handler.readTrace(source, first, &out[2], PROTOCOL_TRACE_EVENTS)) {
+                PutU16(out, first);
+                Send(MsgTraceChunk, seq, out, 2 + count * PROTOCOL_TRACE_EVENT);
+                first += count;
+            }
+            if (payload[0] && _handler.clearTrace) {
+                _handler.clearTrace(source);
+            }
+            SendAck(seq, type);
+            break;
+        }
+        case MsgCVSource:
+            if (_handler.setCVSource == nullptr) {
+                SendNack(seq, type, ErrUnknownMessage);
+            } else if (length != 1) {
+                SendNack(seq, type, ErrBadLength);
+            } else if (!_handler.setCVSource(payload[0])) {
+                SendNack(seq, type, ErrBadParam);
+            } else {
+                SendAck(seq, type);
+            }
+            break;
+        case MsgCVSamples: {
+            // Chunks must arrive in order, the first one starts a new recording
+            if (_handler.writeCVSamples == nullptr) {
+                SendNack(seq, type, ErrUnknownMessage);
+                break;
+            }
+            if (length < 2 || (length - 2) % PROTOCOL_TRACE_EVENT != 0) {
+                SendNack(seq, type, ErrBadLength);
+                break;
+            }
+            if (!_handler.writeCVSamples(GetU16(payload), &payload[2], (length - 2) / PROTOCOL_TRACE_EVENT)) {
+                SendNack(seq, type, ErrOutOfOrder);
+                break;
+            }
+            SendAck(seq, type);
+            break;
+        }
+        case MsgGroove: {
+            if (_handler.readGroove == nullptr || _handler.writeGroove == nullptr) {
+                SendNack(seq, type, ErrUnknownMessage);
+                break;
+            }
+            if (length == 0) {
+                uint8_t out[PROTOCOL_MAX_PAYLOAD];
+                out[0] = _handler.readGroove(&out[1]);
+                Send(MsgGroove, seq, out, out[0] + 1);
+                break;
+            }
+            if (length != payload[0] + 1u) {
+                SendNack(seq, type, ErrBadLength);
+            } else if (!_handler.writeGroove(&payload[1], payload[0])) {
+                SendNack(seq, type, ErrBadParam);
+            } else {
+                SendAck(seq, type);
+            }
+            break;
+        }
+        default:
+            SendNack(seq, type, ErrUnknownMessage);
+            break;
+        }
+    }
+};
@@ -0,0 +1,32 @@
+#pragma once
+#include <stdint.h>
+
+// Exact rational periods
+//
+// A period of num/den ticks (a clock ratio at the PPQN) doesn't have to be a whole number of
+// ticks: period k starts on tick ceil(k * num / den), so the periods are floor or ceil of the
+// ratio long and never drift from the master. This is Bresenham's error accumulation in closed
+// form, computed from the tick counter alone so resets, phase and swing shifts stay exact.
+// The products stay below 2^32 as long as num * den does.
+
+// Clock divider as a ratio to the quarter note: multiply output periods every divide quarter notes
+struct DividerRatio {
+    uint8_t multiply;
+    uint8_t divide;
+};
+
+// Ticks since the start of the period containing tick
+inline unsigned long PeriodOffset(unsigned long tick, unsigned long num, unsigned long den) {
+    if (den == 1) {
+        return tick % num;
+    }
+    return (tick % num) * den % num / den;
+}
+
+// Index of the period containing tick
+inline unsigned long PeriodIndex(unsigned long tick, unsigned long num, unsigned long den) {
+    if (den == 1) {
+        return tick / num;
+    }
+    return tick / num * den + (tick % num) * den / num;
+}
@@ -0,0 +1,140 @@
+#pragma once
+#include <stdint.h>
+
+#define SCHEDULER_MAX_TASKS 8
+
+// Cooperative fixed-rate task scheduler
+//
+// Each task has a period and a priority. A call to Run() runs the most urgent due task: the
+// lowest priority number, then the earliest deadline. Tasks without a period are best effort,
+// they take turns when no periodic task is due, each once per periodic run. When they all had
+// their turn Run() returns false and the caller can sleep until the next interrupt.
+// A task keeps its rate by moving its deadline one period at a time; when it ran a whole
+// period late the lost runs are counted as misses and skipped instead of being run in a burst.
+// Tasks must return quickly, a long task delays all the others.
+
+struct SchedulerTask {
+    const char *name;
+    void (*run)();
+    unsigned long period; // us, 0 for best effort
+    uint8_t priority;     // 0 is the most urgent
+    unsigned long next;   // Deadline of the next run
+    // Stats
+    unsigned long runs;
+    unsigned long misses;      // Periods skipped because the task ran too late
+    unsigned long maxLateness; // us after the deadline
+    unsigned long maxDuration; // us
+};
+
+class Scheduler {
+  public:
+    explicit Scheduler(unsigned long (*clock)()) : _clock(clock) {}
+
+    // Add a task, returns its index or -1 when full
+    int Add(const char *name, void (*run)(), unsigned long period, uint8_t priority) {
+        if (_count >= SCHEDULER_MAX_TASKS) {
+            return -1;
+        }
+        SchedulerTask &task = _tasks[_count];
+        task = SchedulerTask();
+        task.name = name;
+        task.run = run;
+        task.period = period;
+        task.priority = priority;
+        task.next = _clock();
+        if (_count == 0) {
+            _statsStart = task.next;
+        }
+        if (period == 0) {
+            _bestEffortCount++;
+        }
+        return _count++;
+    }
+
+    // Run the most urgent task, returns false if nothing was run
+    bool Run() {
+        unsigned long now = _clock();
+        int selected = -1;
+        for (int i = 0; i < _count; i++) {
+            const SchedulerTask &task = _tasks[i];
+            if (task.period == 0 || long(now - task.next) < 0) {
+                continue;
+            }
+            if (selected < 0 || task.priority < _tasks[selected].priority ||
+                (task.priority == _tasks[selected].priority && long(task.next - _tasks[selected].next) < 0)) {
+                selected = i;
+            }
+        }
+        if (selected >= 0) {
+            _bestEffortRuns = 0;
+        } else {
+            if (_bestEffortRuns >= _bestEffortCount) {
+                return false;
+            }
+            selected = NextBestEffort();
+            _bestEffortRuns++;
+        }
+
+        SchedulerTask &task = _tasks[selected];
+        if (task.period > 0) {
+            unsigned long lateness = now - task.next;
+            if (lateness > task.maxLateness) {
+                task.maxLateness = lateness;
+            }
+            unsigned long missed = lateness / task.period;
+            task.misses += missed;
+            task.next += (missed + 1) * task.period;
+        }
+        task.run();
+        unsigned long duration = _clock() - now;
+        if (duration > task.maxDuration) {
+            task.maxDuration = duration;
+        }
+        task.runs++;
+        _busyTime += duration;
+        return true;
+    }
+
+    // Share of the time spent in the tasks since the stats reset (within the last 71 minutes), 0 to 1.
+    // Interrupts taken while sleeping count as idle time.
+    float GetDutyCycle() const {
+        unsigned long elapsed = _clock() - _statsStart;
+        return elapsed > 0 ? float(_busyTime) / elapsed : 0.0f;
+    }
+
+    int GetCount() const { return _count; }
+    const SchedulerTask &GetTask(int index) const { return _tasks[index]; }
+
+    void ResetStats() {
+        for (int i = 0; i < _count; i++) {
+            _tasks[i].runs = 0;
+            _tasks[i].misses = 0;
+            _tasks[i].maxLateness = 0;
+            _tasks[i].maxDuration = 0;
+        }
+        _busyTime = 0;
+        _statsStart = _clock();
+    }
+
+  private:
+    unsigned long (*_clock)();
+    SchedulerTask _tasks[SCHEDULER_MAX_TASKS];
+    int _count = 0;
+    int _bestEffortCount = 0;
+    int _bestEffortRuns = 0; // Best effort runs since the last periodic run
+    int _lastBestEffort = -1;
+    unsigned long _busyTime = 0; // us spent in the tasks
+    unsigned long _statsStart = 0;
+
+    // Best effort tasks in turn
+    int NextBestEffort() {
+        for (int i = 1; i <= _count; i++) {
+            int index = (_lastBestEffort + i) % _count;
+            if (_tasks[index].period == 0) {
+                _lastBestEffort = index;
+                return index;
+            }
+        }
+        return -1;
+    }
+};
@@ -0,0 +1,54 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+
+#include <array>
+
+// Compile-time lookup tables
+//
+// MakeTable<T, N>(generator) fills a table with generator(i) while compiling. Declared
+// constexpr at namespace scope the table is constant data in flash, not an initialized array
+// copied to RAM, and its parameters stay readable instead of a list of numbers.
+// The math helpers are constexpr replacements for the <math.h> functions used by the generators.
+
+template <typename T, size_t N, typename Generator>
+constexpr std::array<T, N> MakeTable(Generator generator) {
+    std::array<T, N> table{};
+    for (size_t i = 0; i < N; i++) {
+        table[i] = static_cast<T>(generator(i));
+    }
+    return table;
+}
+
+// Round half away from zero
+constexpr long TableRound(double x) {
+    return x < 0 ? -long(-x + 0.5) : long(x + 0.5);
+}
+
+// e^x, by halving x until the series converges fast then squaring back
+constexpr double TableExp(double x) {
+    int halvings = 0;
+    while (x > 0.5 || x < -0.5) {
+        x /= 2;
+        halvings++;
+    }
+    double sum = 1, term = 1;
+    for (int n = 1; n < 12; n++) {
+        term *= x / n;
+        sum += term;
+    }
+    for (int i = 0; i < halvings; i++) {
+        sum *= sum;
+    }
+    return sum;
+}
+
+// Rising exponential from 0 at i = 0 to top at i = count - 1, tau is the time constant in steps
+constexpr long ExpRise(size_t i, size_t count, double tau, long top) {
+    return TableRound(top * (1 - TableExp(-double(i) / tau)) / (1 - TableExp(-double(count - 1) / tau)));
+}
+
+// i steps of step, rounded and limited to top
+constexpr long LinearStep(size_t i, double step, long top) {
+    return TableRound(i * step) < top ? TableRound(i * step) : top;
+}
@@ -0,0 +1,136 @@
+#pragma once
+#include <stdint.h>
+
+#define TEMPO_WINDOW 8 // Intervals kept for the estimate
+#define TEMPO_LOCK 2   // Agreeing intervals for the estimate to be followed
+
+// Tempo estimation from event timestamps (taps or clock pulses)
+//
+// Keeps a sliding window of the latest intervals and estimates the period with a trimmed
+// mean (a quarter of the intervals dropped at each end, the median for short windows) so
+// single late or missed events don't move the tempo. Two consecutive intervals away from the
+// estimate are taken as a tempo change and restart the window, so the new tempo locks after
+// a couple of events instead of waiting for the window to flush.
+// Integer math only, safe to call from interrupts.
+class TempoEstimator {
+  public:
+    // Intervals outside minInterval..maxInterval (us) restart the estimation
+    TempoEstimator(unsigned long minInterval, unsigned long maxInterval) : _minInterval(minInterval), _maxInterval(maxInterval) {}
+
+    // Add an event timestamp in us, returns true if the estimate was updated
+    bool AddEvent(unsigned long time) {
+        if (!_hasLastEvent) {
+            _hasLastEvent = true;
+            _lastEvent = time;
+            return false;
+        }
+        unsigned long interval = time - _lastEvent;
+        _lastEvent = time;
+        if (interval < _minInterval || interval > _maxInterval) {
+            _count = 0;
+            _outliers = 0;
+            return false;
+        }
+
+        // Tempo change detection
+        if (_count >= 2 && !IsClose(interval, _interval, ChangeTolerance)) {
+            if (++_outliers >= 2) {
+                // Restart from the last two intervals
+                unsigned long previous = _intervals[(_head + TEMPO_WINDOW - 1) % TEMPO_WINDOW];
+                _count = 0;
+                Push(previous);
+                _outliers = 0;
+            }
+        } else {
+            _outliers = 0;
+        }
+        Push(interval);
+        Estimate();
+        return true;
+    }
+
+    // Forget all events
+    void Reset() {
+        _count = 0;
+        _outliers = 0;
+        _hasLastEvent = false;
+        _interval = 0;
+    }
+
+    // Estimated interval between events in us, 0 when unknown
+    unsigned long GetInterval() const { return _count > 0 ? _interval : 0; }
+
+    // Events per minute
+    float GetBPM() const { return _count > 0 ? 60000000.0f / _interval : 0.0f; }
+
+    // Amount of intervals in the window
+    int GetCount() const { return _count; }
+
+    // Amount of intervals in the window agreeing with the estimate
+    int GetAgreeing() const {
+        int agreeing = 0;
+        for (int i = 0; i < _count; i++) {
+            if (IsClose(_intervals[(_head + TEMPO_WINDOW - 1 - i) % TEMPO_WINDOW], _interval, AgreeTolerance)) {
+                agreeing++;
+            }
+        }
+        return agreeing;
+    }
+
+    // True once enough intervals agree to follow the estimate, two after a tempo change
+    bool IsLocked() const { return GetAgreeing() >= TEMPO_LOCK; }
+
+    // Estimate confidence from 0 to 1: share of a full window agreeing with the estimate
+    float GetConfidence() const { return float(GetAgreeing()) / TEMPO_WINDOW; }
+
+  private:
+    static const int ChangeTolerance = 8; // Intervals within 1/8 (12.5%) are the same tempo
+    static const int AgreeTolerance = 32; // Intervals within 1/32 (3%) agree with the estimate
+
+    unsigned long _minInterval;
+    unsigned long _maxInterval;
+    unsigned long _intervals[TEMPO_WINDOW];
+    int _head = 0;  // Next write position
+    int _count = 0; // Valid intervals
+    int _outliers = 0;
+    unsigned long _interval = 0;
+    unsigned long _lastEvent = 0;
+    bool _hasLastEvent = false;
+
+    static bool IsClose(unsigned long a, unsigned long b, int tolerance) {
+        unsigned long diff = a > b ? a - b : b - a;
+        return diff <= b / tolerance;
+    }
+
+    void Push(unsigned long interval) {
+        _intervals[_head] = interval;
+        _head = (_head + 1) % TEMPO_WINDOW;
+        if (_count < TEMPO_WINDOW) {
+            _count++;
+        }
+    }
+
+    void Estimate() {
+        // Insertion sort of the window, at most 8 entries
+        unsigned long sorted[TEMPO_WINDOW];
+        for (int i = 0; i < _count; i++) {
+            int idx = (_head + TEMPO_WINDOW - 1 - i) % TEMPO_WINDOW;
+            unsigned long value = _intervals[idx];
+            int j = i;
+            for (; j > 0 && sorted[j - 1] > value; j--) {
+                sorted[j] = sorted[j - 1];
+            }
+            sorted[j] = value;
+        }
+        if (_count < 4) {
+            _interval = _count % 2 ? sorted[_count / 2] : (sorted[_count / 2 - 1] + sorted[_count / 2]) / 2;
+            return;
+        }
+        int trim = _count / 4;
+        unsigned long sum = 0;
+        for (int i = trim; i < _count - trim; i++) {
+            sum += sorted[i];
+        }
+        _interval = (sum + (_count - 2 * trim) / 2) / (_count - 2 * trim);
+    }
+};
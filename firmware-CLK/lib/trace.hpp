@@ -0,0 +1,114 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+
+#define TRACE_CHANNELS 8
+
+// Output activity trace
+//
+// Every gate edge and DAC code change is kept as (time, channel, value) in a RAM ring buffer,
+// the oldest events are overwritten when it is full. Only changes are recorded so a steady
+// output costs nothing. The trace is read over the serial protocol (forgectl.py trace) and
+// written as a VCD file for GTKWave; native runs write the same VCD with WriteVCD().
+
+struct TraceEvent {
+    uint32_t time; // us, wraps after 71 minutes
+    uint16_t value;
+    uint8_t channel;
+};
+
+struct TraceChannel {
+    const char *name;
+    uint8_t width; // Bits, 1 for gates
+};
+
+template <int Size>
+class TraceRecorder {
+  public:
+    // Record value if it changed since the last event of the channel
+    void Record(uint32_t time, uint8_t channel, uint16_t value) {
+        if (!_enabled || channel >= TRACE_CHANNELS || (_known & (1u << channel) && _last[channel] == value)) {
+            return;
+        }
+        _known |= 1u << channel;
+        _last[channel] = value;
+        _events[_head] = {time, value, channel};
+        _head = (_head + 1) % Size;
+        if (_count < Size) {
+            _count++;
+        } else {
+            _overwritten++;
+        }
+    }
+
+    // Forget the events, the next value of each channel is recorded
+    void Clear() {
+        _count = 0;
+        _known = 0;
+        _overwritten = 0;
+    }
+
+    void SetEnabled(bool enabled) { _enabled = enabled; }
+    bool IsEnabled() const { return _enabled; }
+
+    int GetCount() const { return _count; }
+    unsigned long GetOverwritten() const { return _overwritten; }
+
+    // Event by age, 0 is the oldest
+    const TraceEvent &Get(int index) const { return _events[(_head + Size - _count + index) % Size]; }
+
+  private:
+    TraceEvent _events[Size];
+    uint16_t _last[TRACE_CHANNELS];
+    uint32_t _known = 0; // Channels with a recorded value
+    int _head = 0;
+    int _count = 0;
+    unsigned long _overwritten = 0;
+    bool _enabled = true;
+};
+
+// Write the events as a VCD file with write(text), times in us relative to the first event
+template <typename Events, typename Writer>
+void WriteVCD(const Events &events, int count, const TraceChannel *channels, int channelCount, Writer write) {
+    char line[48];
+    write("$timescale 1us $end\n$scope module forge $end\n");
+    for (int i = 0; i < channelCount; i++) {
+        snprintf(line, sizeof(line), "$var wire %d %c %s $end\n", channels[i].width, '!' + i, channels[i].name);
+        write(line);
+    }
+    write("$upscope $end\n$enddefinitions $end\n");
+
+    uint64_t time = 0;
+    uint32_t last = count > 0 ? events(0).time : 0;
+    bool first = true;
+    for (int i = 0; i < count; i++) {
+        const TraceEvent &event = events(i);
+        if (event.channel >= channelCount) {
+            continue;
+        }
+        if (first || event.time != last) {
+            time += event.time - last; // Unwrapped
+            last = event.time;
+            snprintf(line, sizeof(line), "#%llu\n", (unsigned long long)time);
+            write(line);
+            first = false;
+        }
+        if (channels[event.channel].width == 1) {
+            snprintf(line, sizeof(line), "%d%c\n", event.value ? 1 : 0, '!' + event.channel);
+        } else {
+            char bits[17];
+            int length = 0;
+            for (int bit = channels[event.channel].width - 1; bit >= 0; bit--) {
+                bits[length++] = (event.value >> bit) & 1 ? '1' : '0';
+            }
+            bits[length] = 0;
+            snprintf(line, sizeof(line), "b%s %c\n", bits, '!' + event.channel);
+        }
+        write(line);
+    }
+}
+
+template <int Size, typename Writer>
+void WriteVCD(const TraceRecorder<Size> &trace, const TraceChannel *channels, int channelCount, Writer write) {
+    WriteVCD([&trace](int i) -> const TraceEvent & { return trace.Get(i); }, trace.GetCount(), channels, channelCount, write);
+}
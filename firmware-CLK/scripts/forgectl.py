@@ -0,0 +1,425 @@
+#!/usr/bin/env python3
+"""ClockForge serial protocol client.
+
+Reads and writes parameters, backs up and restores the preset slots,
+monitors parameter changes, saves the output trace as a VCD file, captures
+or replays the CV inputs, loads the user groove and reads the loop stats over the
+module USB serial port.
+Protocol details are in lib/protocol.hpp. Requires pyserial.
+
+Usage:
+  forgectl.py -p /dev/ttyACM0 ping
+  forgectl.py -p /dev/ttyACM0 get BPM
+  forgectl.py -p /dev/ttyACM0 set Divider 5:7 --ch 2
+  forgectl.py -p /dev/ttyACM0 backup presets.bin
+  forgectl.py -p /dev/ttyACM0 restore presets.bin
+  forgectl.py -p /dev/ttyACM0 monitor
+  forgectl.py -p /dev/ttyACM0 trace outputs.vcd --clear
+  forgectl.py -p /dev/ttyACM0 trace --cv capture.csv
+  forgectl.py -p /dev/ttyACM0 cv load capture.csv
+  forgectl.py -p /dev/ttyACM0 cv replay
+  forgectl.py -p /dev/ttyACM0 groove 0,8,0,4
+  forgectl.py -p /dev/ttyACM0 stats --reset
+"""
+import csv
+import argparse
+import struct
+import sys
+import time
+
+import serial
+
+MSG_PING = 0x01
+MSG_PONG = 0x02
+MSG_GET_PARAM = 0x10
+MSG_SET_PARAM = 0x11
+MSG_PARAM = 0x12
+MSG_READ_PRESETS = 0x20
+MSG_PRESET_CHUNK = 0x21
+MSG_STREAM = 0x30
+MSG_READ_TRACE = 0x40
+MSG_TRACE_CHUNK = 0x41
+MSG_CV_SOURCE = 0x42
+MSG_CV_SAMPLES = 0x43
+MSG_GROOVE = 0x44
+MSG_ACK = 0x7E
+MSG_NACK = 0x7F
+
+CHUNK_SIZE = 128
+TRACE_EVENTS = 24  # Trace events per chunk
+CV_SOURCES = {"live": 0, "replay": 1}
+
+# Same order as ParamID in src/parameters.hpp
+PARAMS = [
+    "BPM", "MasterState", "ExternalDivider", "ExternalClock", "Scene", "SceneSync",
+    "Divider", "DutyCycle", "OutputState", "Level", "Offset", "SwingAmount", "SwingEvery",
+    "Probability", "Euclidean", "EuclideanSteps", "EuclideanTriggers", "EuclideanRotation",
+    "EuclideanPadding", "Phase", "Waveform", "Attack", "Decay", "Sustain", "Release", "Curve",
+    "Retrigger", "CVTarget", "CVAttenuation", "CVOffset", "TransportSync",
+    "Groove", "LoopDuty", "TaskRuns", "TaskMisses", "TaskMaxLateness", "TaskMaxDuration",
+    "I2CSent", "I2CDropped", "I2CDepth", "I2CMaxDepth", "I2CMaxWait", "BootTime",
+]
+
+# Loop tasks in the order setup() in src/main.cpp adds them
+TASKS = ["outputs", "encoder", "cv", "scenes", "serial", "clock", "display"]
+# I2C bus clients in priority order as in lib/i2carbiter.hpp
+I2C_CLIENTS = ["dac", "display"]
+
+# Divider list length and largest custom ratio as in src/outputs.hpp
+DIVIDER_AMOUNT = 19
+MAX_RATIO = 64
+
+# Trace channels as in lib/boardIO.hpp and the CV capture: (name, bits)
+TRACE_CHANNELS = [("out1", 1), ("out2", 1), ("out3", 12), ("out4", 12)]
+CV_CHANNELS = [("cv1", 12), ("cv2", 12)]
+
+ERRORS = {1: "unknown message", 2: "bad length", 3: "bad parameter", 4: "bad slot",
+          5: "chunk out of order", 6: "write failed"}
+
+
+def crc16(data):
+    crc = 0xFFFF
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else crc << 1
+            crc &= 0xFFFF
+    return crc
+
+
+def cobs_encode(data):
+    out = bytearray(b"\x00")
+    code_idx = 0
+    code = 1
+    for byte in data:
+        if byte == 0:
+            out[code_idx] = code
+            code_idx = len(out)
+            out.append(0)
+            code = 1
+        else:
+            out.append(byte)
+            code += 1
+            if code == 0xFF:
+                out[code_idx] = code
+                code_idx = len(out)
+                out.append(0)
+                code = 1
+    out[code_idx] = code
+    return bytes(out)
+
+
+def cobs_decode(data):
+    out = bytearray()
+    i = 0
+    while i < len(data):
+        code = data[i]
+        i += 1
+        if code == 0 or i + code - 1 > len(data):
+            return None
+        out += data[i:i + code - 1]
+        i += code - 1
+        if code != 0xFF and i < len(data):
+            out.append(0)
+    return bytes(out)
+
+
+class Forge:
+    def __init__(self, port, timeout=1.0):
+        self.port = serial.Serial(port, 115200, timeout=timeout)
+        self.rx = bytearray()
+        self.seq = 0
+
+    def send(self, msg_type, payload=b""):
+        self.seq = (self.seq % 255) + 1
+        raw = bytes([msg_type, self.seq]) + payload
+        raw += struct.pack("<H", crc16(raw))
+        self.port.write(b"\x00" + cobs_encode(raw) + b"\x00")
+        return self.seq
+
+    def receive(self):
+        """Return the next valid frame as (type, seq, payload) or None on timeout."""
+        while True:
+            end = self.rx.find(b"\x00")
+            if end < 0:
+                data = self.port.read(max(1, self.port.in_waiting))
+                if not data:
+                    return None
+                self.rx += data
+                continue
+            encoded = bytes(self.rx[:end])
+            del self.rx[:end + 1]
+            if not encoded:
+                continue
+            raw = cobs_decode(encoded)
+            # Frames failing the CRC are debug text or noise
+            if raw is None or len(raw) < 4 or crc16(raw[:-2]) != struct.unpack("<H", raw[-2:])[0]:
+                continue
+            return raw[0], raw[1], raw[2:-2]
+
+    def request(self, msg_type, payload=b""):
+        seq = self.send(msg_type, payload)
+        while True:
+            frame = self.receive()
+            if frame is None:
+                raise RuntimeError("Timeout waiting for reply")
+            if frame[1] == seq:
+                return check(frame)
+
+    def ping(self):
+        _, _, payload = self.request(MSG_PING)
+        version, presets, size = struct.unpack("<BBH", payload)
+        return version, presets, size
+
+    def get(self, param, ch=0):
+        _, _, payload = self.request(MSG_GET_PARAM, bytes([param, ch]))
+        return struct.unpack("<i", payload[2:6])[0]
+
+    def set(self, param, ch, value):
+        _, _, payload = self.request(MSG_SET_PARAM, bytes([param, ch]) + struct.pack("<i", value))
+        return struct.unpack("<i", payload[2:6])[0]
+
+    def backup(self):
+        _, presets, size = self.ping()
+        data = bytearray(presets * size)
+        seq = self.send(MSG_READ_PRESETS, bytes([0, presets]))
+        while True:
+            frame = self.receive()
+            if frame is None:
+                raise RuntimeError("Timeout during backup")
+            msg_type, frame_seq, payload = check(frame)
+            if frame_seq != seq:
+                continue
+            if msg_type == MSG_ACK:
+                return size, bytes(data)
+            slot, offset = struct.unpack("<BH", payload[:3])
+            start = slot * size + offset
+            data[start:start + len(payload) - 3] = payload[3:]
+
+    def restore(self, data):
+        _, presets, size = self.ping()
+        if len(data) % presets != 0 or len(data) > presets * size:
+            raise RuntimeError(f"Backup size {len(data)} does not match {presets} presets of {size} bytes")
+        # Backups of older firmwares have shorter presets, the module defaults the fields they lack
+        old = len(data) // presets
+        data = b"".join(data[slot * old:(slot + 1) * old] + bytes(size - old) for slot in range(presets))
+        # Chunks are streamed without waiting, the module acks each completed preset
+        for slot in range(presets):
+            for offset in range(0, size, CHUNK_SIZE):
+                chunk = data[slot * size + offset:slot * size + min(offset + CHUNK_SIZE, size)]
+                seq = self.send(MSG_PRESET_CHUNK, struct.pack("<BH", slot, offset) + chunk)
+        acks = 0
+        while acks < presets:
+            frame = self.receive()
+            if frame is None:
+                raise RuntimeError("Timeout during restore")
+            if check(frame)[0] == MSG_ACK:
+                acks += 1
+
+    def trace(self, clear=False, cv=False):
+        events = []
+        seq = self.send(MSG_READ_TRACE, bytes([1 if clear else 0, 1 if cv else 0]))
+        while True:
+            frame = self.receive()
+            if frame is None:
+                raise RuntimeError("Timeout reading the trace")
+            msg_type, frame_seq, payload = check(frame)
+            if frame_seq != seq:
+                continue
+            if msg_type == MSG_ACK:
+                return events
+            for offset in range(2, len(payload), 7):
+                events.append(struct.unpack("<IBH", payload[offset:offset + 7]))
+
+    def cv_source(self, source):
+        self.request(MSG_CV_SOURCE, bytes([CV_SOURCES[source]]))
+
+    def cv_load(self, samples):
+        for first in range(0, len(samples), TRACE_EVENTS):
+            chunk = b"".join(struct.pack("<IBH", *sample) for sample in samples[first:first + TRACE_EVENTS])
+            self.request(MSG_CV_SAMPLES, struct.pack("<H", first) + chunk)
+
+    def groove(self, offsets=None):
+        if offsets is None:
+            _, _, payload = self.request(MSG_GROOVE)
+            return list(payload[1:1 + payload[0]])
+        self.request(MSG_GROOVE, bytes([len(offsets)] + offsets))
+        return offsets
+
+    def stats(self, reset=False):
+        """Loop stats since the last reset, restarted afterwards with reset."""
+        stats = {"boot": self.get(param_id("BootTime")), "duty": self.get(param_id("LoopDuty")) / 100, "tasks": {}, "i2c": {}}
+        for ch, task in enumerate(TASKS):
+            stats["tasks"][task] = [self.get(param_id(param), ch) for param in
+                                    ("TaskRuns", "TaskMisses", "TaskMaxLateness", "TaskMaxDuration")]
+        for ch, client in enumerate(I2C_CLIENTS):
+            stats["i2c"][client] = [self.get(param_id(param), ch) for param in
+                                    ("I2CSent", "I2CDropped", "I2CDepth", "I2CMaxDepth", "I2CMaxWait")]
+        if reset:
+            self.set(param_id("LoopDuty"), 0, 0)
+        return stats
+
+    def monitor(self):
+        self.request(MSG_STREAM, b"\x01")
+        try:
+            while True:
+                frame = self.receive()
+                if frame is None or frame[0] != MSG_PARAM:
+                    continue
+                param, ch, value = struct.unpack("<BBi", frame[2])
+                name = PARAMS[param] if param < len(PARAMS) else str(param)
+                print(f"{name}[{ch}] = {value}")
+        finally:
+            self.request(MSG_STREAM, b"\x00")
+
+
+def write_vcd(events, f, channels=TRACE_CHANNELS):
+    """Write (time us, channel, value) events like WriteVCD() in lib/trace.hpp."""
+    f.write("$timescale 1us $end\n$scope module forge $end\n")
+    for i, (name, width) in enumerate(channels):
+        f.write(f"$var wire {width} {chr(33 + i)} {name} $end\n")
+    f.write("$upscope $end\n$enddefinitions $end\n")
+    time = 0
+    last = events[0][0] if events else 0
+    first = True
+    for event_time, channel, value in events:
+        if channel >= len(channels):
+            continue
+        if first or event_time != last:
+            time += (event_time - last) & 0xFFFFFFFF  # Unwrapped
+            last = event_time
+            f.write(f"#{time}\n")
+            first = False
+        width = channels[channel][1]
+        if width == 1:
+            f.write(f"{1 if value else 0}{chr(33 + channel)}\n")
+        else:
+            f.write(f"b{value:0{width}b} {chr(33 + channel)}\n")
+
+
+def write_csv(events, f):
+    """Write (time us, channel, value) events as a CSV recording, as LoadCVRecording() in lib/cvreplay.hpp reads."""
+    writer = csv.writer(f, lineterminator="\n")
+    writer.writerow(["time", "input", "value"])
+    writer.writerows(events)
+
+
+def read_csv(f):
+    return [(int(row[0]), int(row[1]), int(row[2])) for row in csv.reader(f) if row and row[0].isdigit()]
+
+
+def check(frame):
+    if frame[0] == MSG_NACK:
+        raise RuntimeError(f"Request rejected: {ERRORS.get(frame[2][1], frame[2][1])}")
+    return frame
+
+
+def param_id(name):
+    for i, param in enumerate(PARAMS):
+        if param.lower() == name.lower():
+            return i
+    raise argparse.ArgumentTypeError(f"Unknown parameter {name}, one of: {', '.join(PARAMS)}")
+
+
+def param_value(text):
+    """Integer value, or a multiply:divide custom ratio for the Divider parameter."""
+    if ":" in text:
+        multiply, divide = (int(part) for part in text.split(":", 1))
+        if not (1 <= multiply <= MAX_RATIO and 1 <= divide <= MAX_RATIO):
+            raise argparse.ArgumentTypeError(f"Ratio terms must be from 1 to {MAX_RATIO}")
+        return DIVIDER_AMOUNT + (multiply - 1) * MAX_RATIO + divide - 1
+    return int(text)
+
+
+def main():
+    parser = argparse.ArgumentParser(description="ClockForge serial protocol client")
+    parser.add_argument("-p", "--port", required=True, help="Serial port of the module")
+    commands = parser.add_subparsers(dest="command", required=True)
+    commands.add_parser("ping")
+    get = commands.add_parser("get")
+    get.add_argument("param", type=param_id)
+    get.add_argument("--ch", type=int, default=0, help="Output or CV input index")
+    set_ = commands.add_parser("set")
+    set_.add_argument("param", type=param_id)
+    set_.add_argument("value", type=param_value, help="Value, or multiply:divide for a custom Divider ratio")
+    set_.add_argument("--ch", type=int, default=0, help="Output or CV input index")
+    backup = commands.add_parser("backup")
+    backup.add_argument("file")
+    restore = commands.add_parser("restore")
+    restore.add_argument("file")
+    commands.add_parser("monitor")
+    trace = commands.add_parser("trace")
+    trace.add_argument("file", help="VCD file, or CSV for the raw events")
+    trace.add_argument("--clear", action="store_true", help="Empty the trace after reading it")
+    trace.add_argument("--cv", action="store_true", help="Read the CV input capture instead of the outputs")
+    cv = commands.add_parser("cv")
+    cv.add_argument("action", choices=["live", "replay", "load"], help="Live (captured) inputs, replay the capture or load a CSV recording into it")
+    cv.add_argument("file", nargs="?", help="CSV recording to load")
+    groove = commands.add_parser("groove")
+    groove.add_argument("offsets", nargs="?", help="Delay of each step in 1/192 of a beat, comma separated, prints the user groove without")
+    stats = commands.add_parser("stats")
+    stats.add_argument("--reset", action="store_true", help="Restart the stats after reading them")
+    args = parser.parse_args()
+
+    forge = Forge(args.port)
+    try:
+        if args.command == "ping":
+            version, presets, size = forge.ping()
+            print(f"Protocol v{version}, {presets} presets of {size} bytes")
+        elif args.command == "get":
+            print(forge.get(args.param, args.ch))
+        elif args.command == "set":
+            print(forge.set(args.param, args.ch, args.value))
+        elif args.command == "backup":
+            start = time.monotonic()
+            _, data = forge.backup()
+            with open(args.file, "wb") as f:
+                f.write(data)
+            print(f"Saved {len(data)} bytes in {(time.monotonic() - start) * 1000:.0f}ms")
+        elif args.command == "restore":
+            with open(args.file, "rb") as f:
+                data = f.read()
+            start = time.monotonic()
+            forge.restore(data)
+            print(f"Restored {len(data)} bytes in {(time.monotonic() - start) * 1000:.0f}ms")
+        elif args.command == "monitor":
+            forge.monitor()
+        elif args.command == "trace":
+            events = forge.trace(args.clear, args.cv)
+            with open(args.file, "w") as f:
+                if args.file.endswith(".csv"):
+                    write_csv(events, f)
+                else:
+                    write_vcd(events, f, CV_CHANNELS if args.cv else TRACE_CHANNELS)
+            print(f"Saved {len(events)} events")
+        elif args.command == "cv":
+            if args.action == "load":
+                if not args.file:
+                    raise RuntimeError("cv load needs a CSV recording")
+                with open(args.file, newline="") as f:
+                    samples = read_csv(f)
+                forge.cv_load(samples)
+                print(f"Loaded {len(samples)} samples, start them with: cv replay")
+            else:
+                forge.cv_source(args.action)
+        elif args.command == "groove":
+            offsets = [int(offset) for offset in args.offsets.split(",")] if args.offsets else None
+            print(",".join(str(offset) for offset in forge.groove(offsets)))
+        elif args.command == "stats":
+            stats = forge.stats(args.reset)
+            print(f"Boot to first clock: {stats['boot']}us")
+            print(f"Loop duty cycle: {stats['duty']:.2f}%")
+            print(f"{'task':<10}{'runs':>10}{'misses':>8}{'late us':>9}{'max us':>8}")
+            for task, (runs, misses, late, duration) in stats["tasks"].items():
+                print(f"{task:<10}{runs:>10}{misses:>8}{late:>9}{duration:>8}")
+            print(f"{'i2c':<10}{'sent':>10}{'dropped':>8}{'queued':>9}{'max':>8}{'wait us':>9}")
+            for client, (sent, dropped, depth, max_depth, wait) in stats["i2c"].items():
+                print(f"{client:<10}{sent:>10}{dropped:>8}{depth:>9}{max_depth:>8}{wait:>9}")
+    except (RuntimeError, KeyboardInterrupt) as e:
+        print(e, file=sys.stderr)
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,213 @@
+#pragma once
+#include <utility>
+
+#include "dacramp.hpp"
+#include "outputs.hpp"
+
+#define BEATS_PER_BAR 4
+
+// Boundary a transport command posted to the clock ISR waits for
+enum TransportSync : uint8_t {
+    TransportTick = 0, // Next tick
+    TransportBeat,
+    TransportBar,
+};
+
+// Clock engine: the outputs and the clock state shared by the timer and clock input ISRs
+//
+// Sized at compile time: Size outputs at Ticks pulses per quarter note, the first Gates are gate
+// outputs and the rest DAC outputs. All loops have constant bounds so the compiler can unroll
+// them, and the same code builds the 4 output module or larger expander variants.
+template <int Size, int Ticks, int Gates = Size / 2>
+class ClockEngine {
+  public:
+    static_assert(Gates <= 32, "Gate levels are written as a 32 bit mask");
+
+    static constexpr int OutputCount = Size;
+    static constexpr int GateCount = Gates;
+    static constexpr int TicksPerQuarter = Ticks;
+
+    ClockEngine() : ClockEngine(std::make_index_sequence<Size>()) {}
+
+    Output outputs[Size];
+
+    // Clock tick from the timer ISR, advances all outputs
+    void Tick() {
+        ApplyCommands();
+        if (OnBeat()) {
+            _beatCounter++;
+        }
+        _externalBeat = false;
+        for (int i = 0; i < Gates; i++) {
+            outputs[i].template Pulse<OutputType::DigitalOut, Ticks>(_tickCounter);
+        }
+        for (int i = Gates; i < Size; i++) {
+            outputs[i].template Pulse<OutputType::DACOut, Ticks>(_tickCounter);
+            if (!outputs[i].GetTriggerMode()) {
+                _ramps[i - Gates].Target(outputs[i].template GetOutputLevel<OutputType::DACOut>(), outputs[i].Glides());
+            }
+        }
+        _tickCounter++;
+    }
+
+    // True when the next tick starts a beat: every Ticks ticks, or after each divided pulse of an
+    // external clock whatever the internal timer counted since the last one
+    bool OnBeat() const { return _usingExternalClock ? _externalBeat : _tickCounter % Ticks == 0; }
+    unsigned long GetTickCounter() const { return _tickCounter; }
+    unsigned long GetBeatCounter() const { return _beatCounter; } // Beats since start/reset
+
+    // Restart the counters and the outputs at once, the next tick is the first of a beat
+    void Reset() {
+        _tickCounter = 0;
+        _beatCounter = 0;
+        _externalBeat = true;
+        _externalTickCounter = 0;
+        for (int i = 0; i < Size; i++) {
+            outputs[i].Restart();
+        }
+    }
+
+    // Transport commands from the loop or an interrupt. The clock ISR applies them at the start of
+    // the first tick on the sync boundary, so all outputs reset, stop or start on the same tick. A
+    // newer command of the same kind replaces the pending one.
+    void PostReset(TransportSync sync) { _pendingReset = CommandPending | sync; }
+    void PostMasterState(bool state, TransportSync sync) { _pendingState = CommandPending | (state ? CommandOn : 0) | sync; }
+    bool CommandsPending() const { return _pendingReset || _pendingState; }
+
+    // Write the output levels and generate the triggered envelopes (main loop).
+    // All gate levels go to writeGates at once (bit i is gate i) so their edges coincide.
+    template <typename GateWriter, typename Writer>
+    void WriteOutputs(GateWriter writeGates, Writer write) {
+        writeGates(GateLevels());
+        for (int i = Gates; i < Size; i++) {
+            write(i, outputs[i].template GetOutputLevel<OutputType::DACOut>());
+            outputs[i].GenEnvelope();
+        }
+    }
+
+    // Write the gate levels and generate the triggered envelopes (main loop) when Refresh() writes
+    // the DAC outputs
+    template <typename GateWriter>
+    void WriteGates(GateWriter writeGates) {
+        writeGates(GateLevels());
+        for (int i = Gates; i < Size; i++) {
+            outputs[i].GenEnvelope();
+            if (outputs[i].GetTriggerMode()) {
+                int level = outputs[i].template GetOutputLevel<OutputType::DACOut>();
+                noInterrupts(); // The refresh timer reads the ramp
+                _ramps[i - Gates].Target(level, false);
+                interrupts();
+            }
+        }
+    }
+
+    // Fixed rate DAC refresh (timer ISR): the clocked waveforms glide between their tick levels,
+    // write(i, level) is only called when the level of output i changed
+    template <typename Writer>
+    void Refresh(Writer write) {
+        for (int i = Gates; i < Size; i++) {
+            int level;
+            if (_ramps[i - Gates].Next(_refreshStep, level)) {
+                write(i, level);
+            }
+        }
+    }
+
+    // Ramp phase advance per refresh, from RampStep() with the tick period of the tempo
+    void SetRefreshStep(uint32_t step) { _refreshStep = step; }
+
+    // Master play/stop
+    bool GetMasterState() const { return _masterState; }
+    void SetMasterState(bool state) {
+        _masterState = state;
+        for (int i = 0; i < Size; i++) {
+            outputs[i].SetMasterState(state);
+        }
+    }
+    void ToggleMasterState() { SetMasterState(!_masterState); }
+
+    // External clock pulse from the clock input ISR, divided by divider.
+    // Returns true when the pulse advanced the outputs.
+    bool ExternalClock(int divider) {
+        if (_externalTickCounter++ % divider != 0) {
+            return false;
+        }
+        noInterrupts(); // Critical section
+        for (int i = 0; i < Size; i++) {
+            outputs[i].SetExternalClock(true);
+            outputs[i].IncrementInternalCounter();
+        }
+        _usingExternalClock = true;
+        _tickCounter = 0;
+        _externalBeat = true;
+        interrupts();
+        return true;
+    }
+
+    // Back to the internal clock
+    void ExternalClockLost() {
+        _usingExternalClock = false;
+        for (int i = 0; i < Size; i++) {
+            outputs[i].SetExternalClock(false);
+        }
+    }
+    bool UsingExternalClock() const { return _usingExternalClock; }
+
+  private:
+    static constexpr uint8_t CommandPending = 0x80;
+    static constexpr uint8_t CommandOn = 0x40; // Master state to set
+    static constexpr uint8_t CommandSync = 0x03;
+    volatile uint8_t _pendingReset = 0;
+    volatile uint8_t _pendingState = 0;
+
+    DACRamp _ramps[Size > Gates ? Size - Gates : 1];
+    volatile uint32_t _refreshStep = RAMP_ONE;
+    volatile unsigned long _tickCounter = 0;
+    volatile unsigned long _beatCounter = 0;
+    volatile unsigned long _externalTickCounter = 0;
+    volatile bool _externalBeat = false; // A divided external pulse started a beat, cleared by its tick
+    volatile bool _usingExternalClock = false;
+    bool _masterState = true; // true = playing, false = stopped
+
+    // True when the coming tick is on the boundary, bars as the scene switches count them
+    bool OnSync(uint8_t sync) const {
+        switch (sync) {
+        case TransportBeat:
+            return OnBeat();
+        case TransportBar:
+            return OnBeat() && _beatCounter % BEATS_PER_BAR == 0;
+        default:
+            return true;
+        }
+    }
+
+    // Pending transport commands due on this tick, the state first so a start and reset on the
+    // same boundary starts from the first step
+    void ApplyCommands() {
+        uint8_t state = _pendingState;
+        if (state && OnSync(state & CommandSync)) {
+            _pendingState = 0;
+            SetMasterState(state & CommandOn);
+        }
+        uint8_t reset = _pendingReset;
+        if (reset && OnSync(reset & CommandSync)) {
+            _pendingReset = 0;
+            Reset();
+        }
+    }
+
+    // Gate levels as a mask, bit i is gate i
+    uint32_t GateLevels() {
+        uint32_t gates = 0;
+        for (int i = 0; i < Gates; i++) {
+            if (outputs[i].template GetOutputLevel<OutputType::DigitalOut>()) {
+                gates |= 1ul << i;
+            }
+        }
+        return gates;
+    }
+
+    // Output IDs start at 1, gate outputs first
+    template <size_t... I>
+    ClockEngine(std::index_sequence<I...>) : outputs{Output(I + 1, I < Gates ? OutputType::DigitalOut : OutputType::DACOut)...} {}
+};
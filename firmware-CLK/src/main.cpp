@@ -1,4 +1,5 @@
 #include <Arduino.h>
+#include <TimerTC3.h>
 #include <TimerTCC0.h>
 // Rotary encoder setting
 #define ENCODER_OPTIMIZE_INTERRUPTS
@@ -10,11 +11,23 @@
 
 // Load local libraries
 #include "boardIO.hpp"
+#include "cvadc.hpp"
+#include "cvgate.hpp"
+#include "cvreplay.hpp"
+#include "cvtarget.hpp"
 #include "definitions.hpp"
+#include "engine.hpp"
+#include "fastdisplay.hpp"
 #include "loadsave.hpp"
+#include "menu.hpp"
 #include "outputs.hpp"
+#include "parameters.hpp"
 #include "pinouts.hpp"
+#include "protocol.hpp"
+#include "scenes.hpp"
+#include "scheduler.hpp"
 #include "splash.hpp"
+#include "tempo.hpp"
 #include "version.hpp"
 
 // ADC Calibration settings
@@ -25,63 +38,26 @@ int ADCOffset[2] = {23, 23};        // ADC offset for the channels
 // Configuration
 #define PPQN 192
 #define MAXDAC 4095
+#define DAC_REFRESH_MICROS 500 // 2 kHz DAC refresh, whatever the tempo
 
 #define OLED_ADDRESS 0x3C
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
 
 // OLED display object
-Adafruit_SSD1306 display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
+FastDisplay display(SCREEN_WIDTH, SCREEN_HEIGHT, &Wire, -1);
 
 // Rotary encoder object
 Encoder encoder(ENC_PIN_1, ENC_PIN_2); // rotary encoder library setting
 float oldPosition = -999;              // rotary encoder library setting
 float newPosition = -999;              // rotary encoder library setting
 
-// Output objects
-Output outputs[NUM_OUTPUTS] = {
-    Output(1, OutputType::DigitalOut),
-    Output(2, OutputType::DigitalOut),
-    Output(3, OutputType::DACOut),
-    Output(4, OutputType::DACOut)};
+// Clock engine with the output objects
+ClockEngine<NUM_OUTPUTS, PPQN, NUM_GATE_OUTS> engine;
+Output (&outputs)[NUM_OUTPUTS] = engine.outputs;
 
 // ---- Global variables ----
 
-// CV modulation targets
-enum CVTarget {
-    None = 0,
-    StartStop,
-    Reset,
-    SetBPM,
-    Div1,
-    Div2,
-    Div3,
-    Div4,
-    Output1Prob,
-    Output2Prob,
-    Output3Prob,
-    Output4Prob,
-    Swing1Amount,
-    Swing1Every,
-    Swing2Amount,
-    Swing2Every,
-    Swing3Amount,
-    Swing3Every,
-    Swing4Amount,
-    Swing4Every,
-    Output3Level,
-    Output4Level,
-    Output3Offset,
-    Output4Offset,
-    Output3Waveform,
-    Output4Waveform,
-    Output1Duty,
-    Output2Duty,
-    Output3Duty,
-    Output4Duty,
-    Envelope1,
-    Envelope2,
-};
 
 String CVTargetDescription[] = {
     "None",
@@ -116,9 +92,9 @@ String CVTargetDescription[] = {
     "Output 4 Duty",
     "Output 3 Env",
     "Output 4 Env",
+    "Scene Select",
 };
-int CVTargetLength = sizeof(CVTargetDescription) / sizeof(CVTargetDescription[0]);
-CVTarget pendingCVInputTarget[NUM_CV_INS] = {CVTarget::None, CVTarget::None};
+const int CVTargetLength = sizeof(CVTargetDescription) / sizeof(CVTargetDescription[0]);
 
 // ADC input offset and scale from calibration
 float offsetScale[NUM_CV_INS][2]; // [channel][0: offset, 1: scale]
@@ -128,7 +104,28 @@ int CVInputAttenuation[NUM_CV_INS] = {0, 0};
 int CVInputOffset[NUM_CV_INS] = {0, 0};
 
 // ADC input variables
-float channelADC[NUM_CV_INS], oldChannelADC[NUM_CV_INS];
+float channelADC[NUM_CV_INS];
+CVTargetState cvTargetStates[NUM_CV_INS];
+
+// Gate-type targets are detected in the ADC interrupt on every conversion, not in the CV task
+GateDetector cvGates[NUM_CV_INS];
+
+// Settings the gate thresholds of an input were computed for
+struct CVGateSettings {
+    bool configured;
+    bool enabled;
+    CVTarget target;
+    int attenuation;
+    int offset;
+    int adcOffset;
+    float adcCal;
+};
+CVGateSettings cvGateSettings[NUM_CV_INS] = {};
+
+// CV input capture of the latest raw ADC values and its replay
+TraceRecorder<CV_CAPTURE_SAMPLES> cvCapture;
+CVPlayer cvPlayer;
+int cvSamplesLoaded = 0; // Samples of a recording being loaded
 
 // BPM and clock settings
 unsigned int BPM = 120;
@@ -136,29 +133,26 @@ unsigned int lastInternalBPM = 120;
 unsigned int const minBPM = 10;
 unsigned int const maxBPM = 300;
 
-// Play/Stop state
-bool masterState = true; // Track global play/stop state (true = playing, false = stopped)
-
-// Global tick counter
-volatile unsigned long tickCounter = 0;
-
 // External clock variables
-volatile unsigned long clockInterval = 0;
-volatile unsigned long lastClockInterruptTime = 0;
-volatile bool usingExternalClock = false;
+volatile unsigned long lastClockInterruptTime = 0; // us
 
 static int const dividerAmount = 7;
 int externalClockDividers[dividerAmount] = {1, 2, 4, 8, 16, 24, 48};
 String externalDividerDescription[dividerAmount] = {"x1", "/2 ", "/4", "/8", "/16", "24PPQN", "48PPQN"};
 int externalDividerIndex = 0;
-volatile unsigned long externalTickCounter = 0;
+
+// Reset and start/stop quantization
+TransportSync transportSync = TransportTick;
+String TransportSyncDescriptions[] = {"TICK", "BEAT", "BAR"};
+const int TransportSyncLength = sizeof(TransportSyncDescriptions) / sizeof(TransportSyncDescriptions[0]);
+
+// Tempo estimation for tap tempo (200ms-2s between taps) and the clock input (1ms-2s between pulses, the debounce time)
+TempoEstimator tapTempo(200000, 2000000);
+TempoEstimator clockTempo(1000, 2000000);
 
 // Menu variables
-int menuItems = 61;
-int menuItem = 3;
 bool switchState = 1;
 bool oldSwitchState = 1;
-int menuMode = 0;                    // Menu mode for parameter editing
 bool displayRefresh = 1;             // Display refresh flag
 bool unsavedChanges = false;         // Unsaved changes flag
 int euclideanOutputSelect = 0;       // Euclidean rhythm output index
@@ -166,12 +160,31 @@ int envelopeOutputSelect = 2;        // Envelope output index
 int saveSlot = 0;                    // Save slot index
 unsigned long lastEncoderUpdate = 0; // Last encoder update time
 
+// Boot screens, shown by the display task while the clock already runs
+#define BOOT_SPLASH_MS 2000
+#define BOOT_NAME_MS 1500
+enum BootScreen {
+    BootSplash,
+    BootName,
+    BootDone,
+};
+BootScreen bootScreen = BootSplash;
+unsigned long bootScreenTime = 0;            // Time (ms) the boot screen was shown
+volatile unsigned long firstClockMicros = 0; // Time (us) of the first clock tick since reset, 0 before it
+
+// Message shown by the display task instead of the menu (saved, loaded)
+#define MESSAGE_MS 1000
+const char *message = nullptr; // nullptr when none
+bool messageDrawn = false;
+unsigned long messageTime = 0; // Time (ms) the message was drawn
+
+// Loop tasks, added in setup()
+Scheduler scheduler(micros);
+
 // Function prototypes
 void UpdateBPM(unsigned int);
+void UpdateTempo(float);
 void SetTapTempo();
-void HandleIO();
-void SetMasterState(bool);
-void ToggleMasterState();
 void HandleEncoderClick();
 void HandleEncoderPosition();
 void UpdateSpeedFactor();
@@ -179,13 +192,390 @@ void HandleDisplay();
 void HandleExternalClock();
 void HandleCVInputs();
 void HandleCVTarget(int, float, CVTarget);
+void HandleCVGate(int, uint16_t);
+void HandleCVSample(int, uint16_t);
 void HandleOutputs();
 void ClockPulse();
+void DACRefresh();
 void InitializeTimer();
 void UpdateParameters(LoadSaveParams);
+void HandleSceneSwitch();
+void HandleSerial();
+void HandleEncoder();
 
 // ----------------------------------------------
 
+// ---- Menu ----
+
+// Output of a menu item, the Euclidean and envelope pages edit the output selected on the page
+#define MENU_EUCLIDEAN_OUTPUT 0xFE
+#define MENU_ENVELOPE_OUTPUT 0xFF
+Output &MenuOutput(int arg) {
+    if (arg == MENU_EUCLIDEAN_OUTPUT) {
+        return outputs[euclideanOutputSelect];
+    } else if (arg == MENU_ENVELOPE_OUTPUT) {
+        return outputs[envelopeOutputSelect];
+    }
+    return outputs[arg];
+}
+
+// Output parameter accessors for the menu table
+template <int (Output::*Get)()>
+int32_t GetOutput(int arg) { return (MenuOutput(arg).*Get)(); }
+template <bool (Output::*Get)()>
+int32_t GetOutput(int arg) { return (MenuOutput(arg).*Get)(); }
+template <float (Output::*Get)()>
+int32_t GetOutput(int arg) { return lroundf((MenuOutput(arg).*Get)()); }
+template <void (Output::*Set)(int)>
+void SetOutput(int arg, int32_t value) { (MenuOutput(arg).*Set)(value); }
+template <void (Output::*Set)(bool)>
+void SetOutput(int arg, int32_t value) { (MenuOutput(arg).*Set)(value); }
+template <void (Output::*Set)(float)>
+void SetOutput(int arg, int32_t value) { (MenuOutput(arg).*Set)(value); }
+
+int32_t GetWaveform(int arg) { return outputs[arg].GetWaveformType(); }
+void SetWaveform(int arg, int32_t value) { outputs[arg].SetWaveformType(static_cast<WaveformType>(value)); }
+int32_t GetCurve(int arg) { return lroundf(MenuOutput(arg).GetCurve() * 100); }
+void SetCurve(int arg, int32_t value) { MenuOutput(arg).SetCurve(value / 100.0f); }
+
+// Global settings accessors
+int32_t GetBPM(int) { return BPM; }
+void ChangeBPM(int, int32_t value) { UpdateBPM(value); }
+int32_t GetMasterState(int) { return engine.GetMasterState(); }
+void SetMasterState(int, int32_t value) { engine.PostMasterState(value, transportSync); }
+int32_t GetExternalDivider(int) { return externalDividerIndex; }
+void SetExternalDivider(int, int32_t value) { externalDividerIndex = value; }
+int32_t GetEuclideanOutput(int) { return euclideanOutputSelect; }
+void SetEuclideanOutput(int, int32_t value) { euclideanOutputSelect = value; }
+int32_t GetEnvelopeOutput(int) { return envelopeOutputSelect; }
+void SetEnvelopeOutput(int, int32_t value) { envelopeOutputSelect = value; }
+int32_t GetCVTarget(int arg) { return CVInputTarget[arg]; }
+void SetCVTarget(int arg, int32_t value) { CVInputTarget[arg] = static_cast<CVTarget>(value); }
+int32_t GetCVAttenuation(int arg) { return CVInputAttenuation[arg]; }
+void SetCVAttenuation(int arg, int32_t value) { CVInputAttenuation[arg] = value; }
+int32_t GetCVOffset(int arg) { return CVInputOffset[arg]; }
+void SetCVOffset(int arg, int32_t value) { CVInputOffset[arg] = value; }
+int32_t GetSceneSync(int) { return sceneSync; }
+void SetSceneSync(int, int32_t value) { sceneSync = static_cast<SceneSync>(value); }
+int32_t GetTransportSync(int) { return transportSync; }
+void SetTransportSync(int, int32_t value) { transportSync = static_cast<TransportSync>(value); }
+int32_t GetSaveSlot(int) { return saveSlot; }
+void SetSaveSlot(int, int32_t value) { saveSlot = value; }
+
+// Both CV inputs can't modulate the same target
+bool AcceptCVTarget(int arg, int32_t value) {
+    return value == CVTarget::None || value != CVInputTarget[1 - arg];
+}
+
+// Show a message for a second, drawn by the display task
+void ShowMessage(const char *text) {
+    message = text;
+    messageDrawn = false;
+}
+
+void TapTempo(int, int32_t) {
+    SetTapTempo();
+}
+
+void SaveSettings(int, int32_t) {
+    LoadSaveParams p;
+    p.valid = true;
+    p.version = PRESET_VERSION;
+    p.BPM = BPM;
+    p.externalClockDivIdx = externalDividerIndex;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        p.divIdx[i] = outputs[i].GetDividerIndex();
+        p.dutyCycle[i] = outputs[i].GetDutyCycle();
+        p.outputState[i] = outputs[i].GetOutputState();
+        p.outputLevel[i] = outputs[i].GetLevel();
+        p.outputOffset[i] = outputs[i].GetOffset();
+        p.swingIdx[i] = outputs[i].GetSwingAmountIndex();
+        p.swingEvery[i] = outputs[i].GetSwingEvery();
+        p.pulseProbability[i] = outputs[i].GetPulseProbability();
+        p.euclideanParams[i] = outputs[i].GetEuclideanParams();
+        p.phaseShift[i] = outputs[i].GetPhase();
+        p.waveformType[i] = int(outputs[i].GetWaveformType());
+        p.envParams[i] = outputs[i].GetEnvelopeParams();
+        p.groove[i] = outputs[i].GetGroove();
+    }
+    p.userGroove = Output::GetUserGroove();
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        p.CVInputTarget[i] = CVInputTarget[i];
+        p.CVInputAttenuation[i] = CVInputAttenuation[i];
+        p.CVInputOffset[i] = CVInputOffset[i];
+    }
+    Save(p, saveSlot);
+    StoreScene(p, saveSlot);
+    unsavedChanges = false;
+    ShowMessage("SAVED");
+}
+
+void LoadSettings(int, int32_t) {
+    // Switch to the pre-decoded scene on the next beat/bar, slots without a scene are loaded directly
+    if (!RequestScene(saveSlot)) {
+        LoadSaveParams p = Load(saveSlot);
+        UpdateParameters(p);
+    }
+    unsavedChanges = false;
+    ShowMessage("LOADED");
+}
+
+void LoadDefaults(int, int32_t) {
+    LoadSaveParams p = LoadDefaultParams();
+    UpdateParameters(p);
+    unsavedChanges = false;
+    ShowMessage("LOADED");
+}
+
+// Value formatters, print at the display cursor
+void PrintNumber(int, int32_t value) { display.print(value); }
+void PrintIndex(int, int32_t value) { display.print(value + 1); }
+void PrintPercent(int, int32_t value) {
+    display.print(value);
+    display.print("%");
+}
+void PrintOnOff(int, int32_t value) { display.print(value ? "ON" : "OFF"); }
+void PrintYesNo(int, int32_t value) { display.print(value ? "YES" : "NO"); }
+template <String (Output::*Describe)()>
+void PrintOutput(int arg, int32_t) { display.print((MenuOutput(arg).*Describe)()); }
+void PrintWaveform(int, int32_t value) { display.printLabel(WaveformTypeDescriptions[value].c_str()); }
+void PrintExternalDivider(int, int32_t value) { display.print(externalDividerDescription[value]); }
+void PrintCVTarget(int, int32_t value) { display.printLabel(CVTargetDescription[value].c_str()); }
+void PrintSceneSync(int, int32_t value) { display.print(SceneSyncDescriptions[value]); }
+void PrintTransportSync(int, int32_t value) { display.print(TransportSyncDescriptions[value]); }
+void PrintTapTempo(int, int32_t) { display.print(" (" + String(BPM) + " BPM)"); }
+void PrintSaveSlot(int, int32_t value) {
+    display.print(value);
+    if (pendingScene != nullptr) {
+        display.print(" *");
+    }
+}
+
+// BPM, play state and a box per output showing if it's enabled with its divider
+void DrawMainPage(int selected) {
+    String s = String(BPM) + "BPM";
+    display.setTextSize(3);
+    // Centralize the BPM display
+    display.setCursor((SCREEN_WIDTH - (s.length() * 18)) / 2, 0);
+    display.print(s);
+    if (engine.UsingExternalClock()) {
+        display.setTextSize(1);
+        display.setCursor(120, 24);
+        display.print("E");
+    }
+
+    display.setTextSize(2);
+    display.setCursor(44, 27);
+    if (selected == 1) {
+        display.drawLine(43, 42, 88, 42, 1);
+    }
+    if (!engine.GetMasterState()) {
+        display.fillRoundRect(23, 26, 17, 17, 2, 1);
+        display.print("STOP");
+    } else {
+        display.fillTriangle(23, 26, 23, 42, 39, 34, 1);
+        display.print("PLAY");
+    }
+
+    display.setTextSize(1);
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        if (outputs[i].GetOutputState()) {
+            display.fillRect((i * 30) + 14, 46, 9, 9, WHITE);
+            display.setCursor((i * 30) + 16, 47);
+            display.setTextColor(BLACK);
+            display.print(i + 1);
+        } else {
+            display.drawRect((i * 30) + 14, 46, 9, 9, WHITE);
+            display.setCursor((i * 30) + 16, 47);
+            display.setTextColor(WHITE);
+            display.print(i + 1);
+        }
+        display.setTextColor(WHITE);
+        String s = outputs[i].GetDividerDescription();
+        display.setCursor((i * 30) + 13 + (6 - (s.length() * 3)), 56);
+        display.print(s);
+    }
+}
+
+// Pattern of the selected output
+void DrawEuclideanPage(int) {
+    Output &output = outputs[euclideanOutputSelect];
+    if (!output.GetEuclidean()) {
+        return;
+    }
+    display.fillTriangle(90, 10, 94, 10, 92, 14, WHITE);
+    int yPosition = 15;
+    int euclideanSteps = output.GetEuclideanSteps();
+    int euclideanPadding = output.GetEuclideanPadding();
+    for (int i = 0; i < euclideanSteps + euclideanPadding && i < 47; i++) {
+        int x = 90 + (i / 8) * 6;
+        int y = yPosition + (i % 8) * 6;
+        if (i < euclideanSteps && output.GetRhythmStep(i)) {
+            display.fillRect(x, y, 5, 5, WHITE);
+        } else {
+            display.drawRect(x, y, 5, 5, WHITE);
+            if (i >= euclideanSteps) {
+                display.writePixel(x + 2, y + 2, WHITE);
+            }
+        }
+    }
+    if (euclideanSteps + euclideanPadding > 47) {
+        display.fillTriangle(120, 57, 124, 57, 122, 61, WHITE);
+    }
+}
+
+// Column titles of the two value pages, the edited column is marked
+void DrawSwingPage(int selected) {
+    display.setCursor(64, 20);
+    display.print("AMT");
+    display.setCursor(94, 20);
+    display.print("EVERY");
+    if (selected % 2 == 0) {
+        display.fillTriangle(59, 20, 59, 26, 62, 23, 1);
+    } else {
+        display.fillTriangle(89, 20, 89, 26, 92, 23, 1);
+    }
+}
+
+void DrawLevelPage(int selected) {
+    display.setCursor(70, 12);
+    display.print("LVL");
+    display.setCursor(100, 12);
+    display.print("OFF");
+    if (selected == 0 || selected == 2) {
+        display.fillTriangle(65, 12, 65, 18, 68, 15, 1);
+    } else if (selected == 1 || selected == 3) {
+        display.fillTriangle(95, 12, 95, 18, 98, 15, 1);
+    }
+}
+
+void DrawCVPage(int selected) {
+    display.setCursor(60, 38);
+    display.print("ATTN");
+    display.setCursor(100, 38);
+    display.print("OFF");
+    if (selected == 2 || selected == 4) {
+        display.fillTriangle(55, 38, 55, 44, 58, 41, 1);
+    } else if (selected == 3 || selected == 5) {
+        display.fillTriangle(95, 38, 95, 44, 98, 41, 1);
+    }
+}
+
+const MenuPage menuPages[] = {
+    {nullptr, 2, DrawMainPage},
+    {"CLOCK DIVIDERS", 5, nullptr},
+    {"OUTPUT STATE", 4, nullptr},
+    {"PROBABILITY", 4, nullptr},
+    {"EUCLIDEAN RHYTHM", 6, DrawEuclideanPage},
+    {"OUTPUT SWING", 8, DrawSwingPage},
+    {"OUTPUT GROOVE", 4, nullptr},
+    {"PHASE SHIFT", 4, nullptr},
+    {"OUTPUT SETTINGS", 4, nullptr},
+    {"OUTPUT SETTINGS", 6, DrawLevelPage},
+    {"ENVELOPE SETTINGS", 7, nullptr},
+    {"CV INPUT TARGETS", 6, DrawCVPage},
+    {nullptr, 7, nullptr},
+};
+
+#define E MenuKind::Edit
+#define S MenuKind::Select
+#define A MenuKind::Action
+#define EUC MENU_EUCLIDEAN_OUTPUT
+#define ENV MENU_ENVELOPE_OUTPUT
+// clang-format off
+const MenuItem menuItems[] = {
+    // label            x   y  value cursor arg kind flags                   min  max                            step get                                        set                                          print                                      accept
+    // Main page
+    {nullptr,           0,  7,  0,  2,  0,  E, MENU_PRESET,             minBPM, maxBPM,                      1, GetBPM,                                    ChangeBPM,                                   nullptr,                                         nullptr},
+    {nullptr,           0,  0,  0,  MENU_NO_CURSOR, 0, A, 0,            0,   1,                              1, GetMasterState,                            SetMasterState,                              nullptr,                                         nullptr},
+    // Clock dividers
+    {"OUTPUT 1:",       10, 20, 84, 1,  0,  E, MENU_PRESET,             0,   Output::DividerAmount - 1,      1, GetOutput<&Output::GetDividerIndex>,       SetOutput<&Output::SetDivider>,              PrintOutput<&Output::GetDividerDescription>,     nullptr},
+    {"OUTPUT 2:",       10, 29, 84, 1,  1,  E, MENU_PRESET,             0,   Output::DividerAmount - 1,      1, GetOutput<&Output::GetDividerIndex>,       SetOutput<&Output::SetDivider>,              PrintOutput<&Output::GetDividerDescription>,     nullptr},
+    {"OUTPUT 3:",       10, 38, 84, 1,  2,  E, MENU_PRESET,             0,   Output::DividerAmount - 1,      1, GetOutput<&Output::GetDividerIndex>,       SetOutput<&Output::SetDivider>,              PrintOutput<&Output::GetDividerDescription>,     nullptr},
+    {"OUTPUT 4:",       10, 47, 84, 1,  3,  E, MENU_PRESET,             0,   Output::DividerAmount - 1,      1, GetOutput<&Output::GetDividerIndex>,       SetOutput<&Output::SetDivider>,              PrintOutput<&Output::GetDividerDescription>,     nullptr},
+    {"EXT. DIV:",       10, 56, 84, 1,  0,  E, MENU_PRESET,             0,   dividerAmount - 1,              1, GetExternalDivider,                        SetExternalDivider,                          PrintExternalDivider,                            nullptr},
+    // Output state
+    {"OUTPUT 1:",       10, 20, 70, 1,  0,  A, MENU_PRESET,             0,   1,                              1, GetOutput<&Output::GetOutputState>,        SetOutput<&Output::SetOutputState>,          PrintOnOff,                                      nullptr},
+    {"OUTPUT 2:",       10, 29, 70, 1,  1,  A, MENU_PRESET,             0,   1,                              1, GetOutput<&Output::GetOutputState>,        SetOutput<&Output::SetOutputState>,          PrintOnOff,                                      nullptr},
+    {"OUTPUT 3:",       10, 38, 70, 1,  2,  A, MENU_PRESET,             0,   1,                              1, GetOutput<&Output::GetOutputState>,        SetOutput<&Output::SetOutputState>,          PrintOnOff,                                      nullptr},
+    {"OUTPUT 4:",       10, 47, 70, 1,  3,  A, MENU_PRESET,             0,   1,                              1, GetOutput<&Output::GetOutputState>,        SetOutput<&Output::SetOutputState>,          PrintOnOff,                                      nullptr},
+    // Pulse probability
+    {"OUTPUT 1:",       10, 20, 70, 1,  0,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPulseProbability>,   SetOutput<&Output::SetPulseProbability>,     PrintPercent,                                    nullptr},
+    {"OUTPUT 2:",       10, 29, 70, 1,  1,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPulseProbability>,   SetOutput<&Output::SetPulseProbability>,     PrintPercent,                                    nullptr},
+    {"OUTPUT 3:",       10, 38, 70, 1,  2,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPulseProbability>,   SetOutput<&Output::SetPulseProbability>,     PrintPercent,                                    nullptr},
+    {"OUTPUT 4:",       10, 47, 70, 1,  3,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPulseProbability>,   SetOutput<&Output::SetPulseProbability>,     PrintPercent,                                    nullptr},
+    // Euclidean rhythm of the selected output
+    {"OUTPUT: ",        10, 20, 64, 1,  0,  E, MENU_WRAP,               0,   NUM_OUTPUTS - 1,                1, GetEuclideanOutput,                        SetEuclideanOutput,                          PrintIndex,                                      nullptr},
+    {"ENABLED: ",       10, 29, 64, 1,  EUC, A, MENU_PRESET,            0,   1,                              1, GetOutput<&Output::GetEuclidean>,          SetOutput<&Output::SetEuclidean>,            PrintYesNo,                                      nullptr},
+    {"STEPS: ",         10, 38, 64, 1,  EUC, E, MENU_PRESET,            1,   Output::MaxEuclideanSteps,      1, GetOutput<&Output::GetEuclideanSteps>,     SetOutput<&Output::SetEuclideanSteps>,       PrintNumber,                                     nullptr},
+    {"HITS: ",          10, 47, 64, 1,  EUC, E, MENU_PRESET,            1,   Output::MaxEuclideanSteps,      1, GetOutput<&Output::GetEuclideanTriggers>,  SetOutput<&Output::SetEuclideanTriggers>,    PrintNumber,                                     nullptr},
+    {"ROT:",            10, 56, 0,  1,  EUC, E, MENU_PRESET,            0,   Output::MaxEuclideanSteps - 1,  1, GetOutput<&Output::GetEuclideanRotation>,  SetOutput<&Output::SetEuclideanRotation>,    PrintNumber,                                     nullptr},
+    {"PAD:",            64, 56, 0,  56, EUC, E, MENU_PRESET,            0,   Output::MaxEuclideanSteps - 1,  1, GetOutput<&Output::GetEuclideanPadding>,   SetOutput<&Output::SetEuclideanPadding>,     PrintNumber,                                     nullptr},
+    // Swing amount and every, two columns
+    {"OUTPUT 1:",       10, 29, 70, 1,  0,  E, MENU_PRESET,             0,   Output::SwingAmount - 1,        1, GetOutput<&Output::GetSwingAmountIndex>,   SetOutput<&Output::SetSwingAmount>,          PrintOutput<&Output::GetSwingAmountDescription>, nullptr},
+    {nullptr,           10, 29, 100, 1, 0,  E, MENU_PRESET,             1,   Output::SwingEveryAmount,       1, GetOutput<&Output::GetSwingEvery>,         SetOutput<&Output::SetSwingEvery>,           PrintNumber,                                     nullptr},
+    {"OUTPUT 2:",       10, 38, 70, 1,  1,  E, MENU_PRESET,             0,   Output::SwingAmount - 1,        1, GetOutput<&Output::GetSwingAmountIndex>,   SetOutput<&Output::SetSwingAmount>,          PrintOutput<&Output::GetSwingAmountDescription>, nullptr},
+    {nullptr,           10, 38, 100, 1, 1,  E, MENU_PRESET,             1,   Output::SwingEveryAmount,       1, GetOutput<&Output::GetSwingEvery>,         SetOutput<&Output::SetSwingEvery>,           PrintNumber,                                     nullptr},
+    {"OUTPUT 3:",       10, 47, 70, 1,  2,  E, MENU_PRESET,             0,   Output::SwingAmount - 1,        1, GetOutput<&Output::GetSwingAmountIndex>,   SetOutput<&Output::SetSwingAmount>,          PrintOutput<&Output::GetSwingAmountDescription>, nullptr},
+    {nullptr,           10, 47, 100, 1, 2,  E, MENU_PRESET,             1,   Output::SwingEveryAmount,       1, GetOutput<&Output::GetSwingEvery>,         SetOutput<&Output::SetSwingEvery>,           PrintNumber,                                     nullptr},
+    {"OUTPUT 4:",       10, 56, 70, 1,  3,  E, MENU_PRESET,             0,   Output::SwingAmount - 1,        1, GetOutput<&Output::GetSwingAmountIndex>,   SetOutput<&Output::SetSwingAmount>,          PrintOutput<&Output::GetSwingAmountDescription>, nullptr},
+    {nullptr,           10, 56, 100, 1, 3,  E, MENU_PRESET,             1,   Output::SwingEveryAmount,       1, GetOutput<&Output::GetSwingEvery>,         SetOutput<&Output::SetSwingEvery>,           PrintNumber,                                     nullptr},
+    // Groove template, 909 follows the swing settings
+    {"OUTPUT 1:",       10, 20, 70, 1,  0,  E, MENU_WRAP | MENU_PRESET, 0,   Output::GrooveAmount - 1,       1, GetOutput<&Output::GetGroove>,             SetOutput<&Output::SetGroove>,               PrintOutput<&Output::GetGrooveDescription>,      nullptr},
+    {"OUTPUT 2:",       10, 29, 70, 1,  1,  E, MENU_WRAP | MENU_PRESET, 0,   Output::GrooveAmount - 1,       1, GetOutput<&Output::GetGroove>,             SetOutput<&Output::SetGroove>,               PrintOutput<&Output::GetGrooveDescription>,      nullptr},
+    {"OUTPUT 3:",       10, 38, 70, 1,  2,  E, MENU_WRAP | MENU_PRESET, 0,   Output::GrooveAmount - 1,       1, GetOutput<&Output::GetGroove>,             SetOutput<&Output::SetGroove>,               PrintOutput<&Output::GetGrooveDescription>,      nullptr},
+    {"OUTPUT 4:",       10, 47, 70, 1,  3,  E, MENU_WRAP | MENU_PRESET, 0,   Output::GrooveAmount - 1,       1, GetOutput<&Output::GetGroove>,             SetOutput<&Output::SetGroove>,               PrintOutput<&Output::GetGrooveDescription>,      nullptr},
+    // Phase shift
+    {"OUTPUT 1:",       10, 20, 70, 1,  0,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPhase>,              SetOutput<&Output::SetPhase>,                PrintPercent,                                    nullptr},
+    {"OUTPUT 2:",       10, 29, 70, 1,  1,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPhase>,              SetOutput<&Output::SetPhase>,                PrintPercent,                                    nullptr},
+    {"OUTPUT 3:",       10, 38, 70, 1,  2,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPhase>,              SetOutput<&Output::SetPhase>,                PrintPercent,                                    nullptr},
+    {"OUTPUT 4:",       10, 47, 70, 1,  3,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetPhase>,              SetOutput<&Output::SetPhase>,                PrintPercent,                                    nullptr},
+    // Duty cycle
+    {"OUT 1 DUTY: ",    10, 21, 0,  1,  0,  E, MENU_PRESET,             1,   99,                             1, GetOutput<&Output::GetDutyCycle>,          SetOutput<&Output::SetDutyCycle>,            PrintPercent,                                    nullptr},
+    {"OUT 2 DUTY: ",    10, 30, 0,  1,  1,  E, MENU_PRESET,             1,   99,                             1, GetOutput<&Output::GetDutyCycle>,          SetOutput<&Output::SetDutyCycle>,            PrintPercent,                                    nullptr},
+    {"OUT 3 DUTY: ",    10, 39, 0,  1,  2,  E, MENU_PRESET,             1,   99,                             1, GetOutput<&Output::GetDutyCycle>,          SetOutput<&Output::SetDutyCycle>,            PrintPercent,                                    nullptr},
+    {"OUT 4 DUTY: ",    10, 48, 0,  1,  3,  E, MENU_PRESET,             1,   99,                             1, GetOutput<&Output::GetDutyCycle>,          SetOutput<&Output::SetDutyCycle>,            PrintPercent,                                    nullptr},
+    // Level and offset of the DAC outputs, two columns, and their waveforms
+    {"OUTPUT 3:",       10, 21, 70, 1,  2,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetLevel>,              SetOutput<&Output::SetLevel>,                PrintPercent,                                    nullptr},
+    {nullptr,           10, 21, 100, 1, 2,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetOffset>,             SetOutput<&Output::SetOffset>,               PrintPercent,                                    nullptr},
+    {"OUTPUT 4:",       10, 30, 70, 1,  3,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetLevel>,              SetOutput<&Output::SetLevel>,                PrintPercent,                                    nullptr},
+    {nullptr,           10, 30, 100, 1, 3,  E, MENU_PRESET,             0,   100,                            1, GetOutput<&Output::GetOffset>,             SetOutput<&Output::SetOffset>,               PrintPercent,                                    nullptr},
+    {"OUT 3 WAV:",      10, 46, 70, 1,  2,  E, MENU_WRAP | MENU_PRESET, 0,   WaveformTypeLength - 1,         1, GetWaveform,                               SetWaveform,                                 PrintWaveform,                                   nullptr},
+    {"OUT 4 WAV:",      10, 55, 70, 1,  3,  E, MENU_WRAP | MENU_PRESET, 0,   WaveformTypeLength - 1,         1, GetWaveform,                               SetWaveform,                                 PrintWaveform,                                   nullptr},
+    // Envelope of the selected output
+    {"OUTPUT: ",        10, 10, 64, 1,  0,  E, MENU_WRAP,               2,   NUM_OUTPUTS - 1,                1, GetEnvelopeOutput,                         SetEnvelopeOutput,                           PrintIndex,                                      nullptr},
+    {"Attack: ",        10, 19, 64, 1,  ENV, E, MENU_PRESET,            0,   10000,                          2, GetOutput<&Output::GetAttack>,             SetOutput<&Output::SetAttack>,               PrintOutput<&Output::GetAttackDescription>,      nullptr},
+    {"Decay: ",         10, 28, 64, 1,  ENV, E, MENU_PRESET,            0,   10000,                          2, GetOutput<&Output::GetDecay>,              SetOutput<&Output::SetDecay>,                PrintOutput<&Output::GetDecayDescription>,       nullptr},
+    {"Sustain: ",       10, 37, 64, 1,  ENV, E, MENU_PRESET,            0,   100,                            1, GetOutput<&Output::GetSustain>,            SetOutput<&Output::SetSustain>,              PrintOutput<&Output::GetSustainDescription>,     nullptr},
+    {"Release: ",       10, 46, 64, 1,  ENV, E, MENU_PRESET,            0,   10000,                          2, GetOutput<&Output::GetRelease>,            SetOutput<&Output::SetRelease>,              PrintOutput<&Output::GetReleaseDescription>,     nullptr},
+    {"Cur:",            10, 55, 0,  1,  ENV, E, MENU_PRESET,            0,   100,                            1, GetCurve,                                  SetCurve,                                    PrintOutput<&Output::GetCurveDescription>,       nullptr},
+    {"Retr:",           64, 55, 0,  56, ENV, A, MENU_PRESET,            0,   1,                              1, GetOutput<&Output::GetRetrigger>,          SetOutput<&Output::SetRetrigger>,            PrintOutput<&Output::GetRetriggerDescription>,   nullptr},
+    // CV inputs, the target is applied when leaving edit mode
+    {"CV 1: ",          10, 20, 0,  1,  0,  S, MENU_WRAP | MENU_PRESET, 0,   CVTargetLength - 1,             1, GetCVTarget,                               SetCVTarget,                                 PrintCVTarget,                                   AcceptCVTarget},
+    {"CV 2: ",          10, 29, 0,  1,  1,  S, MENU_WRAP | MENU_PRESET, 0,   CVTargetLength - 1,             1, GetCVTarget,                               SetCVTarget,                                 PrintCVTarget,                                   AcceptCVTarget},
+    {"CV 1:",           10, 47, 60, 1,  0,  E, MENU_PRESET,             0,   100,                            1, GetCVAttenuation,                          SetCVAttenuation,                            PrintPercent,                                    nullptr},
+    {nullptr,           10, 47, 100, 1, 0,  E, MENU_PRESET,             0,   100,                            1, GetCVOffset,                               SetCVOffset,                                 PrintPercent,                                    nullptr},
+    {"CV 2:",           10, 56, 60, 1,  1,  E, MENU_PRESET,             0,   100,                            1, GetCVAttenuation,                          SetCVAttenuation,                            PrintPercent,                                    nullptr},
+    {nullptr,           10, 56, 100, 1, 1,  E, MENU_PRESET,             0,   100,                            1, GetCVOffset,                               SetCVOffset,                                 PrintPercent,                                    nullptr},
+    // Other settings
+    {"TAP TEMPO",       10, 9,  0,  1,  0,  A, 0,                       0,   0,                              0, nullptr,                                   TapTempo,                                    PrintTapTempo,                                   nullptr},
+    {"SCENE:",          10, 18, 0,  1,  0,  A, 0,                       0,   SceneSyncLength - 1,            1, GetSceneSync,                              SetSceneSync,                                PrintSceneSync,                                  nullptr},
+    {"RST:",            78, 18, 0,  72, 0,  A, 0,                       0,   TransportSyncLength - 1,        1, GetTransportSync,                          SetTransportSync,                            PrintTransportSync,                              nullptr},
+    {"PRESET SLOT: ",   10, 27, 0,  1,  0,  E, MENU_WRAP,               0,   NUM_SLOTS,                      1, GetSaveSlot,                               SetSaveSlot,                                 PrintSaveSlot,                                   nullptr},
+    {"SAVE",            10, 36, 0,  1,  0,  A, 0,                       0,   0,                              0, nullptr,                                   SaveSettings,                                nullptr,                                         nullptr},
+    {"LOAD",            10, 45, 0,  1,  0,  A, 0,                       0,   0,                              0, nullptr,                                   LoadSettings,                                nullptr,                                         nullptr},
+    {"LOAD DEFAULTS",   10, 54, 0,  1,  0,  A, 0,                       0,   0,                              0, nullptr,                                   LoadDefaults,                                nullptr,                                         nullptr},
+};
+// clang-format on
+#undef E
+#undef S
+#undef A
+#undef EUC
+#undef ENV
+
+// Starts on the output dividers
+Menu menu(menuItems, sizeof(menuItems) / sizeof(menuItems[0]), menuPages, sizeof(menuPages) / sizeof(menuPages[0]), 2);
+
 // Handle encoder button click
 void HandleEncoderClick() {
     oldSwitchState = switchState;
@@ -193,271 +583,8 @@ void HandleEncoderClick() {
     if (switchState == 1 && oldSwitchState == 0) {
         lastEncoderUpdate = millis();
         displayRefresh = 1;
-        if (menuMode == 0) {
-            switch (menuItem) {
-            case 1: // Set BPM
-                menuMode = 1;
-                break;
-            case 2: // Toggle stopped state
-                ToggleMasterState();
-                break;
-            case 3: // Set div1
-                menuMode = 3;
-                break;
-            case 4: // Set div2
-                menuMode = 4;
-                break;
-            case 5: // Set div3
-                menuMode = 5;
-                break;
-            case 6: // Set div4
-                menuMode = 6;
-                break;
-            case 7: // External clock divider
-                menuMode = 7;
-                break;
-            case 8: // Toggle output 1
-                outputs[0].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 9: // Toggle output 2
-                outputs[1].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 10: // Toggle output 3
-                outputs[2].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 11: // Toggle output 4
-                outputs[3].ToggleOutputState();
-                unsavedChanges = true;
-                break;
-            case 12: // Set pulse probability for output 1
-                menuMode = 12;
-                break;
-            case 13: // Set pulse probability for output 2
-                menuMode = 13;
-                break;
-            case 14: // Set pulse probability for output 3
-                menuMode = 14;
-                break;
-            case 15: // Set pulse probability for output 4
-                menuMode = 15;
-                break;
-            case 16: // Select Euclidean rhythm output to edit
-                menuMode = 16;
-                break;
-            case 17: // Toggle Euclidean rhythm for output
-                outputs[euclideanOutputSelect].ToggleEuclidean();
-                unsavedChanges = true;
-                break;
-            case 18: // Set Euclidean rhythm step length
-                menuMode = 18;
-                break;
-            case 19: // Set Euclidean rhythm number of triggers
-                menuMode = 19;
-                break;
-            case 20: // Set Euclidean rhythm rotation
-                menuMode = 20;
-                break;
-            case 21: // Set euclidean padding
-                menuMode = 21;
-                break;
-            case 22: // Set swing amount for output 1
-                menuMode = 22;
-                break;
-            case 23: // Set swing every for output 1
-                menuMode = 23;
-                break;
-            case 24: // Set swing amount for output 2
-                menuMode = 24;
-                break;
-            case 25: // Set swing every for output 2
-                menuMode = 25;
-                break;
-            case 26: // Set swing amount for output 3
-                menuMode = 26;
-                break;
-            case 27: // Set swing every for output 3
-                menuMode = 27;
-                break;
-            case 28: // Set swing amount for output 4
-                menuMode = 28;
-                break;
-            case 29: // Set swing every for output 4
-                menuMode = 29;
-                break;
-            case 30: // Set phase shift for output 1
-                menuMode = 30;
-                break;
-            case 31: // Set phase shift for output 2
-                menuMode = 31;
-                break;
-            case 32: // Set phase shift for output 3
-                menuMode = 32;
-                break;
-            case 33: // Set phase shift for output 4
-                menuMode = 33;
-                break;
-            case 34: // Duty Cycle for output 1
-                menuMode = 34;
-                break;
-            case 35: // Duty Cycle for output 2
-                menuMode = 35;
-                break;
-            case 36: // Duty Cycle for output 3
-                menuMode = 36;
-                break;
-            case 37: // Duty Cycle for output 4
-                menuMode = 37;
-                break;
-            case 38: // Level control for output 3
-                menuMode = 38;
-                break;
-            case 39: // Level offset for output 3
-                menuMode = 39;
-                break;
-            case 40: // Level control for output 4
-                menuMode = 40;
-                break;
-            case 41: // Level offset for output 4
-                menuMode = 41;
-                break;
-            case 42: // Set Waveform type for output 3
-                menuMode = 42;
-                break;
-            case 43: // Set Waveform type for output 4
-                menuMode = 43;
-                break;
-            case 44: // Envelope output selection
-                menuMode = 44;
-                break;
-            case 45: // Envelope attack time
-                menuMode = 45;
-                break;
-            case 46: // Envelope decay time
-                menuMode = 46;
-                break;
-            case 47: // Envelope sustain level
-                menuMode = 47;
-                break;
-            case 48: // Envelope release time
-                menuMode = 48;
-                break;
-            case 49: // Envelope curve
-                menuMode = 49;
-                break;
-            case 50: // Envelope retrigger toggle
-                outputs[envelopeOutputSelect].ToggleRetrigger();
-                unsavedChanges = true;
-                break;
-            case 51: // CV Input 1 target
-                if (menuMode == 51) {
-                    pendingCVInputTarget[0] = CVInputTarget[0];
-                }
-                menuMode = 51;
-                break;
-            case 52: // CV Input 2 target
-                if (menuMode == 52) {
-                    pendingCVInputTarget[1] = CVInputTarget[1];
-                }
-                menuMode = 52;
-                break;
-            case 53: // CV Input 1 attenuation
-                menuMode = 53;
-                break;
-            case 54: // CV Input 1 offset
-                menuMode = 54;
-                break;
-            case 55: // CV Input 2 attenuation
-                menuMode = 55;
-                break;
-            case 56: // CV Input 2 offset
-                menuMode = 56;
-                break;
-            case 57: // Tap tempo
-                SetTapTempo();
-                break;
-            case 58: // Select save slot
-                menuMode = 58;
-                break;
-            case 59: { // Save settings
-                LoadSaveParams p;
-                p.valid = true;
-                p.BPM = BPM;
-                p.externalClockDivIdx = externalDividerIndex;
-                for (int i = 0; i < NUM_OUTPUTS; i++) {
-                    p.divIdx[i] = outputs[i].GetDividerIndex();
-                    p.dutyCycle[i] = outputs[i].GetDutyCycle();
-                    p.outputState[i] = outputs[i].GetOutputState();
-                    p.outputLevel[i] = outputs[i].GetLevel();
-                    p.outputOffset[i] = outputs[i].GetOffset();
-                    p.swingIdx[i] = outputs[i].GetSwingAmountIndex();
-                    p.swingEvery[i] = outputs[i].GetSwingEvery();
-                    p.pulseProbability[i] = outputs[i].GetPulseProbability();
-                    p.euclideanParams[i] = outputs[i].GetEuclideanParams();
-                    p.phaseShift[i] = outputs[i].GetPhase();
-                    p.waveformType[i] = int(outputs[i].GetWaveformType());
-                    p.envParams[i] = outputs[i].GetEnvelopeParams();
-                }
-                for (int i = 0; i < NUM_CV_INS; i++) {
-                    p.CVInputTarget[i] = CVInputTarget[i];
-                    p.CVInputAttenuation[i] = CVInputAttenuation[i];
-                    p.CVInputOffset[i] = CVInputOffset[i];
-                }
-                Save(p, saveSlot);
-                unsavedChanges = false;
-                display.clearDisplay(); // clear display
-                display.setTextSize(2);
-                display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
-                display.print("SAVED");
-                display.display();
-                unsigned long saveMessageStartTime = millis();
-                while (millis() - saveMessageStartTime < 1000) {
-                    HandleIO();
-                }
-                break;
-            }
-            case 60: { // Load from slot
-                LoadSaveParams p = Load(saveSlot);
-                UpdateParameters(p);
-                unsavedChanges = false;
-                display.clearDisplay(); // clear display
-                display.setTextSize(2);
-                display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
-                display.print("LOADED");
-                display.display();
-                unsigned long loadMessageStartTime = millis();
-                while (millis() - loadMessageStartTime < 1000) {
-                    HandleIO();
-                }
-                break;
-            }
-            case 61: { // Load default settings
-                LoadSaveParams p = LoadDefaultParams();
-                UpdateParameters(p);
-                unsavedChanges = false;
-                display.clearDisplay(); // clear display
-                display.setTextSize(2);
-                display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
-                display.print("LOADED");
-                display.display();
-                unsigned long loadMessageStartTime = millis();
-                while (millis() - loadMessageStartTime < 1000) {
-                    HandleIO();
-                }
-                break;
-            }
-            }
-        } else {
-            // Commit changes after exiting edit mode
-            if (menuMode == 51) {
-                CVInputTarget[0] = pendingCVInputTarget[0];
-            } else if (menuMode == 52) {
-                CVInputTarget[1] = pendingCVInputTarget[1];
-            }
-            // Exit edit mode
-            menuMode = 0;
+        if (menu.Click()) {
+            unsavedChanges = true;
         }
     }
 }
@@ -484,381 +611,19 @@ void UpdateSpeedFactor() {
 void HandleEncoderPosition() {
     newPosition = encoder.read();
 
+    int direction = 0;
     if ((newPosition - 3) / 4 > oldPosition / 4) { // Decrease, turned counter-clockwise
-        UpdateSpeedFactor();
-        oldPosition = newPosition;
-        displayRefresh = 1;
-        lastEncoderUpdate = millis();
-        switch (menuMode) {
-        case 0:
-            menuItem = (menuItem - 1 < 1) ? menuItems : menuItem - 1;
-            break;
-        case 1: // Set BPM
-            UpdateBPM(BPM - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 3:
-        case 4:
-        case 5:
-        case 6: // Set div1, div2, div3, div4
-            outputs[menuMode - 3].SetDivider(outputs[menuMode - 3].GetDividerIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 7: // External clock divider
-            externalDividerIndex = constrain(externalDividerIndex - speedFactor, 0, dividerAmount - 1);
-            unsavedChanges = true;
-            break;
-        case 12:
-        case 13:
-        case 14:
-        case 15: // Set Pulse Probability for outputs
-            outputs[menuMode - 12].SetPulseProbability(outputs[menuMode - 12].GetPulseProbability() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 16: // Set euclidean output to edit
-            euclideanOutputSelect = (euclideanOutputSelect - 1 < 0) ? NUM_OUTPUTS - 1 : euclideanOutputSelect - 1;
-            unsavedChanges = true;
-            break;
-        case 18: // Set Euclidean rhythm step length
-            outputs[euclideanOutputSelect].SetEuclideanSteps(outputs[euclideanOutputSelect].GetEuclideanSteps() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 19: // Set Euclidean rhythm number of triggers
-            outputs[euclideanOutputSelect].SetEuclideanTriggers(outputs[euclideanOutputSelect].GetEuclideanTriggers() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 20: // Set Euclidean rhythm rotation
-            outputs[euclideanOutputSelect].SetEuclideanRotation(outputs[euclideanOutputSelect].GetEuclideanRotation() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 21: // Set Euclidean padding
-            outputs[euclideanOutputSelect].SetEuclideanPadding(outputs[euclideanOutputSelect].GetEuclideanPadding() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 22:
-            outputs[0].SetSwingAmount(outputs[0].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 23:
-            outputs[0].SetSwingEvery(outputs[0].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 24:
-            outputs[1].SetSwingAmount(outputs[1].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 25:
-            outputs[1].SetSwingEvery(outputs[1].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 26:
-            outputs[2].SetSwingAmount(outputs[2].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 27:
-            outputs[2].SetSwingEvery(outputs[2].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 28:
-            outputs[3].SetSwingAmount(outputs[3].GetSwingAmountIndex() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 29:
-            outputs[3].SetSwingEvery(outputs[3].GetSwingEvery() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 30:
-        case 31:
-        case 32:
-        case 33: // Set phase shift for outputs
-            outputs[menuMode - 30].SetPhase(outputs[menuMode - 30].GetPhase() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 34: // Duty Cycle for output 1
-            outputs[0].SetDutyCycle(outputs[0].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 35: // Duty Cycle for output 2
-            outputs[1].SetDutyCycle(outputs[1].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 36: // Duty Cycle for output 3
-            outputs[2].SetDutyCycle(outputs[2].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 37: // Duty Cycle for output 4
-            outputs[3].SetDutyCycle(outputs[3].GetDutyCycle() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 38: // Set level for output 3
-            outputs[2].SetLevel(outputs[2].GetLevel() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 39: // Set offset for output 3
-            outputs[2].SetOffset(outputs[2].GetOffset() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 40: // Set level for output 4
-            outputs[3].SetLevel(outputs[3].GetLevel() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 41: // Set offset for output 4
-            outputs[3].SetOffset(outputs[3].GetOffset() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 42: // Set Output 3 waveform type
-            outputs[2].SetWaveformType(static_cast<WaveformType>((outputs[2].GetWaveformType() - 1 + WaveformTypeLength) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 43: // Set Output 4 waveform type
-            outputs[3].SetWaveformType(static_cast<WaveformType>((outputs[3].GetWaveformType() - 1 + WaveformTypeLength) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 44: // Envelope output selection
-            envelopeOutputSelect = (envelopeOutputSelect - 1 < 2) ? 3 : envelopeOutputSelect - 1;
-            unsavedChanges = true;
-            break;
-        case 45: // Envelope attack time
-            outputs[envelopeOutputSelect].SetAttack(outputs[envelopeOutputSelect].GetAttack() - speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 46: // Envelope decay time
-            outputs[envelopeOutputSelect].SetDecay(outputs[envelopeOutputSelect].GetDecay() - speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 47: // Envelope sustain level
-            outputs[envelopeOutputSelect].SetSustain(outputs[envelopeOutputSelect].GetSustain() - speedFactor);
-            unsavedChanges = true;
-            break;
-        case 48: // Envelope release time
-            outputs[envelopeOutputSelect].SetRelease(outputs[envelopeOutputSelect].GetRelease() - speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 49: // Envelope curve
-            outputs[envelopeOutputSelect].SetCurve(outputs[envelopeOutputSelect].GetCurve() - speedFactor * 0.01);
-            unsavedChanges = true;
-            break;
-        case 51: { // CV Input 1 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[0] - 1 + CVTargetLength) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[1] || tmp == CVTarget::None) {
-                pendingCVInputTarget[0] = tmp;
-            } else {
-                pendingCVInputTarget[0] = static_cast<CVTarget>((pendingCVInputTarget[0] - 2 + CVTargetLength) % CVTargetLength);
-            }
-            break;
-        }
-        case 52: { // CV Input 2 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[1] - 1 + CVTargetLength) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[0] || tmp == CVTarget::None) {
-                pendingCVInputTarget[1] = tmp;
-            } else {
-                pendingCVInputTarget[1] = static_cast<CVTarget>((pendingCVInputTarget[1] - 2 + CVTargetLength) % CVTargetLength);
-            }
-            break;
-        }
-        case 53: // CV Input 1 attenuation
-            CVInputAttenuation[0] = constrain(CVInputAttenuation[0] - speedFactor, 0, 100);
-            break;
-        case 54: // CV Input 1 offset
-            CVInputOffset[0] = constrain(CVInputOffset[0] - speedFactor, 0, 100);
-            break;
-        case 55: // CV Input 2 attenuation
-            CVInputAttenuation[1] = constrain(CVInputAttenuation[1] - speedFactor, 0, 100);
-            break;
-        case 56: // CV Input 2 offset
-            CVInputOffset[1] = constrain(CVInputOffset[1] - speedFactor, 0, 100);
-            break;
-        case 58: // Select save slot
-            saveSlot = (saveSlot - 1 < 0) ? NUM_SLOTS : saveSlot - 1;
-            break;
-        }
+        direction = -1;
     } else if ((newPosition + 3) / 4 < oldPosition / 4) { // Increase, turned clockwise
+        direction = 1;
+    }
+    if (direction != 0) {
         UpdateSpeedFactor();
         oldPosition = newPosition;
         displayRefresh = 1;
         lastEncoderUpdate = millis();
-        switch (menuMode) {
-        case 0:
-            menuItem = (menuItem + 1 > menuItems) ? 1 : menuItem + 1;
-            break;
-        case 1: // Set BPM
-            UpdateBPM(BPM + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 3:
-        case 4:
-        case 5:
-        case 6: // Set div1, div2, div3, div4
-            outputs[menuMode - 3].SetDivider(outputs[menuMode - 3].GetDividerIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 7: // External clock divider
-            externalDividerIndex = constrain(externalDividerIndex + speedFactor, 0, dividerAmount - 1);
-            unsavedChanges = true;
-            break;
-        case 12:
-        case 13:
-        case 14:
-        case 15: // Set Pulse Probability for outputs
-            outputs[menuMode - 12].SetPulseProbability(outputs[menuMode - 12].GetPulseProbability() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 16: // Set euclidean output to edit
-            euclideanOutputSelect = (euclideanOutputSelect + 1 > NUM_OUTPUTS - 1) ? 0 : euclideanOutputSelect + 1;
-            unsavedChanges = true;
-            break;
-        case 18: // Set Euclidean rhythm step length
-            outputs[euclideanOutputSelect].SetEuclideanSteps(outputs[euclideanOutputSelect].GetEuclideanSteps() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 19: // Set Euclidean rhythm number of triggers
-            outputs[euclideanOutputSelect].SetEuclideanTriggers(outputs[euclideanOutputSelect].GetEuclideanTriggers() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 20: // Set Euclidean rhythm rotation
-            outputs[euclideanOutputSelect].SetEuclideanRotation(outputs[euclideanOutputSelect].GetEuclideanRotation() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 21: // Set Euclidean padding
-            outputs[euclideanOutputSelect].SetEuclideanPadding(outputs[euclideanOutputSelect].GetEuclideanPadding() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 22:
-            outputs[0].SetSwingAmount(outputs[0].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 23:
-            outputs[0].SetSwingEvery(outputs[0].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 24:
-            outputs[1].SetSwingAmount(outputs[1].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 25:
-            outputs[1].SetSwingEvery(outputs[1].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 26:
-            outputs[2].SetSwingAmount(outputs[2].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 27:
-            outputs[2].SetSwingEvery(outputs[2].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 28:
-            outputs[3].SetSwingAmount(outputs[3].GetSwingAmountIndex() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 29:
-            outputs[3].SetSwingEvery(outputs[3].GetSwingEvery() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 30:
-        case 31:
-        case 32:
-        case 33: // Set phase shift for outputs
-            outputs[menuMode - 30].SetPhase(outputs[menuMode - 30].GetPhase() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 34: // Duty Cycle for output 1
-            outputs[0].SetDutyCycle(outputs[0].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 35: // Duty Cycle for output 2
-            outputs[1].SetDutyCycle(outputs[1].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 36: // Duty Cycle for output 3
-            outputs[2].SetDutyCycle(outputs[2].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 37: // Duty Cycle for output 4
-            outputs[3].SetDutyCycle(outputs[3].GetDutyCycle() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 38: // Set level for output 3
-            outputs[2].SetLevel(outputs[2].GetLevel() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 39: // Set offset for output 3
-            outputs[2].SetOffset(outputs[2].GetOffset() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 40: // Set level for output 4
-            outputs[3].SetLevel(outputs[3].GetLevel() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 41: // Set offset for output 4
-            outputs[3].SetOffset(outputs[3].GetOffset() + speedFactor);
+        if (menu.Turn(direction, speedFactor)) {
             unsavedChanges = true;
-            break;
-        case 42: // Set Output 3 waveform type
-            outputs[2].SetWaveformType(static_cast<WaveformType>((outputs[2].GetWaveformType() + 1) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 43: // Set Output 4 waveform type
-            outputs[3].SetWaveformType(static_cast<WaveformType>((outputs[3].GetWaveformType() + 1) % WaveformTypeLength));
-            unsavedChanges = true;
-            break;
-        case 44: // Envelope output selection
-            envelopeOutputSelect = (envelopeOutputSelect + 1 > 3) ? 2 : envelopeOutputSelect + 1;
-            unsavedChanges = true;
-            break;
-        case 45: // Envelope attack time
-            outputs[envelopeOutputSelect].SetAttack(outputs[envelopeOutputSelect].GetAttack() + speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 46: // Envelope decay time
-            outputs[envelopeOutputSelect].SetDecay(outputs[envelopeOutputSelect].GetDecay() + speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 47: // Envelope sustain level
-            outputs[envelopeOutputSelect].SetSustain(outputs[envelopeOutputSelect].GetSustain() + speedFactor);
-            unsavedChanges = true;
-            break;
-        case 48: // Envelope release time
-            outputs[envelopeOutputSelect].SetRelease(outputs[envelopeOutputSelect].GetRelease() + speedFactor * 2);
-            unsavedChanges = true;
-            break;
-        case 49: // Envelope curve
-            outputs[envelopeOutputSelect].SetCurve(outputs[envelopeOutputSelect].GetCurve() + speedFactor * 0.01);
-            unsavedChanges = true;
-            break;
-        case 51: { // CV Input 1 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[0] + 1) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[1] || tmp == CVTarget::None) {
-                pendingCVInputTarget[0] = tmp;
-            } else {
-                pendingCVInputTarget[0] = static_cast<CVTarget>((pendingCVInputTarget[0] + 2) % CVTargetLength);
-            }
-            break;
-        }
-        case 52: { // CV Input 2 target
-            CVTarget tmp = static_cast<CVTarget>((pendingCVInputTarget[1] + 1) % CVTargetLength);
-            if (tmp != pendingCVInputTarget[0] || tmp == CVTarget::None) {
-                pendingCVInputTarget[1] = tmp;
-            } else {
-                pendingCVInputTarget[1] = static_cast<CVTarget>((pendingCVInputTarget[1] + 2) % CVTargetLength);
-            }
-            break;
-        }
-        case 53: // CV Input 1 attenuation
-            CVInputAttenuation[0] = constrain(CVInputAttenuation[0] + speedFactor, 0, 100);
-            break;
-        case 54: // CV Input 1 offset
-            CVInputOffset[0] = constrain(CVInputOffset[0] + speedFactor, 0, 100);
-            break;
-        case 55: // CV Input 2 attenuation
-            CVInputAttenuation[1] = constrain(CVInputAttenuation[1] + speedFactor, 0, 100);
-            break;
-        case 56: // CV Input 2 offset
-            CVInputOffset[1] = constrain(CVInputOffset[1] + speedFactor, 0, 100);
-            break;
-        case 58: // Select save slot
-            saveSlot = (saveSlot + 1 > NUM_SLOTS) ? 0 : saveSlot + 1;
-            break;
         }
     }
 }
@@ -869,938 +634,762 @@ void RedrawDisplay() {
     if (unsavedChanges) {
         display.fillCircle(1, 1, 1, WHITE);
     }
-    display.display();
+    display.displayBackground();
     displayRefresh = 0;
 }
 
 // Draw a menu position indicator at the right side of the display
 void MenuIndicator() {
-    if (!(menuItem == 1 || menuItem == 2)) {
+    if (menu.GetPage() != 0) {
         // Draw a vertical line at the right side of the display
         display.drawLine(127, 0, 127, 63, WHITE);
         // Draw a dot at the current menu position proportional to the menu items
-        display.drawRect(125, map(menuItem, 1, menuItems, 0, 62), 3, 3, WHITE);
+        display.drawRect(125, map(menu.GetItem(), 0, menu.GetItemCount() - 1, 0, 62), 3, 3, WHITE);
     }
 }
 
-void MenuHeader(const char *header) {
-    display.setTextSize(1);
-    int headerLength = (strlen(header) * 6) + 24; // Sum of the length of the header and the "- " sides
-    display.setCursor((SCREEN_WIDTH - headerLength) / 2, 1);
-    display.println("- " + String(header) + " -");
+// Splash logo, then the module name
+void DrawBootScreen(BootScreen screen) {
+    display.clearDisplay();
+    if (screen == BootSplash) {
+        display.drawBitmap(30, 0, VFM_Splash, 68, 64, 1);
+    } else {
+        display.setTextSize(2);
+        display.setTextColor(WHITE);
+        display.setCursor(4, 20);
+        display.print("ClockForge");
+        display.setTextSize(1);
+        display.setCursor(80, 54);
+        display.print("V" VERSION);
+    }
+    display.displayBackground();
+    bootScreen = screen;
+    bootScreenTime = millis();
 }
 
-// Handle display drawing
-void HandleDisplay() {
-    if (displayRefresh == 1) {
-        display.clearDisplay();
-        MenuIndicator();
-
-        // Draw the menu
-        int menuIdx = 1;
-        int itemAmount = 2;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            String s = String(BPM) + "BPM";
-            display.setTextSize(3);
-            // Centralize the BPM display
-            display.setCursor((SCREEN_WIDTH - (s.length() * 18)) / 2, 0);
-            display.print(s);
-            if (usingExternalClock) {
-                display.setTextSize(1);
-                display.setCursor(120, 24);
-                display.print("E");
-            }
-            // Draw selection triangle
-            if (menuMode == 0 && menuItem == 1) {
-                display.drawTriangle(2, 6, 2, 14, 6, 10, 1);
-            } else if (menuMode == menuItem) {
-                display.fillTriangle(2, 6, 2, 14, 6, 10, 1);
-            }
-
-            if (menuMode >= 0 && menuMode <= 2) {
-                display.setTextSize(2);
-                display.setCursor(44, 27);
-                if (menuItem == 2) {
-                    display.drawLine(43, 42, 88, 42, 1);
-                }
-                if (!masterState) {
-                    display.fillRoundRect(23, 26, 17, 17, 2, 1);
-                    display.print("STOP");
-                } else {
-                    display.fillTriangle(23, 26, 23, 42, 39, 34, 1);
-                    display.print("PLAY");
-                }
-            }
+// Show the next boot screen when it's time, then the menu. Any encoder action shows the menu at once.
+void HandleBootScreen() {
+    unsigned long elapsed = millis() - bootScreenTime;
+    if (lastEncoderUpdate != 0 || (bootScreen == BootName && elapsed >= BOOT_NAME_MS)) {
+        bootScreen = BootDone;
+        displayRefresh = 1;
+    } else if (bootScreen == BootSplash && elapsed >= BOOT_SPLASH_MS && !display.displayBusy()) {
+        DrawBootScreen(BootName);
+    }
+}
 
-            // Show a box to each output showing if it's enabled
-            display.setTextSize(1);
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                if (outputs[i].GetOutputState()) {
-                    display.fillRect((i * 30) + 14, 46, 9, 9, WHITE);
-                    display.setCursor((i * 30) + 16, 47);
-                    display.setTextColor(BLACK);
-                    display.print(i + 1);
-                } else {
-                    display.drawRect((i * 30) + 14, 46, 9, 9, WHITE);
-                    display.setCursor((i * 30) + 16, 47);
-                    display.setTextColor(WHITE);
-                    display.print(i + 1);
-                }
-                display.setTextColor(WHITE);
-                String s = outputs[i].GetDividerDescription();
-                display.setCursor((i * 30) + 13 + (6 - (s.length() * 3)), 56);
-                display.print(s);
-            }
-            RedrawDisplay();
+// Draw the message once the previous frame has been sent, then the menu again after a second
+void HandleMessage() {
+    if (!messageDrawn) {
+        if (display.displayBusy()) {
             return;
         }
+        display.clearDisplay();
+        display.setTextSize(2);
+        display.setCursor(SCREEN_WIDTH / 2 - 30, SCREEN_HEIGHT / 2 - 16);
+        display.print(message);
+        display.displayBackground();
+        messageDrawn = true;
+        messageTime = millis();
+    } else if (millis() - messageTime >= MESSAGE_MS) {
+        message = nullptr;
+        displayRefresh = 1;
+    }
+}
 
-        // Clock dividers menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 5;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("CLOCK DIVIDERS");
-            int yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(84, yPosition);
-                display.print(outputs[i].GetDividerDescription());
-                if (menuItem == i + menuIdx) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, 19 + (i * 9), 1, 27 + (i * 9), 5, 23 + (i * 9), 1);
-                    } else if (menuMode == i + menuIdx) {
-                        display.fillTriangle(1, 19 + (i * 9), 1, 27 + (i * 9), 5, 23 + (i * 9), 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            // For external clock divider
-            display.setCursor(10, yPosition);
-            display.print("EXT. DIV:");
-            display.setCursor(84, yPosition);
-            display.print(externalDividerDescription[externalDividerIndex]);
-            if (menuItem == 7) {
-                if (menuMode == 0) {
-                    display.drawTriangle(1, 19 + (NUM_OUTPUTS * 9), 1, 27 + (NUM_OUTPUTS * 9), 5, 23 + (NUM_OUTPUTS * 9), 1);
-                } else if (menuMode == 7) {
-                    display.fillTriangle(1, 19 + (NUM_OUTPUTS * 9), 1, 27 + (NUM_OUTPUTS * 9), 5, 23 + (NUM_OUTPUTS * 9), 1);
-                }
-            }
+// Handle display drawing, only the page of the selected item is drawn
+void HandleDisplay() {
+    if (bootScreen != BootDone) {
+        HandleBootScreen();
+        return;
+    }
+    if (message != nullptr) {
+        HandleMessage();
+        return;
+    }
 
-            RedrawDisplay();
-            return;
-        }
+    // Draw when the previous frame has been sent, the loop keeps running meanwhile
+    if (displayRefresh == 1 && !display.displayBusy()) {
+        display.clearDisplay();
+        MenuIndicator();
+        display.setTextSize(1);
+        menu.Draw(display);
+        RedrawDisplay();
+    }
 
-        // Clock outputs state menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT STATE");
-            int yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetOutputState() ? "ON" : "OFF");
-                if (menuItem == i + menuIdx) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else if (menuMode == i + menuIdx) {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
-        }
+    // If more than 7 seconds have passed, return to the main screen
+    if (millis() - lastEncoderUpdate > 7000 && menu.GetPage() != 0 && !menu.IsEditing()) {
+        menu.Select(1);
+        displayRefresh = 1;
+    }
+}
 
-        // Pulse Probability menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("PROBABILITY");
-            int yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetPulseProbabilityDescription());
-                if (menuItem == menuIdx + i) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else if (menuMode == menuIdx + i) {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
-        }
+// Tap tempo function, the tempo is set from the third tap and refined on every following tap
+void SetTapTempo() {
+    if (engine.UsingExternalClock()) {
+        return;
+    }
+    if (tapTempo.AddEvent(micros()) && tapTempo.GetCount() >= 2) {
+        UpdateTempo(tapTempo.GetBPM());
+        unsavedChanges = true;
+    }
+}
 
-        // Euclidean rhythm menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 6;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("EUCLIDEAN RHYTHM");
-            int yPosition = 20;
-            int xPosition = 64;
-            display.setCursor(10, yPosition);
-            display.print("OUTPUT: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(euclideanOutputSelect + 1));
-            if (menuItem == menuIdx && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("ENABLED: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[euclideanOutputSelect].GetEuclidean() ? "YES" : "NO"));
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("STEPS: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanSteps()));
-            if (menuItem == menuIdx + 2 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 2) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("HITS: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanTriggers()));
-            if (menuItem == menuIdx + 3 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 3) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("ROT:");
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanRotation()));
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
+// Raw CV input reading at now, from the recording during a replay
+uint16_t ReadCV(uint32_t now, int ch) {
+    uint16_t value;
+    if (!cvPlayer.Read(now, ch, value)) {
+        value = CVADCRead(ch);
+    }
+    cvCapture.Record(now, ch, value);
+    return value;
+}
 
-            display.setCursor(xPosition, yPosition);
-            display.print("PAD:");
-            display.print(String(outputs[euclideanOutputSelect].GetEuclideanPadding()));
-            if (menuItem == menuIdx + 5 && menuMode == 0) {
-                display.drawTriangle(xPosition - 8, yPosition - 1, xPosition - 8, yPosition + 7, xPosition - 4, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 5) {
-                display.fillTriangle(xPosition - 8, yPosition - 1, xPosition - 8, yPosition + 7, xPosition - 4, yPosition + 3, 1);
-            }
+const TraceEvent &CVCaptureSample(int index) {
+    return cvCapture.Get(index);
+}
 
-            // Draw the Euclidean rhythm pattern for the selected output
-            if (outputs[euclideanOutputSelect].GetEuclidean()) {
-                display.fillTriangle(90, 10, 94, 10, 92, 14, WHITE);
-                yPosition = 15;
-                int euclideanSteps = outputs[euclideanOutputSelect].GetEuclideanSteps();
-                int euclideanPadding = outputs[euclideanOutputSelect].GetEuclideanPadding();
-                for (int i = 0; i < euclideanSteps + euclideanPadding && i < 47; i++) {
-                    int column = i / 8;
-                    int row = i % 8;
-                    display.setCursor(90 + (column * 6), yPosition + (row * 6));
-                    if (i < euclideanSteps && outputs[euclideanOutputSelect].GetRhythmStep(i)) {
-                        display.fillRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
-                    } else {
-                        if (i < euclideanSteps) {
-                            display.drawRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
-                        } else {
-                            display.drawRect(90 + (column * 6), yPosition + (row * 6), 5, 5, WHITE);
-                            display.writePixel(90 + (column * 6) + 2, yPosition + (row * 6) + 2, WHITE);
-                        }
-                    }
-                }
-                if (euclideanSteps + euclideanPadding > 47) {
-                    display.fillTriangle(120, 57, 124, 57, 122, 61, WHITE);
-                }
-            }
-            RedrawDisplay();
-            return;
-        }
+// Live inputs keep being captured, a replay plays the capture and pauses it
+bool SetCVSource(uint8_t source) {
+    switch (source) {
+    case CVLive:
+        cvPlayer.Stop();
+        cvCapture.SetEnabled(true);
+        return true;
+    case CVReplay:
+        cvCapture.SetEnabled(false);
+        cvPlayer.Start(CVCaptureSample, cvCapture.GetCount(), micros());
+        return true;
+    }
+    return false;
+}
 
-        // Swing amount menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 8;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT SWING");
-            int yPosition = 20;
-            display.setCursor(64, yPosition);
-            display.println("AMT");
-            display.setCursor(94, yPosition);
-            display.println("EVERY");
-            yPosition += 9;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetSwingAmountDescription());
-                display.setCursor(100, yPosition);
-                display.print(outputs[i].GetSwingEvery());
-
-                if (menuItem % 2 == 0) {
-                    display.fillTriangle(59, 20, 59, 26, 62, 23, 1);
-                } else {
-                    display.fillTriangle(89, 20, 89, 26, 92, 23, 1);
-                }
-
-                if (menuItem - menuIdx == i * 2 || menuItem - menuIdx == i * 2 + 1) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
+// The module as the CV targets change it
+struct CVModule {
+    static const int GateCount = NUM_GATE_OUTS;
+    static const int MinBPM = minBPM;
+    static const int MaxBPM = maxBPM;
+    static const int SceneCount = NUM_SLOTS;
+    static const int WaveformCount = WaveformTypeLength;
+    typedef WaveformType Waveform;
+
+    Output (&outputs)[NUM_OUTPUTS];
+
+    void Transport(bool run) { engine.PostMasterState(run, transportSync); }
+    void Reset() { engine.PostReset(transportSync); }
+    void SetBPM(int bpm) { UpdateBPM(bpm); }
+    void SelectScene(int scene) {
+        if (scene != activeScene) {
+            RequestScene(scene);
         }
+    }
+};
+CVModule cvModule = {outputs};
+
+// Raw thresholds of the gate detector for the calibration, attenuation and offset of the input,
+// computed again only when one of them or the target changed
+void UpdateCVGate(int ch) {
+    bool enabled = IsGateTarget(CVInputTarget[ch]);
+    CVGateSettings &settings = cvGateSettings[ch];
+    if (settings.configured && settings.enabled == enabled && settings.target == CVInputTarget[ch] && settings.attenuation == CVInputAttenuation[ch] &&
+        settings.offset == CVInputOffset[ch] && settings.adcOffset == ADCOffset[ch] && settings.adcCal == ADCCal[ch]) {
+        return;
+    }
+    settings = {true, enabled, CVInputTarget[ch], CVInputAttenuation[ch], CVInputOffset[ch], ADCOffset[ch], ADCCal[ch]};
+    GateThresholds thresholds = CVGateThresholds(ADCOffset[ch], ADCCal[ch], CVInputAttenuation[ch], CVInputOffset[ch]);
+    noInterrupts();
+    cvGates[ch].Configure(thresholds, enabled);
+    interrupts();
+}
 
-        // Phase shift menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("PHASE SHIFT");
-            int yPosition = 0;
-            yPosition = 20;
-            for (int i = 0; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetPhaseDescription());
-                if (menuItem == menuIdx + i) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else if (menuMode == menuIdx + i) {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            RedrawDisplay();
-            return;
-        }
+// Raw sample of a CV input: the ADC results inside the interrupt, the replayed samples from the CV task
+void HandleCVGate(int ch, uint16_t value) {
+    int edge = cvGates[ch].Update(value);
+    if (edge != 0) {
+        CVGateApply(cvModule, CVInputTarget[ch], edge, micros());
+    }
+}
 
-        // Duty cycle menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 4;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT SETTINGS");
-            int yPosition = 21;
-
-            for (int i = 0; i < itemAmount; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUT " + String(i + 1) + " DUTY: ");
-                display.print(outputs[i].GetDutyCycleDescription());
-                if (menuItem == menuIdx + i && menuMode == 0) {
-                    display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                } else if (menuMode == menuIdx + i) {
-                    display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                }
-                yPosition += 9;
-            }
+// ADC result, ignored during a replay as the recording feeds the gate detectors instead
+void HandleCVSample(int ch, uint16_t value) {
+    if (!cvPlayer.Running()) {
+        HandleCVGate(ch, value);
+    }
+}
 
-            RedrawDisplay();
-            return;
+void HandleCVInputs() {
+    uint32_t now = micros();
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        UpdateCVGate(i);
+    }
+    // Replayed samples go through the gate detectors in time order, as the ADC results do live
+    cvPlayer.Play(now, [](int ch, uint16_t value) {
+        if (ch < NUM_CV_INS) {
+            HandleCVGate(ch, value);
         }
-
-        // Level/Offset/Waveform control menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 6;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("OUTPUT SETTINGS");
-            int yPosition = 12;
-
-            // Levels and offsets
-            display.setCursor(70, yPosition);
-            display.println("LVL");
-            display.setCursor(100, yPosition);
-            display.println("OFF");
-            if (menuItem == menuIdx || menuItem == menuIdx + 2) {
-                display.fillTriangle(65, yPosition, 65, yPosition + 6, 68, yPosition + 3, 1);
-            }
-            if (menuItem == menuIdx + 1 || menuItem == menuIdx + 3) {
-                display.fillTriangle(95, yPosition, 95, yPosition + 6, 98, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            for (int i = 2; i < NUM_OUTPUTS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("OUTPUT " + String(i + 1) + ":");
-                display.setCursor(70, yPosition);
-                display.print(outputs[i].GetLevelDescription());
-                display.setCursor(100, yPosition);
-                display.print(outputs[i].GetOffsetDescription());
-
-                if (menuItem == menuIdx + (i - 2) * 2 || menuItem == menuIdx + 1 + (i - 2) * 2) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
-            // Waveform type
-            yPosition += 7;
-            display.setCursor(10, yPosition);
-            display.println("OUT 3 WAV:");
-            display.setCursor(70, yPosition);
-            display.print(outputs[2].GetWaveformTypeDescription());
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.println("OUT 4 WAV:");
-            display.setCursor(70, yPosition);
-            display.print(outputs[3].GetWaveformTypeDescription());
-            if (menuItem == menuIdx + 5 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 5) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-
-            RedrawDisplay();
-            return;
+    });
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        if (CVSmooth(channelADC[i], CVCalibrate(ReadCV(now, i), ADCOffset[i], ADCCal[i]))) {
+            HandleCVTarget(i, channelADC[i], CVInputTarget[i]);
         }
+    }
+}
 
-        // Envelope settings
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 7;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("ENVELOPE SETTINGS");
-            int yPosition = 10;
-            int xPosition = 64;
-            display.setCursor(10, yPosition);
-            display.print("OUTPUT: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(envelopeOutputSelect + 1));
-            if (menuItem == menuIdx && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Attack: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetAttackDescription()));
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Decay: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetDecayDescription()));
-            if (menuItem == menuIdx + 2 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 2) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Sustain: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetSustainDescription()));
-            if (menuItem == menuIdx + 3 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 3) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Release: ");
-            display.setCursor(xPosition, yPosition);
-            display.print(String(outputs[envelopeOutputSelect].GetReleaseDescription()));
-            if (menuItem == menuIdx + 4 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 4) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("Cur:");
-            display.print(String(outputs[envelopeOutputSelect].GetCurveDescription()));
-            if (menuItem == menuIdx + 5 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 5) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
+// Handle the CV target based on the calibrated CV value
+void HandleCVTarget(int ch, float CVValue, CVTarget cvTarget) {
+    CVTargetApply(cvModule, cvTarget, CVScale(CVValue, CVInputAttenuation[ch], CVInputOffset[ch]), cvGates[ch].IsEnabled(), cvTargetStates[ch]);
+}
 
-            display.setCursor(64, yPosition);
-            display.print("Retr:");
-            display.print(String(outputs[envelopeOutputSelect].GetRetriggerDescription()));
-            if (menuItem == menuIdx + 6 && menuMode == 0) {
-                display.drawTriangle(56, yPosition - 1, 56, yPosition + 7, 60, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 6) {
-                display.fillTriangle(56, yPosition - 1, 56, yPosition + 7, 60, yPosition + 3, 1);
-            }
+// External clock interrupt service routine
+void ClockReceived() {
+    unsigned long currentTime = micros();
+    // Debounce: ignore interrupts that occur too close together (less than 1ms)
+    if (currentTime - lastClockInterruptTime < 1000) {
+        return;
+    }
+    lastClockInterruptTime = currentTime;
+    clockTempo.AddEvent(currentTime);
 
-            RedrawDisplay();
-            return;
+    // Keep the internal tempo to restore it when the clock is disconnected
+    if (!engine.UsingExternalClock()) {
+        lastInternalBPM = BPM;
+    }
+    // Divide the external clock signal by the selected divider, the engine advances the outputs
+    if (engine.ExternalClock(externalClockDividers[externalDividerIndex])) {
+        // Follow the clock tempo once it is locked
+        if (clockTempo.IsLocked()) {
+            float newBPM = clockTempo.GetBPM() / externalClockDividers[externalDividerIndex];
+            // Add hysteresis to BPM changes
+            if (fabsf(newBPM - BPM) > 0.5f) {
+                UpdateTempo(newBPM);
+                displayRefresh = 1;
+                DEBUG_PRINT("External clock connected");
+            }
         }
+    }
+}
 
-        // CV input target menu
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 6;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            MenuHeader("CV INPUT TARGETS");
-            int yPosition = 20;
-            display.setCursor(10, yPosition);
-            display.print("CV 1: ");
-            display.print(CVTargetDescription[menuMode == 51 ? pendingCVInputTarget[0] : CVInputTarget[0]]);
-
-            if (menuItem == menuIdx && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
+// Called on loop to check if the external clock is still connected and revert to internal clock if not
+void HandleExternalClock() {
+    unsigned long currentTime = micros();
+    if (engine.UsingExternalClock() && (currentTime - lastClockInterruptTime) > 2000000) {
+        engine.ExternalClockLost();
+        clockTempo.Reset();
+        BPM = lastInternalBPM;
+        UpdateBPM(BPM);
+        displayRefresh = 1;
+        DEBUG_PRINT("External clock disconnected");
+    }
+}
 
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("CV 2: ");
-            display.print(CVTargetDescription[menuMode == 52 ? pendingCVInputTarget[1] : CVInputTarget[1]]);
-            if (menuItem == menuIdx + 1 && menuMode == 0) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            } else if (menuMode == menuIdx + 1) {
-                display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            // Levels and offsets
-            display.setCursor(60, yPosition);
-            display.println("ATTN");
-            display.setCursor(100, yPosition);
-            display.println("OFF");
-            if (menuItem == menuIdx + 2 || menuItem == menuIdx + 4) {
-                display.fillTriangle(55, yPosition, 55, yPosition + 6, 58, yPosition + 3, 1);
-            }
-            if (menuItem == menuIdx + 3 || menuItem == menuIdx + 5) {
-                display.fillTriangle(95, yPosition, 95, yPosition + 6, 98, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            for (int i = 0; i < NUM_CV_INS; i++) {
-                display.setCursor(10, yPosition);
-                display.print("CV " + String(i + 1) + ":");
-                display.setCursor(60, yPosition);
-                display.print(String(CVInputAttenuation[i]) + "%");
-                display.setCursor(100, yPosition);
-                display.print(String(CVInputOffset[i]) + "%");
-
-                if (menuItem == menuIdx + 2 + (i) * 2 || menuItem == menuIdx + 3 + (i) * 2) {
-                    if (menuMode == 0) {
-                        display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    } else {
-                        display.fillTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-                    }
-                }
-                yPosition += 9;
-            }
+// Set the hardware timer based on the BPM
+void UpdateBPM(unsigned int newBPM) {
+    BPM = constrain(newBPM, minBPM, maxBPM);
+    unsigned long tickMicros = 60L * 1000 * 1000 / BPM / PPQN / 4;
+    TimerTcc0.setPeriod(tickMicros);
+    engine.SetRefreshStep(RampStep(DAC_REFRESH_MICROS, tickMicros));
+}
 
-            RedrawDisplay();
-            return;
-        }
+// Set the hardware timer from a fractional BPM (tap tempo and external clock), BPM keeps the rounded value
+void UpdateTempo(float newBPM) {
+    newBPM = constrain(newBPM, float(minBPM), float(maxBPM));
+    BPM = lroundf(newBPM);
+    unsigned long tickMicros = lroundf(60.0f * 1000 * 1000 / newBPM / PPQN / 4);
+    TimerTcc0.setPeriod(tickMicros);
+    engine.SetRefreshStep(RampStep(DAC_REFRESH_MICROS, tickMicros));
+}
 
-        // Other settings
-        menuIdx = menuIdx + itemAmount;
-        itemAmount = 5;
-        if (menuItem >= menuIdx && menuItem < menuIdx + itemAmount) {
-            display.setTextSize(1);
-            int yPosition = 9;
-            // Tap tempo
-            display.setCursor(10, yPosition);
-            display.print("TAP TEMPO");
-            display.print(" (" + String(BPM) + " BPM)");
-            if (menuItem == menuIdx) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            yPosition += 9;
-            // Save
-            display.setCursor(10, yPosition);
-            display.print("PRESET SLOT: ");
-            display.print(saveSlot);
-            if (menuItem == menuIdx + 1) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("SAVE");
-            if (menuItem == menuIdx + 2) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            display.setCursor(10, yPosition);
-            display.print("LOAD");
-            if (menuItem == menuIdx + 3) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
-            yPosition += 9;
-            // Load default settings
-            display.setCursor(10, yPosition);
-            display.print("LOAD DEFAULTS");
-            if (menuItem == menuIdx + 4) {
-                display.drawTriangle(1, yPosition - 1, 1, yPosition + 7, 5, yPosition + 3, 1);
-            }
+// The DAC outputs are written by DACRefresh()
+void HandleOutputs() {
+    engine.WriteGates(SetGates);
+}
 
-            RedrawDisplay();
-            return;
-        }
-    }
+void DACRefresh() { // Inside the interrupt, same priority as the clock timer so they don't preempt each other
+    engine.Refresh(SetPin);
+}
 
-    // If more than 5 seconds have passed, return to the main screen
-    if (millis() - lastEncoderUpdate > 7000 && menuItem != 1 && menuItem != 2 && menuMode == 0) {
-        menuItem = 2;
-        menuMode = 0;
-        displayRefresh = 1;
+void ClockPulse() { // Inside the interrupt
+    if (firstClockMicros == 0) {
+        firstClockMicros = micros();
     }
+    // Scenes switch on beat boundaries, before the outputs handle the tick
+    if (engine.OnBeat()) {
+        PublishScene(outputs, engine.GetBeatCounter());
+    }
+    engine.Tick();
 }
 
-// Tap tempo function
-static unsigned long lastTapTime = 0;
-static unsigned long tapTimes[3] = {0, 0, 0};
-static int tapIndex = 0;
-void SetTapTempo() {
-    if (usingExternalClock) {
+// Apply the global settings of a scene published by the clock ISR
+void HandleSceneSwitch() {
+    Scene *scene = appliedScene;
+    if (scene == nullptr) {
         return;
     }
-    unsigned long currentMillis = millis();
-    if (currentMillis - lastTapTime > 2000) {
-        tapIndex = 0;
+    appliedScene = nullptr;
+    if (scene->BPM != BPM && !engine.UsingExternalClock()) {
+        UpdateBPM(scene->BPM);
     }
-    if (tapIndex < 3) {
-        tapTimes[tapIndex] = currentMillis;
-        tapIndex++;
-        lastTapTime = currentMillis;
-    }
-    if (tapIndex == 3) {
-        unsigned long averageTime = (tapTimes[2] - tapTimes[0]) / 2;
-        unsigned int newBPM = 60000 / averageTime;
-        tapIndex++;
-        UpdateBPM(newBPM);
-        unsavedChanges = true;
+    externalDividerIndex = constrain(scene->externalClockDivIdx, 0, dividerAmount - 1);
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        // Keep the CV input driving the scene switch assigned, otherwise the switch would lock itself out
+        if (CVInputTarget[i] != CVTarget::SceneSelect) {
+            CVInputTarget[i] = static_cast<CVTarget>(constrain(scene->CVInputTarget[i], 0, CVTargetLength - 1));
+        }
+        CVInputAttenuation[i] = scene->CVInputAttenuation[i];
+        CVInputOffset[i] = scene->CVInputOffset[i];
     }
+    unsavedChanges = false;
+    displayRefresh = 1;
 }
 
-// Toggle the master state and update all outputs
-void ToggleMasterState() {
-    SetMasterState(!masterState);
-}
-
-// Set the master state and update all outputs
-void SetMasterState(bool state) {
-    masterState = state;
+void UpdateParameters(LoadSaveParams p) {
+    BPM = p.BPM;
+    externalDividerIndex = p.externalClockDivIdx;
+    Output::SetUserGroove(p.userGroove);
     for (int i = 0; i < NUM_OUTPUTS; i++) {
-        outputs[i].SetMasterState(state);
+        outputs[i].SetDivider(p.divIdx[i]);
+        outputs[i].SetDutyCycle(p.dutyCycle[i]);
+        outputs[i].SetOutputState(p.outputState[i]);
+        outputs[i].SetLevel(p.outputLevel[i]);
+        outputs[i].SetOffset(p.outputOffset[i]);
+        outputs[i].SetSwingAmount(p.swingIdx[i]);
+        outputs[i].SetSwingEvery(p.swingEvery[i]);
+        outputs[i].SetPulseProbability(p.pulseProbability[i]);
+        outputs[i].SetEuclideanParams(p.euclideanParams[i]);
+        outputs[i].SetPhase(p.phaseShift[i]);
+        outputs[i].SetWaveformType(static_cast<WaveformType>(p.waveformType[i]));
+        outputs[i].SetEnvelopeParams(p.envParams[i]);
+        outputs[i].SetGroove(p.groove[i]);
+    }
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        CVInputTarget[i] = static_cast<CVTarget>(p.CVInputTarget[i]);
+        CVInputAttenuation[i] = p.CVInputAttenuation[i];
+        CVInputOffset[i] = p.CVInputOffset[i];
     }
 }
 
-// Adjust the ADC readings
-void AdjustADCReadings(int CV_IN_PIN, int ch) {
-    // Apply calibration
-    float calibratedReading = max((analogRead(CV_IN_PIN) - ADCOffset[ch]) * ADCCal[ch], 0.0f);
-    channelADC[ch] = calibratedReading;
-}
+// ---- Serial protocol ----
 
-void HandleCVInputs() {
-    for (int i = 0; i < NUM_CV_INS; i++) {
-        oldChannelADC[i] = channelADC[i];
-        AdjustADCReadings(CV_IN_PINS[i], i);
-        ONE_POLE(channelADC[i], oldChannelADC[i], 0.5f);
-        if (abs(channelADC[i] - oldChannelADC[i]) > 10) {
-            HandleCVTarget(i, channelADC[i], CVInputTarget[i]);
-        }
-    }
+// Restart the loop and I2C stats read over the protocol
+void ResetStats() {
+    scheduler.ResetStats();
+    i2cArbiter.ResetStats();
 }
 
-unsigned long lastDisplayUpdateTime = 0;
-volatile bool lastResetState = false;
-// Handle the CV target based on the CV value
-void HandleCVTarget(int ch, float CVValue, CVTarget cvTarget) {
-    // Attenuate and offset the CVValue
-    float attenuatedValue = CVValue * ((100 - CVInputAttenuation[ch]) / 100.0f);
-    float offsetValue = attenuatedValue + (CVInputOffset[ch] / 100.0f * MAXDAC);
-    CVValue = constrain(offsetValue, 0, MAXDAC);
-
-    // DEBUG_PRINT("Ch: " + String(ch) + " CV Target: " + String(cvTarget) + " CV Value: " + String(CVValue) + "\n");
-    switch (cvTarget) {
-    case CVTarget::None:
-        break;
-    case CVTarget::StartStop:
-        if (CVValue > MAXDAC / 2) {
-            SetMasterState(true);
-        } else {
-            SetMasterState(false);
-        }
+// Read a parameter by protocol ID
+bool GetParam(uint8_t id, uint8_t ch, int32_t &value) {
+    if (ch >= ParamChannels(id, NUM_OUTPUTS, NUM_CV_INS, scheduler.GetCount(), I2CClients)) {
+        return false;
+    }
+    switch (id) {
+    case ParamBPM:
+        value = BPM;
         break;
-    case CVTarget::Reset:
-        if (CVValue > MAXDAC / 2 && !lastResetState) {
-            tickCounter = 0;
-            externalTickCounter = 0;
-            lastResetState = true;
-        } else if (CVValue < MAXDAC / 2) {
-            lastResetState = false;
-        }
+    case ParamMasterState:
+        value = engine.GetMasterState();
+        break;
+    case ParamExternalDivider:
+        value = externalDividerIndex;
+        break;
+    case ParamExternalClock:
+        value = engine.UsingExternalClock();
+        break;
+    case ParamScene:
+        value = activeScene;
+        break;
+    case ParamSceneSync:
+        value = sceneSync;
+        break;
+    case ParamTransportSync:
+        value = transportSync;
+        break;
+    case ParamDivider:
+        value = outputs[ch].GetDividerIndex();
+        break;
+    case ParamDutyCycle:
+        value = outputs[ch].GetDutyCycle();
+        break;
+    case ParamOutputState:
+        value = outputs[ch].GetOutputState();
+        break;
+    case ParamLevel:
+        value = outputs[ch].GetLevel();
+        break;
+    case ParamOffset:
+        value = outputs[ch].GetOffset();
+        break;
+    case ParamSwingAmount:
+        value = outputs[ch].GetSwingAmountIndex();
         break;
-    case CVTarget::SetBPM:
-        // Convert float value to BPM range
-        UpdateBPM(map(CVValue, 0, MAXDAC, minBPM, maxBPM));
+    case ParamSwingEvery:
+        value = outputs[ch].GetSwingEvery();
         break;
-    case CVTarget::Div1:
-        outputs[0].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[0].GetDividerAmounts()));
+    case ParamProbability:
+        value = outputs[ch].GetPulseProbability();
         break;
-    case CVTarget::Div2:
-        outputs[1].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[1].GetDividerAmounts()));
+    case ParamEuclidean:
+        value = outputs[ch].GetEuclidean();
         break;
-    case CVTarget::Div3:
-        outputs[2].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[2].GetDividerAmounts()));
+    case ParamEuclideanSteps:
+        value = outputs[ch].GetEuclideanSteps();
         break;
-    case CVTarget::Div4:
-        outputs[3].SetDivider(map(CVValue, 0, MAXDAC, 0, outputs[3].GetDividerAmounts()));
+    case ParamEuclideanTriggers:
+        value = outputs[ch].GetEuclideanTriggers();
         break;
-    case CVTarget::Output1Prob:
-        outputs[0].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
+    case ParamEuclideanRotation:
+        value = outputs[ch].GetEuclideanRotation();
         break;
-    case CVTarget::Output2Prob:
-        outputs[1].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
+    case ParamEuclideanPadding:
+        value = outputs[ch].GetEuclideanPadding();
         break;
-    case CVTarget::Output3Prob:
-        outputs[2].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
+    case ParamPhase:
+        value = outputs[ch].GetPhase();
         break;
-    case CVTarget::Output4Prob:
-        outputs[3].SetPulseProbability(map(CVValue, 0, MAXDAC, 1, 100));
+    case ParamWaveform:
+        value = outputs[ch].GetWaveformTypeIndex();
         break;
-    case CVTarget::Swing1Amount:
-        outputs[0].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[0].GetSwingAmounts()));
+    case ParamAttack:
+        value = lroundf(outputs[ch].GetAttack());
         break;
-    case CVTarget::Swing1Every:
-        outputs[0].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[0].GetSwingEveryAmounts()));
+    case ParamDecay:
+        value = lroundf(outputs[ch].GetDecay());
         break;
-    case CVTarget::Swing2Amount:
-        outputs[1].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[1].GetSwingAmounts()));
+    case ParamSustain:
+        value = lroundf(outputs[ch].GetSustain());
         break;
-    case CVTarget::Swing2Every:
-        outputs[1].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[1].GetSwingEveryAmounts()));
+    case ParamRelease:
+        value = lroundf(outputs[ch].GetRelease());
         break;
-    case CVTarget::Swing3Amount:
-        outputs[2].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[2].GetSwingAmounts()));
+    case ParamCurve:
+        value = lroundf(outputs[ch].GetCurve() * 100);
         break;
-    case CVTarget::Swing3Every:
-        outputs[2].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[2].GetSwingEveryAmounts()));
+    case ParamRetrigger:
+        value = outputs[ch].GetRetrigger();
         break;
-    case CVTarget::Swing4Amount:
-        outputs[3].SetSwingAmount(map(CVValue, 0, MAXDAC, 0, outputs[3].GetSwingAmounts()));
+    case ParamCVTarget:
+        value = CVInputTarget[ch];
         break;
-    case CVTarget::Swing4Every:
-        outputs[3].SetSwingEvery(map(CVValue, 0, MAXDAC, 1, outputs[3].GetSwingEveryAmounts()));
+    case ParamCVAttenuation:
+        value = CVInputAttenuation[ch];
         break;
-    case CVTarget::Output3Offset:
-        outputs[2].SetOffset(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamCVOffset:
+        value = CVInputOffset[ch];
         break;
-    case CVTarget::Output4Offset:
-        outputs[3].SetOffset(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamGroove:
+        value = outputs[ch].GetGroove();
         break;
-    case CVTarget::Output3Level:
-        outputs[2].SetLevel(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamLoopDuty:
+        value = scheduler.GetDutyCycle() * 10000 + 0.5f;
         break;
-    case CVTarget::Output4Level:
-        outputs[3].SetLevel(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamTaskRuns:
+        value = scheduler.GetTask(ch).runs;
         break;
-    case CVTarget::Output3Waveform:
-        outputs[2].SetWaveformType(static_cast<WaveformType>(map(CVValue, 0, MAXDAC, 0, WaveformTypeLength)));
+    case ParamTaskMisses:
+        value = scheduler.GetTask(ch).misses;
         break;
-    case CVTarget::Output4Waveform:
-        outputs[3].SetWaveformType(static_cast<WaveformType>(map(CVValue, 0, MAXDAC, 0, WaveformTypeLength)));
+    case ParamTaskMaxLateness:
+        value = scheduler.GetTask(ch).maxLateness;
         break;
-    case CVTarget::Output1Duty:
-        outputs[0].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamTaskMaxDuration:
+        value = scheduler.GetTask(ch).maxDuration;
         break;
-    case CVTarget::Output2Duty:
-        outputs[1].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamI2CSent:
+        value = i2cArbiter.GetStats(I2CClient(ch)).sent;
         break;
-    case CVTarget::Output3Duty:
-        outputs[2].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamI2CDropped:
+        value = i2cArbiter.GetStats(I2CClient(ch)).dropped;
         break;
-    case CVTarget::Output4Duty:
-        outputs[3].SetDutyCycle(map(CVValue, 0, MAXDAC, 0, 100));
+    case ParamI2CDepth:
+        value = i2cArbiter.GetDepth(I2CClient(ch));
         break;
-    case CVTarget::Envelope1:
-        outputs[2].SetExternalTrigger(CVValue > MAXDAC / 2);
+    case ParamI2CMaxDepth:
+        value = i2cArbiter.GetStats(I2CClient(ch)).maxDepth;
         break;
-    case CVTarget::Envelope2:
-        outputs[3].SetExternalTrigger(CVValue > MAXDAC / 2);
+    case ParamI2CMaxWait:
+        value = i2cArbiter.GetStats(I2CClient(ch)).maxWait;
         break;
+    case ParamBootTime:
+        value = firstClockMicros;
+        break;
+    default:
+        return false;
     }
-    // Update the display if the CV target is not None
-    // if (cvTarget != CVTarget::None && menuMode == 0 && millis() - lastDisplayUpdateTime > 1000) {
-    //     displayRefresh = 1;
-    //     lastDisplayUpdateTime = millis();
-    // }
+    return true;
 }
 
-// External clock interrupt service routine
-void ClockReceived() {
-    unsigned long currentTime = millis();
-    // Debounce: ignore interrupts that occur too close together (less than 1ms)
-    if (currentTime - lastClockInterruptTime < 1) {
-        return;
+// Write a parameter by protocol ID, value is updated to the applied (constrained) value
+bool SetParam(uint8_t id, uint8_t ch, int32_t &value) {
+    if (ch >= ParamChannels(id, NUM_OUTPUTS, NUM_CV_INS, scheduler.GetCount(), I2CClients)) {
+        return false;
+    }
+    switch (id) {
+    case ParamBPM:
+        UpdateBPM(value);
+        break;
+    case ParamMasterState:
+        engine.PostMasterState(value != 0, transportSync);
+        break;
+    case ParamExternalDivider:
+        externalDividerIndex = constrain(value, 0, dividerAmount - 1);
+        break;
+    case ParamScene:
+        if (!RequestScene(value)) {
+            return false;
+        }
+        break;
+    case ParamSceneSync:
+        sceneSync = static_cast<SceneSync>(constrain(value, 0, SceneSyncLength - 1));
+        break;
+    case ParamTransportSync:
+        transportSync = static_cast<TransportSync>(constrain(value, 0, TransportSyncLength - 1));
+        break;
+    case ParamDivider:
+        outputs[ch].SetDivider(value);
+        break;
+    case ParamDutyCycle:
+        outputs[ch].SetDutyCycle(value);
+        break;
+    case ParamOutputState:
+        outputs[ch].SetOutputState(value != 0);
+        break;
+    case ParamLevel:
+        outputs[ch].SetLevel(value);
+        break;
+    case ParamOffset:
+        outputs[ch].SetOffset(value);
+        break;
+    case ParamSwingAmount:
+        outputs[ch].SetSwingAmount(value);
+        break;
+    case ParamSwingEvery:
+        outputs[ch].SetSwingEvery(value);
+        break;
+    case ParamProbability:
+        outputs[ch].SetPulseProbability(value);
+        break;
+    case ParamEuclidean:
+        outputs[ch].SetEuclidean(value != 0);
+        break;
+    case ParamEuclideanSteps:
+        outputs[ch].SetEuclideanSteps(value);
+        break;
+    case ParamEuclideanTriggers:
+        outputs[ch].SetEuclideanTriggers(value);
+        break;
+    case ParamEuclideanRotation:
+        outputs[ch].SetEuclideanRotation(value);
+        break;
+    case ParamEuclideanPadding:
+        outputs[ch].SetEuclideanPadding(value);
+        break;
+    case ParamPhase:
+        outputs[ch].SetPhase(value);
+        break;
+    case ParamWaveform:
+        outputs[ch].SetWaveformType(static_cast<WaveformType>(constrain(value, 0, WaveformTypeLength - 1)));
+        break;
+    case ParamAttack:
+        outputs[ch].SetAttack(value);
+        break;
+    case ParamDecay:
+        outputs[ch].SetDecay(value);
+        break;
+    case ParamSustain:
+        outputs[ch].SetSustain(value);
+        break;
+    case ParamRelease:
+        outputs[ch].SetRelease(value);
+        break;
+    case ParamCurve:
+        outputs[ch].SetCurve(value / 100.0f);
+        break;
+    case ParamRetrigger:
+        outputs[ch].SetRetrigger(value != 0);
+        break;
+    case ParamCVTarget:
+        CVInputTarget[ch] = static_cast<CVTarget>(constrain(value, 0, CVTargetLength - 1));
+        break;
+    case ParamCVAttenuation:
+        CVInputAttenuation[ch] = constrain(value, 0, 100);
+        break;
+    case ParamCVOffset:
+        CVInputOffset[ch] = constrain(value, 0, 100);
+        break;
+    case ParamGroove:
+        outputs[ch].SetGroove(value);
+        break;
+    case ParamLoopDuty:
+    case ParamTaskRuns:
+    case ParamTaskMisses:
+    case ParamTaskMaxLateness:
+    case ParamTaskMaxDuration:
+    case ParamI2CSent:
+    case ParamI2CDropped:
+    case ParamI2CDepth:
+    case ParamI2CMaxDepth:
+    case ParamI2CMaxWait:
+        ResetStats();
+        return GetParam(id, ch, value);
+    default:
+        return false; // Read only or unknown
     }
+    unsavedChanges = true;
+    displayRefresh = 1;
+    return GetParam(id, ch, value);
+}
 
-    unsigned long interval = currentTime - lastClockInterruptTime;
-    lastClockInterruptTime = currentTime;
+// Dump a preset slot, empty slots are sent as the defaults
+bool ReadPreset(uint8_t slot, uint8_t *data) {
+    LoadSaveParams p = Load(slot);
+    p.valid = true;
+    memcpy(data, &p, sizeof(p));
+    return true;
+}
 
-    // Ignore obviously wrong intervals (too short or too long)
-    if (interval < 10 || interval > 2000) {
-        return;
+// Store an uploaded preset to flash and refresh its scene
+bool WritePreset(uint8_t slot, const uint8_t *data) {
+    LoadSaveParams p;
+    memcpy(&p, data, sizeof(p));
+    if (!p.valid) {
+        return false;
     }
+    UpgradeParams(p);
+    Save(p, slot);
+    StoreScene(p, slot);
+    return true;
+}
 
-    static unsigned long intervals[3] = {0, 0, 0};
-    static int intervalIndex = 0;
-
-    intervals[intervalIndex] = interval;
-    intervalIndex = (intervalIndex + 1) % 3;
+void WriteSerial(const uint8_t *data, size_t length) {
+    Serial.write(data, length);
+}
 
-    // Calculate average interval, excluding outliers
-    unsigned long averageInterval = 0;
-    int validIntervals = 0;
-    for (int i = 0; i < 3; i++) {
-        if (intervals[i] > 0 && abs((long)intervals[i] - (long)interval) < interval / 2) {
-            averageInterval += intervals[i];
-            validIntervals++;
-        }
+// Pack the trace events for the protocol
+template <int Size>
+int PackTrace(const TraceRecorder<Size> &events, int first, uint8_t *out, int max) {
+    int count = 0;
+    for (; count < max && first + count < events.GetCount(); count++, out += PROTOCOL_TRACE_EVENT) {
+        noInterrupts(); // The DAC refresh timer records output events
+        const TraceEvent event = events.Get(first + count);
+        interrupts();
+        PutU32(out, event.time);
+        out[4] = event.channel;
+        PutU16(&out[5], event.value);
     }
+    return count;
+}
 
-    if (validIntervals > 0) {
-        averageInterval /= validIntervals;
-    } else {
-        return;
+int ReadTrace(uint8_t source, int first, uint8_t *out, int max) {
+    switch (source) {
+    case TraceOutputs:
+        return PackTrace(trace, first, out, max);
+    case TraceCVInputs:
+        return PackTrace(cvCapture, first, out, max);
     }
+    return -1;
+}
 
-    // Divide the external clock signal by the selected divider
-    if (externalTickCounter % externalClockDividers[externalDividerIndex] == 0) {
-        if (averageInterval > 0) {
-            clockInterval = averageInterval;
-            unsigned int newBPM = 60000 / (averageInterval * externalClockDividers[externalDividerIndex]);
-            // Add hysteresis to BPM changes
-            if (abs(newBPM - BPM) > 3) {
-                UpdateBPM(newBPM);
-                displayRefresh = 1;
-                DEBUG_PRINT("External clock connected");
-            }
-        }
-
-        // Update outputs
-        noInterrupts(); // Critical section
-        for (int i = 0; i < NUM_OUTPUTS; i++) {
-            outputs[i].SetExternalClock(true);
-            outputs[i].IncrementInternalCounter();
-        }
-        usingExternalClock = true;
-        tickCounter = 0;
+void ClearTrace(uint8_t source) {
+    if (source == TraceOutputs) {
+        noInterrupts();
+        trace.Clear();
         interrupts();
+    } else if (source == TraceCVInputs) {
+        cvCapture.Clear();
     }
-    externalTickCounter++;
 }
 
-// Called on loop to check if the external clock is still connected and revert to internal clock if not
-void HandleExternalClock() {
-    unsigned long currentTime = millis();
-    if (usingExternalClock && (currentTime - lastClockInterruptTime) > 2000) {
-        usingExternalClock = false;
-        BPM = lastInternalBPM;
-        UpdateBPM(BPM);
-        for (int i = 0; i < NUM_OUTPUTS; i++) {
-            outputs[i].SetExternalClock(false);
-        }
-        displayRefresh = 1;
-        DEBUG_PRINT("External clock disconnected");
+// Load a recording into the CV capture to replay it, the capture stays paused until back to live
+bool WriteCVSamples(int first, const uint8_t *data, int count) {
+    if (first == 0) {
+        cvPlayer.Stop();
+        cvCapture.Clear();
+        cvSamplesLoaded = 0;
+    }
+    if (first != cvSamplesLoaded || first + count > CV_CAPTURE_SAMPLES) {
+        return false;
     }
+    cvCapture.SetEnabled(true);
+    for (int i = 0; i < count; i++, data += PROTOCOL_TRACE_EVENT) {
+        cvCapture.Record(GetI32(data), data[4], GetU16(&data[5]));
+    }
+    cvCapture.SetEnabled(false);
+    cvSamplesLoaded += count;
+    return true;
 }
 
-// Set the hardware timer based on the BPM
-void UpdateBPM(unsigned int newBPM) {
-    BPM = constrain(newBPM, minBPM, maxBPM);
-    TimerTcc0.setPeriod(60L * 1000 * 1000 / BPM / PPQN / 4);
+// Offsets of the user groove, returns its steps
+int ReadGroove(uint8_t *offsets) {
+    const GrooveTable &groove = Output::GetUserGroove();
+    memcpy(offsets, groove.offsets, groove.steps);
+    return groove.steps;
 }
 
-void HandleOutputs() {
+// Load the user groove, the outputs using it switch at their next step
+bool WriteGroove(const uint8_t *offsets, int steps) {
+    if (steps > GROOVE_MAX_STEPS) {
+        return false;
+    }
+    GrooveTable groove = UserGroove(offsets, steps);
+    Output::SetUserGroove(groove);
     for (int i = 0; i < NUM_OUTPUTS; i++) {
-        // Set the output level based on the pulse state
-        SetPin(i, outputs[i].GetOutputLevel());
-
-        if (i == 2 || i == 3) {
-            // Set the output level based on the pulse state
-            outputs[i].GenEnvelope();
-        }
+        outputs[i].UpdateGroove();
     }
+    unsavedChanges = true;
+    return true;
 }
 
-void ClockPulse() { // Inside the interrupt
-    for (int i = 0; i < NUM_OUTPUTS; i++) {
-        outputs[i].Pulse(PPQN, tickCounter);
+static_assert(sizeof(LoadSaveParams) <= PROTOCOL_MAX_PRESET_SIZE, "Preset does not fit the protocol buffer");
+ProtocolHandler protocolHandler = {GetParam, SetParam, ReadPreset, WritePreset, WriteSerial, NUM_SLOTS, sizeof(LoadSaveParams), ReadTrace, ClearTrace, SetCVSource, WriteCVSamples, ReadGroove, WriteGroove};
+SerialProtocol protocol(protocolHandler);
+
+// Streamed parameter values, sized for the widest parameter (outputs)
+int32_t streamedParams[ParamCount][NUM_OUTPUTS];
+bool streamSynced = false;
+unsigned long lastStreamTime = 0;
+
+// Handle incoming protocol frames and stream parameter changes
+void HandleSerial() {
+    uint8_t buffer[64];
+    int available;
+    while ((available = Serial.available()) > 0) {
+        size_t length = Serial.readBytes(buffer, min(available, (int)sizeof(buffer)));
+        protocol.Receive(buffer, length);
     }
-    tickCounter++;
-}
 
-void UpdateParameters(LoadSaveParams p) {
-    BPM = p.BPM;
-    externalDividerIndex = p.externalClockDivIdx;
-    for (int i = 0; i < NUM_OUTPUTS; i++) {
-        outputs[i].SetDivider(p.divIdx[i]);
-        outputs[i].SetDutyCycle(p.dutyCycle[i]);
-        outputs[i].SetOutputState(p.outputState[i]);
-        outputs[i].SetLevel(p.outputLevel[i]);
-        outputs[i].SetOffset(p.outputOffset[i]);
-        outputs[i].SetSwingAmount(p.swingIdx[i]);
-        outputs[i].SetSwingEvery(p.swingEvery[i]);
-        outputs[i].SetPulseProbability(p.pulseProbability[i]);
-        outputs[i].SetEuclideanParams(p.euclideanParams[i]);
-        outputs[i].SetPhase(p.phaseShift[i]);
-        outputs[i].SetWaveformType(static_cast<WaveformType>(p.waveformType[i]));
-        outputs[i].SetEnvelopeParams(p.envParams[i]);
+    if (!protocol.Streaming()) {
+        streamSynced = false;
+        return;
     }
-    for (int i = 0; i < NUM_CV_INS; i++) {
-        CVInputTarget[i] = static_cast<CVTarget>(p.CVInputTarget[i]);
-        CVInputAttenuation[i] = p.CVInputAttenuation[i];
-        CVInputOffset[i] = p.CVInputOffset[i];
+    if (millis() - lastStreamTime < 20) {
+        return;
     }
+    lastStreamTime = millis();
+    // Send every parameter when streaming starts, only the changes afterwards
+    for (uint8_t id = 0; id < ParamCount; id++) {
+        if (ParamIsStat(id)) {
+            continue;
+        }
+        for (int ch = 0; ch < ParamChannels(id, NUM_OUTPUTS, NUM_CV_INS, scheduler.GetCount(), I2CClients); ch++) {
+            int32_t value;
+            GetParam(id, ch, value);
+            if (!streamSynced || value != streamedParams[id][ch]) {
+                streamedParams[id][ch] = value;
+                protocol.NotifyParam(id, ch, value);
+            }
+        }
+    }
+    streamSynced = true;
 }
 
-// Initialize the hardware timer
+// Initialize the hardware timers
 void InitializeTimer() {
     // Set up the timer
     TimerTcc0.initialize();
     TimerTcc0.attachInterrupt(ClockPulse);
+
+    // Fixed rate DAC refresh
+    TimerTc3.initialize(DAC_REFRESH_MICROS);
+    TimerTc3.attachInterrupt(DACRefresh);
 }
 
 void setup() {
@@ -1817,25 +1406,10 @@ void setup() {
             ; // Don't proceed, loop forever
     }
     Wire.setClock(1000000);
-    display.clearDisplay();
+    i2cArbiter.Begin();
+    display.beginBackground(OLED_ADDRESS);
     display.setTextWrap(false);
 
-    display.clearDisplay();
-    display.drawBitmap(30, 0, VFM_Splash, 68, 64, 1);
-    display.display();
-    delay(2000);
-    // Print module name in the middle of the screen
-    display.clearDisplay();
-    display.setTextSize(2);
-    display.setTextColor(WHITE);
-    display.setCursor(4, 20);
-    display.print("ClockForge");
-    display.setTextSize(1);
-    display.setCursor(80, 54);
-    display.print("V" VERSION);
-    display.display();
-    delay(1500);
-
     // Attach interrupt for external clock
     attachInterrupt(digitalPinToInterrupt(CLK_IN_PIN), ClockReceived, RISING);
 
@@ -1843,27 +1417,45 @@ void setup() {
     LoadSaveParams p = Load(0);
     UpdateParameters(p);
 
-    // Initialize timer
+    // Decode all preset slots so scene switches don't touch flash
+    LoadScenes();
+    activeScene = 0;
+
+#ifndef PRNG_DETERMINISTIC
+    // Seed the output generators from the CV input noise and boot time, read once as each reading takes 0.7 ms
+    uint32_t seed = micros() ^ (analogRead(CV_1_IN_PIN) << 12) ^ (analogRead(CV_2_IN_PIN) << 20);
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        outputs[i].SeedRandom(seed ^ i);
+    }
+#endif
+
+    // The ADC converts the CV inputs in the background from now on
+    CVADCInit(CV_IN_PINS, NUM_CV_INS, HandleCVSample);
+
+    // Initialize timer, the clock starts right away and the display task shows the boot screens meanwhile
     InitializeTimer();
     UpdateBPM(BPM);
+    DrawBootScreen(BootSplash);
+
+    // Loop tasks, periods in us, the display takes the remaining time
+    scheduler.Add("outputs", HandleOutputs, 1000, 0);
+    scheduler.Add("encoder", HandleEncoder, 1000, 1);
+    scheduler.Add("cv", HandleCVInputs, 2000, 2);
+    scheduler.Add("scenes", HandleSceneSwitch, 1000, 3);
+    scheduler.Add("serial", HandleSerial, 1000, 4);
+    scheduler.Add("clock", HandleExternalClock, 100000, 5);
+    scheduler.Add("display", HandleDisplay, 0, 0);
 }
 
-// Handle IO without the display
-void HandleIO() {
+void HandleEncoder() {
     HandleEncoderClick();
 
     HandleEncoderPosition();
-
-    HandleOutputs();
-
-    HandleCVInputs();
-
-    HandleExternalClock();
 }
 
-// Main loop
+// Main loop, sleeps until the next interrupt when no task has work
 void loop() {
-    HandleIO();
-
-    HandleDisplay();
+    if (!scheduler.Run()) {
+        IdleSleep();
+    }
 }
@@ -3,6 +3,10 @@
 
 #include "definitions.hpp"
 #include "euclidean.hpp"
+#include "groove.hpp"
+#include "noise.hpp"
+#include "prng.hpp"
+#include "ratio.hpp"
 
 // Define a type for the DAC output type
 enum OutputType {
@@ -41,7 +45,7 @@ String WaveformTypeDescriptions[] = {
     "AR Env",
     "ADSR Env",
 };
-int WaveformTypeLength = sizeof(WaveformTypeDescriptions) / sizeof(WaveformTypeDescriptions[0]);
+const int WaveformTypeLength = sizeof(WaveformTypeDescriptions) / sizeof(WaveformTypeDescriptions[0]);
 
 // ADSR envelope parameters
 typedef struct {
@@ -55,20 +59,52 @@ typedef struct {
     bool retrigger;     // Retrigger on gate high
 } EnvelopeParams;
 
+// Output parameters decoded from a preset, ready to be published to an output by the clock ISR
+typedef struct {
+    int dividerIndex;
+    int dutyCycle;
+    bool state;
+    int level;
+    int offset;
+    int swingAmountIndex;
+    int swingEvery;
+    int pulseProbability;
+    EuclideanParams euclideanParams;
+    uint64_t euclideanRhythm; // Pre-generated pattern, one bit per step
+    int phase;
+    WaveformType waveformType;
+    EnvelopeParams envParams;
+    int groove;
+} OutputScene;
+
 class Output {
   public:
     // Constructor
     Output(int ID, OutputType type);
 
     // Pulse State
-    void Pulse(int PPQN, unsigned long tickCounter);
+    // The clock ISR calls the Kind specialized versions, gate outputs only run the pulse,
+    // probability and Euclidean logic. The Kind-less versions dispatch on the output type.
+    template <OutputType Kind, int PPQN>
+    void Pulse(unsigned long tickCounter);
+    template <int PPQN>
+    void Pulse(unsigned long tickCounter) {
+        if (_outputType == OutputType::DigitalOut) {
+            Pulse<OutputType::DigitalOut, PPQN>(tickCounter);
+        } else {
+            Pulse<OutputType::DACOut, PPQN>(tickCounter);
+        }
+    }
     void GenEnvelope();
     bool GetPulseState() { return _isPulseOn; }
+    bool Glides() { return _glides; } // The DAC level of the last tick continues the waveform, it can be interpolated
     void SetPulse(bool state) { _isPulseOn = state; }
     void TogglePulse() { _isPulseOn = !_isPulseOn; }
     bool HasPulseChanged();
     void SetExternalClock(bool state) { _externalClock = state; }
     void IncrementInternalCounter() { _internalPulseCounter++; }
+    void Restart(); // Back to the first step and the start of the waveform, for a transport reset
+    void SeedRandom(uint32_t seed) { _prng.Seed(seed); }
 
     // Output State
     bool GetOutputState() { return _state; }
@@ -77,11 +113,17 @@ class Output {
     void ToggleMasterState();
     void SetMasterState(bool state);
 
-    // Divider
+    // Divider, one of the divider list or a custom ratio (index from CustomRatioIndex())
     int GetDividerIndex() { return _dividerIndex; }
-    void SetDivider(int index) { _dividerIndex = constrain(index, 0, _dividerAmount - 1); }
-    String GetDividerDescription() { return _dividerDescription[_dividerIndex]; }
+    void SetDivider(int index);
+    String GetDividerDescription();
     int GetDividerAmounts() { return _dividerAmount; }
+    DividerRatio GetRatio() { return _ratio; }
+    void SetRatio(int multiply, int divide) { SetDivider(CustomRatioIndex(multiply, divide)); }
+    static bool IsCustomRatio(int index) { return index >= _dividerAmount && index < _dividerAmount + MaxRatio * MaxRatio; }
+    static int CustomRatioIndex(int multiply, int divide) {
+        return _dividerAmount + (constrain(multiply, 1, MaxRatio) - 1) * MaxRatio + constrain(divide, 1, MaxRatio) - 1;
+    }
 
     // Duty Cycle
     int GetDutyCycle() { return _dutyCycle; }
@@ -90,7 +132,9 @@ class Output {
 
     // Output Level
     int GetLevel() { return _level; }
+    template <OutputType Kind>
     int GetOutputLevel(); // Output Level based on the output type
+    int GetOutputLevel() { return _outputType == OutputType::DigitalOut ? GetOutputLevel<OutputType::DigitalOut>() : GetOutputLevel<OutputType::DACOut>(); }
     String GetLevelDescription() { return String(_level) + "%"; }
     void SetLevel(int level) { _level = constrain(level, 0, 100); }
 
@@ -99,15 +143,33 @@ class Output {
     void SetOffset(int offset) { _offset = constrain(offset, 0, 100); }
     String GetOffsetDescription() { return String(_offset) + "%"; }
 
-    // Swing
-    void SetSwingAmount(int swingAmount) { _swingAmountIndex = constrain(swingAmount, 0, 6); }
+    // Swing, the amount and every set the 909 groove
+    void SetSwingAmount(int swingAmount) {
+        _swingAmountIndex = constrain(swingAmount, 0, 6);
+        BuildGroove();
+    }
     int GetSwingAmountIndex() { return _swingAmountIndex; }
     int GetSwingAmounts() { return _swingAmount; }
     String GetSwingAmountDescription() { return _swingAmountDescriptions[_swingAmountIndex]; }
-    void SetSwingEvery(int swingEvery) { _swingEvery = constrain(swingEvery, 1, _swingEveryAmount); }
+    void SetSwingEvery(int swingEvery) {
+        _swingEvery = constrain(swingEvery, 1, _swingEveryAmount);
+        BuildGroove();
+    }
     int GetSwingEvery() { return _swingEvery; }
     int GetSwingEveryAmounts() { return _swingEveryAmount; }
 
+    // Groove template
+    void SetGroove(int groove) {
+        _grooveIndex = constrain(groove, 0, _grooveAmount - 1);
+        BuildGroove();
+    }
+    int GetGroove() { return _grooveIndex; }
+    String GetGrooveDescription() { return _grooveDescriptions[_grooveIndex]; }
+    void UpdateGroove() { BuildGroove(); } // After a change of the user groove
+    // User groove shared by the outputs, UpdateGroove() applies it
+    static void SetUserGroove(const GrooveTable &groove) { _userGroove = UserGroove(groove.offsets, groove.steps); }
+    static const GrooveTable &GetUserGroove() { return _userGroove; }
+
     // Pulse Probability
     void SetPulseProbability(int pulseProbability) { _pulseProbability = constrain(pulseProbability, 0, 100); }
     int GetPulseProbability() { return _pulseProbability; }
@@ -143,13 +205,23 @@ class Output {
     // Trigger mode control
     void SetTriggerMode(bool enabled) { _triggerMode = enabled; }
     bool GetTriggerMode() { return _triggerMode; }
-    void SetExternalTrigger(bool state) {
+    void SetExternalTrigger(bool state) { SetExternalTrigger(state, micros()); }
+    // Gate edge at time (us), the envelope starts or releases from then
+    void SetExternalTrigger(bool state, unsigned long time) {
         if (state != _externaltrigger) {
             _externaltrigger = state;
             if (state)
-                HandleTrigger();
+                HandleTrigger(time);
             else
-                HandleGateRelease();
+                HandleGateRelease(time);
+        }
+    }
+    // Gate edge from an interrupt, applied with its time by the next GenEnvelope()
+    void QueueExternalTrigger(bool state, unsigned long time) {
+        uint8_t head = _triggerHead;
+        if (uint8_t(head - _triggerTail) < TriggerQueueLength) {
+            _triggerQueue[head % TriggerQueueLength] = {time, state};
+            _triggerHead = head + 1;
         }
     }
 
@@ -187,27 +259,55 @@ class Output {
     }
     float GetCurve() { return (_envParams.attackCurve + _envParams.decayCurve + _envParams.releaseCurve) / 3.0f; }
     String GetCurveDescription() { return String(GetCurve() * 100, 0) + "%"; }
+    // Shape a 0-1 envelope time, curve 0.5 is linear
+    static float ApplyCurve(float input, float curve) {
+        // input and output are 0-1 range
+        if (curve == 0.5f)
+            return input; // Linear
+
+        // Convert curve 0-1 to power range 0.1 to 10
+        float power = pow(10.0f, (curve - 0.5f) * 2.0f);
+        return pow(input, power);
+    }
+
+    // Scenes
+    static void PrepareScene(OutputScene &scene);
+    void ApplyScene(const OutputScene &scene);
+
+    // Parameter ranges
+    static constexpr int DividerAmount = 19;
+    static constexpr int SwingAmount = 7;
+    static constexpr int SwingEveryAmount = 16;
+    static constexpr int GrooveAmount = 2 + MPCSwingAmount; // 909, MPC swings and user
+    static constexpr int MaxEuclideanSteps = 64;
+    static constexpr int MaxRatio = 64; // Custom ratios from 1:64 to 64:1
 
   private:
-    // Constants
-    const int MaxDACValue = 4095;
-    const float MaxWaveValue = 255.0;
-    static int const _dividerAmount = 19;
-    float _clockDividers[_dividerAmount] = {0.0078125, 0.015625, 0.03125, 0.0625, 0.125, 0.25, 0.3333333333, 0.5, 0.6666666667, 1.0, 1.5, 2.0, 3.0, 4.0, 8.0, 16.0, 24.0, 32.0, 10000};
-    String _dividerDescription[_dividerAmount] = {"/128", "/64", "/32", "/16", "/8", "/4", "/3", "/2", "/1.5", "x1", "x1.5", "x2", "x3", "x4", "x8", "x16", "x24", "x32", "Env"};
-    static int const MaxEuclideanSteps = 64;
+    // Constants, shared by all outputs
+    static constexpr int MaxDACValue = 4095;
+    static constexpr float MaxWaveValue = 255.0;
+    static int const _dividerAmount = DividerAmount;
+    static constexpr DividerRatio _dividerRatios[_dividerAmount] = {{1, 128}, {1, 64}, {1, 32}, {1, 16}, {1, 8}, {1, 4}, {1, 3}, {1, 2}, {2, 3}, {1, 1}, {3, 2}, {2, 1}, {3, 1}, {4, 1}, {8, 1}, {16, 1}, {24, 1}, {32, 1}, {0, 1}};
+    static constexpr const char *_dividerDescription[_dividerAmount] = {"/128", "/64", "/32", "/16", "/8", "/4", "/3", "/2", "/1.5", "x1", "x1.5", "x2", "x3", "x4", "x8", "x16", "x24", "x32", "Env"};
+    static constexpr int _envDivider = _dividerAmount - 1;
 
     // The shuffle of the TR-909 delays each even-numbered 1/16th by 2/96 of a beat for shuffle setting 1,
     // 4/96 for 2, 6/96 for 3, 8/96 for 4, 10/96 for 5 and 12/96 for 6.
-    static int const _swingAmount = 7;
-    float _swingAmounts[_swingAmount] = {0, 2, 4, 6, 8, 10, 12};
-    String _swingAmountDescriptions[_swingAmount] = {"0", "2/96", "4/96", "6/96", "8/96", "10/96", "12/96"};
+    static int const _swingAmount = SwingAmount;
+    static constexpr uint8_t _swingAmounts[_swingAmount] = {0, 2, 4, 6, 8, 10, 12};
+    static constexpr const char *_swingAmountDescriptions[_swingAmount] = {"0", "2/96", "4/96", "6/96", "8/96", "10/96", "12/96"};
+    static int const _grooveAmount = GrooveAmount;
+    static constexpr const char *_grooveDescriptions[_grooveAmount] = {"909", "MPC 54%", "MPC 58%", "MPC 62%", "MPC 66%", "MPC 71%", "MPC 75%", "USER"};
+    static constexpr int _userGrooveIndex = _grooveAmount - 1;
+    static constexpr unsigned long _noGroove = ~0ul;
+    static GrooveTable _userGroove;
 
     // Variables
     int _ID;
     bool _externalClock = false;             // External clock state
     OutputType _outputType;                  // 0 = Digital, 1 = DAC
     int _dividerIndex = 9;                   // Default to 1
+    DividerRatio _ratio = {1, 1};            // Ratio of the divider, the period is PPQN * divide / multiply ticks
     int _dutyCycle = 50;                     // Default to 50%
     int _phase = 0;                          // Phase offset, default to 0% (in phase with master)
     int _level = 100;                        // Output voltage level for DAC outs (Default to 100%)
@@ -221,20 +321,30 @@ class Output {
     unsigned long _internalPulseCounter = 0; // Pulse counter (used for external clock division)
 
     // Waveform generation variables
+    typedef void (Output::*WaveGenerator)(int periodTicks);
+    static const WaveGenerator _waveGenerators[];      // Per tick generator by waveform type, null when there is none
     WaveformType _waveformType = WaveformType::Square; // Default to square wave
+    WaveGenerator _generateWave = nullptr;             // Generator of the current waveform
     bool _waveActive = false;
     bool _waveDirection = true; // Waveform direction (true = up, false = down)
+    bool _glides = false;       // Last tick continued the waveform without a jump
     float _waveValue = 0.0f;
     float _triangleWaveStep = 0.0f;
     float _sineWaveAngle = 0.0f;
     unsigned long _inactiveTickCounter = 0;
     unsigned long _randomTickCounter = 0;
+    Prng _prng;              // Per output generator for probability and noise waveforms
+    ValueNoise _smoothNoise; // Smooth noise state, one random point per period
     unsigned long _envTickCounter = 0; // Logarithmic envelope ticks
 
     // Swing variables
-    int _swingEveryAmount = 16;         // Max swing every value
-    int _swingEvery = 2;                // Swing every x notes
-    unsigned int _swingAmountIndex = 0; // Swing amount index
+    static int const _swingEveryAmount = SwingEveryAmount; // Max swing every value
+    int _swingEvery = 2;                     // Swing every x notes
+    unsigned int _swingAmountIndex = 0;      // Swing amount index
+    int _grooveIndex = 0;                    // 909 (swing amount and every), MPC swings or user
+    GrooveTable _groove = {};                // Step offsets built from the groove settings
+    unsigned long _grooveStep = _noGroove;   // Step of the delay below
+    unsigned long _grooveTicks = 0;          // Delay of the current step
 
     // Euclidean rhythm variables
     int _euclideanStepIndex = 0; // Current step in the pattern
@@ -250,6 +360,14 @@ class Output {
     // Envelope
     bool _triggerMode = false;
     bool _externaltrigger = false;
+    static constexpr int TriggerQueueLength = 4;
+    struct TriggerEdge {
+        unsigned long time;
+        bool state;
+    };
+    TriggerEdge _triggerQueue[TriggerQueueLength]; // Edges queued by an interrupt
+    volatile uint8_t _triggerHead = 0;
+    volatile uint8_t _triggerTail = 0;
     unsigned long _envStartTime = 0;
     float _lastEnvValue = 0.0f; // Stores last envelope value for retriggering
 
@@ -277,6 +395,18 @@ class Output {
 
     // -------------- Private Functions --------------
 
+    void BuildGroove();
+
+    static bool IsEnvelopeType(WaveformType type) {
+        return type == WaveformType::ADEnvelope || type == WaveformType::AREnvelope || type == WaveformType::ADSREnvelope;
+    }
+
+    // Waveforms moving in small steps from tick to tick
+    static bool IsContinuousType(WaveformType type) {
+        return type == WaveformType::Triangle || type == WaveformType::Sine || type == WaveformType::Parabolic || type == WaveformType::Sawtooth ||
+               type == WaveformType::ExpEnvelope || type == WaveformType::LogEnvelope || type == WaveformType::SmoothNoise;
+    }
+
     // Start the waveform generation
     void StartWaveform() {
         _waveActive = true;
@@ -350,7 +480,7 @@ class Output {
             // For AR/ADSR, only trigger release phase
             if (_waveActive && (_waveformType == WaveformType::AREnvelope ||
                                 _waveformType == WaveformType::ADSREnvelope)) {
-                HandleGateRelease();
+                HandleGateRelease(micros());
             }
             break;
         case WaveformType::SmoothNoise:
@@ -367,9 +497,8 @@ class Output {
     }
 
     // Generate a triangle wave
-    void GenerateTriangleWave(int PPQN) {
+    void GenerateTriangleWave(int periodTicks) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
             float risingTicks = periodTicks * (_dutyCycle / 100.0f);
             float fallingTicks = periodTicks - risingTicks;
 
@@ -396,13 +525,10 @@ class Output {
     }
 
     // Generate a sine wave
-    void GenerateSineWave(int PPQN) {
+    void GenerateSineWave(int periodTicks) {
         if (_waveActive) {
-            // Calculate the period of the waveform in ticks
-            float periodInTicks = PPQN / _clockDividers[_dividerIndex];
-
             // Calculate the angle increment per tick
-            float angleIncrement = (2.0f * PI) / periodInTicks;
+            float angleIncrement = (2.0f * PI) / periodTicks;
 
             // Update the angle for the sine function
             _sineWaveAngle += angleIncrement;
@@ -430,10 +556,9 @@ class Output {
     }
 
     // Generate a parabolic wave
-    void GenerateParabolicWave(int PPQN) {
+    void GenerateParabolicWave(int periodTicks) {
         if (_waveActive) {
-            float periodInTicks = PPQN / _clockDividers[_dividerIndex];
-            float activeTicks = periodInTicks * (_dutyCycle / 100.0f);
+            float activeTicks = periodTicks * (_dutyCycle / 100.0f);
             float angleIncrement = (PI) / activeTicks; // Half sine wave for duty cycle
 
             _sineWaveAngle += angleIncrement;
@@ -442,7 +567,7 @@ class Output {
                 // Inactive period
                 _waveActive = false;
                 _isPulseOn = false;
-                _inactiveTickCounter = periodInTicks - activeTicks;
+                _inactiveTickCounter = periodTicks - activeTicks;
             }
 
             // Calculate sine value
@@ -452,9 +577,8 @@ class Output {
     }
 
     // Generate a sawtooth wave
-    void GenerateSawtoothWave(int PPQN) {
+    void GenerateSawtoothWave(int periodTicks) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
             float activeTicks = periodTicks * (_dutyCycle / 100.0f);
             float inactiveTicks = periodTicks - activeTicks;
 
@@ -465,6 +589,7 @@ class Output {
             _waveValue += step;
             if (_waveValue >= MaxWaveValue) {
                 _waveValue = 0.0f;
+                _glides = false;
                 // Adjust for inactive period
                 _waveActive = false;
                 _inactiveTickCounter = inactiveTicks;
@@ -481,47 +606,30 @@ class Output {
     }
 
     // Generate random values
-    void GenerateNoiseWave(int PPQN) {
+    void GenerateNoiseWave(int /* periodTicks */) {
         if (_waveActive) {
             // Generate white noise waveform
-            _waveValue = random(MaxWaveValue + 1); // Random value
+            _waveValue = _prng.Below(MaxWaveValue + 1); // Random value
             _isPulseOn = true;
             _randomTickCounter++;
         }
     }
 
-    // Generate smooth random waveform
-    void GenerateSmoothNoiseWave(int PPQN) {
+    // Generate smooth random waveform gliding to a new random value every period
+    void GenerateSmoothNoiseWave(int periodTicks) {
         if (_waveActive) {
-            // Generate smooth random waveform with smooth peaks and valleys
-            static float phase = 0.0f;
-            static float frequency = 0.3f;             // Adjust frequency for smoothness
-            static float amplitude = MaxWaveValue / 2; // Amplitude for wave value range
-            static float lastValue = MaxWaveValue / 2; // Last generated value
-            static float smoothValue = 50.0f;          // Smoothed value
-
-            // Increment phase
-            phase += frequency;
-
-            // Generate smooth random value using a random walk
-            float randomStep = (static_cast<float>(rand()) / RAND_MAX - 0.5f) * 2.0f; // Random step between -1 and 1
-            lastValue += randomStep * amplitude * frequency;                          // Adjust step size by amplitude and frequency
-            lastValue = fmin(fmax(lastValue, 0.0f), MaxWaveValue);                    // Clamp value
-
-            // Apply a low-pass filter to smooth out the waveform
-            float alpha = 0.01f; // Smoothing factor (0 < alpha < 1)
-            smoothValue = alpha * lastValue + (1.0f - alpha) * smoothValue;
-
-            _waveValue = smoothValue;
-
+            if (_randomTickCounter == 0) {
+                _smoothNoise.Start(_prng, periodTicks);
+            }
+            _waveValue = _smoothNoise.Tick() >> 7; // Q15 to 0-255
             _isPulseOn = true;
+            _randomTickCounter++;
         }
     }
 
     // Generate an exponential envelope waveform
-    void GenerateExpEnvelope(int PPQN) {
+    void GenerateExpEnvelope(int periodTicks) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
             float decayTicks = periodTicks * (_dutyCycle / 100.0f);
 
             if (_envTickCounter >= decayTicks) {
@@ -541,9 +649,8 @@ class Output {
     }
 
     // Generate a logarithm envelope waveform
-    void GenerateLogEnvelope(int PPQN) {
+    void GenerateLogEnvelope(int periodTicks) {
         if (_waveActive) {
-            float periodTicks = PPQN / _clockDividers[_dividerIndex];
             float decayTicks = periodTicks * (_dutyCycle / 100.0f);
 
             if (_envTickCounter >= decayTicks) {
@@ -565,52 +672,42 @@ class Output {
     }
 
     // Generate a Sample and Hold waveform where on each pulse, a random value is generated
-    void GenerateSampleHold(int PPQN) {
+    void GenerateSampleHold(int /* periodTicks */) {
         if (_waveActive) {
             // Generate a random value at the start of each pulse
             if (_randomTickCounter == 0) {
-                _waveValue = random(MaxWaveValue + 1);
+                _waveValue = _prng.Below(MaxWaveValue + 1);
             }
             _isPulseOn = true;
             _randomTickCounter++;
         }
     }
 
-    void HandleTrigger() {
+    void HandleTrigger(unsigned long time) {
         if (_triggerMode && (_waveformType == WaveformType::ADEnvelope || _waveformType == WaveformType::AREnvelope || _waveformType == WaveformType::ADSREnvelope)) {
             if (!_waveActive || _envParams.retrigger) {
                 _lastEnvValue = _envParams.retrigger ? _waveValue : 0.0f;
                 _envState = EnvelopeState::Attack;
-                _envStartTime = micros();
+                _envStartTime = time;
                 _waveActive = true;
                 _isPulseOn = true;
             }
         }
     }
 
-    void HandleGateRelease() {
+    void HandleGateRelease(unsigned long time) {
         if (_triggerMode && (_waveformType == WaveformType::ADEnvelope || _waveformType == WaveformType::AREnvelope || _waveformType == WaveformType::ADSREnvelope)) {
             if (_waveformType == WaveformType::AREnvelope ||
                 _waveformType == WaveformType::ADSREnvelope) {
                 if (_waveActive && _envState != EnvelopeState::Release) {
                     _lastEnvValue = _waveValue;
                     _envState = EnvelopeState::Release;
-                    _envStartTime = micros();
+                    _envStartTime = time;
                 }
             }
         }
     }
 
-    float ApplyCurve(float input, float curve) {
-        // input and output are 0-1 range
-        if (curve == 0.5f)
-            return input; // Linear
-
-        // Convert curve 0-1 to power range 0.1 to 10
-        float power = pow(10.0f, (curve - 0.5f) * 2.0f);
-        return pow(input, power);
-    }
-
     // Generate an Attack-Decay envelope waveform
     void GenerateADEnvelope() {
         if (!_waveActive)
@@ -766,10 +863,17 @@ class Output {
 Output::Output(int ID, OutputType type) {
     _ID = ID;
     _outputType = type;
+    _prng.Seed(PRNG_DEFAULT_SEED + ID);
     GeneratePattern(_euclideanParams, _euclideanRhythm);
 }
 
 void Output::GenEnvelope() {
+    // Edges from the CV interrupt, in order
+    while (_triggerTail != _triggerHead) {
+        const TriggerEdge &edge = _triggerQueue[_triggerTail % TriggerQueueLength];
+        SetExternalTrigger(edge.state, edge.time);
+        _triggerTail = _triggerTail + 1;
+    }
     // Handle envelope generation based on trigger state
     if (_triggerMode) {
         switch (_waveformType) {
@@ -789,49 +893,89 @@ void Output::GenEnvelope() {
     }
 }
 
-void Output::Pulse(int PPQN, unsigned long globalTick) {
+template <OutputType Kind, int PPQN>
+void Output::Pulse(unsigned long globalTick) {
+    static_assert(PPQN * 128ul * MaxRatio < (1ul << 31), "Period products must fit 32 bits");
     // If not stopped, generate the pulse
     if (!_state) {
-        StopWaveform();
+        if constexpr (Kind == OutputType::DigitalOut) {
+            SetPulse(false);
+        } else {
+            StopWaveform();
+            _glides = false;
+        }
         return;
     }
-    // Calculate the period duration in ticks
-    float periodTicks = PPQN / _clockDividers[_dividerIndex];
-
-    // Calculate the phase offset in ticks
-    unsigned long phaseOffsetTicks = periodTicks * (_phase / 100.0);
-
-    // Apply swing to the tick counter
+    // Waveform starts and restarts jump, cleared by the lambdas below
+    const bool wasOn = _isPulseOn;
+    _glides = Kind == OutputType::DACOut && IsContinuousType(_waveformType);
+    // Period duration in ticks, num / den exactly, 0 for Env which is triggered instead of clocked
+    const DividerRatio ratio = _ratio;
+    const unsigned long num = PPQN * ratio.divide;
+    const unsigned long den = ratio.multiply;
+    int periodTicks = den > 0 ? (num + den / 2) / den : 0; // Rounded, for the wave generators
+
+    // Calculate the phase offset in ticks, integer math as this runs in the clock ISR (num * 100 fits)
+    unsigned long phaseOffsetTicks = den > 0 ? num * _phase / (100 * den) : 0;
+
+    // Delay the tick counter by the groove offset of the step, looked up when the step changes.
+    // The delay stays within the shortest period so the next step never starts before it.
     unsigned long tickCounterSwing = globalTick;
-
-    // Calculate the tick counter with swing applied
-    if (int(globalTick / periodTicks) % _swingEvery == 0) {
-        tickCounterSwing = globalTick - (_swingAmounts[_swingAmountIndex] * PPQN / 96); // Since our swing is in 96th notes
+    if (den > 0 && _groove.steps > 0) {
+        unsigned long step = PeriodIndex(globalTick, num, den);
+        if (step != _grooveStep) {
+            _grooveStep = step;
+            unsigned long offset = _groove.offsets[step % _groove.steps] * PPQN / GROOVE_RESOLUTION;
+            _grooveTicks = offset < num / den ? offset : num / den - 1;
+        }
+        tickCounterSwing = globalTick - _grooveTicks;
     }
 
-    // Calculate the clock divider for external clock
-    int clockDividerExternal = 1 / _clockDividers[_dividerIndex];
+    // Calculate the pulse duration (in ticks) based on the duty cycle, within the shortest period
+    unsigned int _pulseDuration = den > 0 ? num * _dutyCycle / (100 * den) : 0;
+    if (den > 0 && _pulseDuration >= num / den) {
+        _pulseDuration = num / den - 1;
+    }
 
-    // Calculate the pulse duration (in ticks) based on the duty cycle
-    unsigned int _pulseDuration = int(periodTicks * (_dutyCycle / 100.0));
-    unsigned int _externalPulseDuration = int(clockDividerExternal * (_dutyCycle / 100.0));
+    // Gate outputs are always square, the pulse is the output
+    auto start = [this]() {
+        if constexpr (Kind == OutputType::DigitalOut) {
+            SetPulse(true);
+        } else {
+            StartWaveform();
+            _glides = false;
+        }
+    };
+    auto skip = [this]() {
+        if constexpr (Kind == OutputType::DACOut) {
+            ResetWaveform();
+            _glides = false;
+        }
+    };
+    auto stop = [this]() {
+        if constexpr (Kind == OutputType::DigitalOut) {
+            SetPulse(false);
+        } else {
+            StopWaveform();
+        }
+    };
 
     // Lambda function to handle timing
-    auto generatePulse = [this]() {
+    auto generatePulse = [this, &start, &skip]() {
         if (!_euclideanParams.enabled) {
             // If not using Euclidean rhythm, generate waveform based on the pulse probability
-            if (random(100) < _pulseProbability) {
-                StartWaveform();
+            if (int(_prng.Below(100)) < _pulseProbability) {
+                start();
             } else {
                 // We stop the waveform directly if the pulse probability is not met since StopWaveform() is used for the square wave
-                ResetWaveform();
+                skip();
             }
         } else {
             // If using Euclidean rhythm, check if the current step is active
             if (_euclideanRhythm[_euclideanStepIndex] == 1) {
-                StartWaveform();
+                start();
             } else {
-                ResetWaveform();
+                skip();
             }
             _euclideanStepIndex++;
             // Restart the Euclidean rhythm if it reaches the end
@@ -841,73 +985,105 @@ void Output::Pulse(int PPQN, unsigned long globalTick) {
         }
     };
 
-    // If using an external clock, generate a pulse based on the internal pulse counter
-    // dirty workaround to make this work with clock dividers
-    if (_externalClock && _clockDividers[_dividerIndex] < 1) {
-        if (_internalPulseCounter % clockDividerExternal == 0 || _internalPulseCounter == 0) {
+    // If using an external clock, generate a pulse based on the internal pulse counter, the
+    // period is divide / multiply external pulses
+    if (den == 0) {
+        // Env outputs are triggered, not clocked
+    } else if (_externalClock && ratio.multiply < ratio.divide) {
+        unsigned long offset = PeriodOffset(_internalPulseCounter, ratio.divide, ratio.multiply);
+        unsigned int _externalPulseDuration = ratio.divide * _dutyCycle / (100 * ratio.multiply);
+        if (offset == 0) {
             generatePulse();
-        } else if (_internalPulseCounter % clockDividerExternal == _externalPulseDuration) {
-            StopWaveform();
+        } else if (offset == _externalPulseDuration) {
+            stop();
         }
     } else {
         // Handle internal clock timing
-        if ((tickCounterSwing - phaseOffsetTicks) % int(periodTicks) == 0 || (globalTick == 0)) {
+        unsigned long offset = PeriodOffset(tickCounterSwing - phaseOffsetTicks, num, den);
+        if (offset == 0 || (globalTick == 0)) {
             generatePulse();
-        } else if ((tickCounterSwing - phaseOffsetTicks) % int(periodTicks) == _pulseDuration) {
-            StopWaveform();
+        } else if (offset == _pulseDuration) {
+            stop();
         }
     }
-    // Handle the waveform generation
-    switch (_waveformType) {
-    case WaveformType::Triangle:
-        GenerateTriangleWave(PPQN);
-        break;
-    case WaveformType::Sine:
-        GenerateSineWave(PPQN);
-        break;
-    case WaveformType::Parabolic:
-        GenerateParabolicWave(PPQN);
-        break;
-    case WaveformType::Sawtooth:
-        GenerateSawtoothWave(PPQN);
-        break;
-    case WaveformType::Noise:
-        GenerateNoiseWave(PPQN);
-        break;
-    case WaveformType::SmoothNoise:
-        GenerateSmoothNoiseWave(PPQN);
-        break;
-    case WaveformType::ExpEnvelope:
-        GenerateExpEnvelope(PPQN);
-        break;
-    case WaveformType::LogEnvelope:
-        GenerateLogEnvelope(PPQN);
-        break;
-    case WaveformType::SampleHold:
-        GenerateSampleHold(PPQN);
-        break;
-    default:
-        // For square wave or other types
-        break;
+    // Handle the waveform generation, square and triggered envelopes have no per tick generator
+    if constexpr (Kind == OutputType::DACOut) {
+        if (_generateWave != nullptr) {
+            (this->*_generateWave)(periodTicks);
+        }
+        if (_isPulseOn != wasOn) {
+            _glides = false; // The level jumps to or from the offset
+        }
     }
 }
 
+GrooveTable Output::_userGroove = {};
+
+// Indexed by WaveformType
+const Output::WaveGenerator Output::_waveGenerators[] = {
+    nullptr, // Square
+    &Output::GenerateTriangleWave,
+    &Output::GenerateSineWave,
+    &Output::GenerateParabolicWave,
+    &Output::GenerateSawtoothWave,
+    &Output::GenerateExpEnvelope,
+    &Output::GenerateLogEnvelope,
+    &Output::GenerateNoiseWave,
+    &Output::GenerateSmoothNoiseWave,
+    &Output::GenerateSampleHold,
+    nullptr, // ADEnvelope
+    nullptr, // AREnvelope
+    nullptr, // ADSREnvelope
+};
+
 void Output::SetWaveformType(WaveformType type) {
+    // Gate outputs can only be high or low
+    if (_outputType == OutputType::DigitalOut) {
+        type = WaveformType::Square;
+    }
+    // The type indexes the generator table
+    type = static_cast<WaveformType>(constrain(int(type), 0, WaveformTypeLength - 1));
     _waveformType = type;
-    if (_waveformType == WaveformType::ADEnvelope || _waveformType == WaveformType::AREnvelope || _waveformType == WaveformType::ADSREnvelope) {
+    _generateWave = _waveGenerators[type];
+    if (IsEnvelopeType(_waveformType)) {
         _waveActive = false;
         _envState = EnvelopeState::Idle;
         _waveValue = 0.0f;
         _lastEnvValue = 0.0f;
         _envStartTime = 0;
         _triggerMode = true;
-        SetDivider(18);
+        SetDivider(_envDivider);
     } else {
         _triggerMode = false;
         SetDivider(9);
     }
 }
 
+void Output::SetDivider(int index) {
+    if (IsCustomRatio(index)) {
+        int ratio = index - _dividerAmount;
+        _ratio = {uint8_t(ratio / MaxRatio + 1), uint8_t(ratio % MaxRatio + 1)};
+        // The ratios of the list keep their index
+        for (int i = 0; i < _envDivider; i++) {
+            if (_dividerRatios[i].multiply * _ratio.divide == _ratio.multiply * _dividerRatios[i].divide) {
+                index = i;
+                break;
+            }
+        }
+    }
+    _dividerIndex = IsCustomRatio(index) ? index : constrain(index, 0, _dividerAmount - 1);
+    if (!IsCustomRatio(index)) {
+        _ratio = _dividerRatios[_dividerIndex];
+    }
+}
+
+String Output::GetDividerDescription() {
+    if (IsCustomRatio(_dividerIndex)) {
+        return String(_ratio.multiply) + ":" + String(_ratio.divide);
+    }
+    return _dividerDescription[_dividerIndex];
+}
+
 // Check if the pulse state has changed
 bool Output::HasPulseChanged() {
     bool pulseChanged = (_isPulseOn != _lastPulseState);
@@ -927,15 +1103,40 @@ void Output::SetMasterState(bool state) {
     }
 }
 
+// Build the step offsets of the groove, the next tick looks up its step again
+void Output::BuildGroove() {
+    if (_grooveIndex == _userGrooveIndex) {
+        _groove = _userGroove;
+    } else if (_grooveIndex > 0) {
+        _groove = SwingGroove(MPCSwings[_grooveIndex - 1]);
+    } else {
+        _groove = ShuffleGroove(_swingAmounts[_swingAmountIndex], _swingEvery);
+    }
+    _grooveStep = _noGroove;
+}
+
+void Output::Restart() {
+    _euclideanStepIndex = 0;
+    _internalPulseCounter = 0;
+    _randomTickCounter = 0;
+    _inactiveTickCounter = 0;
+    _envTickCounter = 0;
+    // Triggered envelopes follow their trigger, not the clock
+    if (!_triggerMode) {
+        ResetWaveform();
+    }
+}
+
 // Master stop, stops all outputs but on resume, the outputs will resume to previous state
 void Output::ToggleMasterState() {
     SetMasterState(!_masterState);
 }
 
 // Output Level based on the output type and pulse state
+template <OutputType Kind>
 int Output::GetOutputLevel() {
     float adjustedLevel;
-    if (_outputType == OutputType::DigitalOut) {
+    if constexpr (Kind == OutputType::DigitalOut) {
         return _isPulseOn ? HIGH : LOW;
     } else {
         if (_waveformType == WaveformType::Square) {
@@ -996,3 +1197,82 @@ void Output::SetEuclideanPadding(int pad) {
         GeneratePattern(_euclideanParams, _euclideanRhythm);
     }
 }
+
+// Clamp a raw scene block to the valid parameter ranges and pre-generate its Euclidean pattern.
+// Runs outside the ISR so publishing the scene later is just a copy.
+void Output::PrepareScene(OutputScene &scene) {
+    scene.dutyCycle = constrain(scene.dutyCycle, 1, 99);
+    scene.level = constrain(scene.level, 0, 100);
+    scene.offset = constrain(scene.offset, 0, 100);
+    scene.swingAmountIndex = constrain(scene.swingAmountIndex, 0, _swingAmount - 1);
+    scene.swingEvery = constrain(scene.swingEvery, 1, _swingEveryAmount);
+    scene.groove = constrain(scene.groove, 0, _grooveAmount - 1);
+    scene.pulseProbability = constrain(scene.pulseProbability, 0, 100);
+    scene.phase = constrain(scene.phase, 0, 100);
+    scene.waveformType = static_cast<WaveformType>(constrain(int(scene.waveformType), 0, WaveformTypeLength - 1));
+
+    // Envelopes are only triggered by CV so they always use the "Env" divider, like SetWaveformType() does
+    if (IsEnvelopeType(scene.waveformType)) {
+        scene.dividerIndex = _envDivider;
+    } else if (!IsCustomRatio(scene.dividerIndex)) {
+        scene.dividerIndex = constrain(scene.dividerIndex, 0, _envDivider - 1);
+    }
+
+    EuclideanParams &e = scene.euclideanParams;
+    e.steps = constrain(e.steps, 1, MaxEuclideanSteps);
+    e.triggers = constrain(e.triggers, 1, e.steps);
+    e.rotation = constrain(e.rotation, 0, e.steps - 1);
+    e.pad = constrain(e.pad, 0, MaxEuclideanSteps - e.steps);
+
+    int rhythm[MaxEuclideanSteps];
+    GeneratePattern(e, rhythm);
+    scene.euclideanRhythm = 0;
+    for (int i = 0; i < e.steps + e.pad; i++) {
+        if (rhythm[i]) {
+            scene.euclideanRhythm |= (uint64_t)1 << i;
+        }
+    }
+}
+
+// Publish a prepared scene block. Called from the clock ISR on a beat boundary so it only copies
+// parameters and resets the waveform state when the waveform type actually changes.
+void Output::ApplyScene(const OutputScene &scene) {
+    SetDivider(scene.dividerIndex);
+    _dutyCycle = scene.dutyCycle;
+    _level = scene.level;
+    _offset = scene.offset;
+    _swingAmountIndex = scene.swingAmountIndex;
+    _swingEvery = scene.swingEvery;
+    _grooveIndex = scene.groove;
+    BuildGroove();
+    _pulseProbability = scene.pulseProbability;
+    _phase = scene.phase;
+    _envParams = scene.envParams;
+
+    // Keep the master stop working, the scene state is restored on resume
+    if (_masterState) {
+        _state = scene.state;
+    } else {
+        _oldState = scene.state;
+    }
+
+    _euclideanParams = scene.euclideanParams;
+    uint64_t rhythm = scene.euclideanRhythm;
+    for (int i = 0; i < MaxEuclideanSteps; i++) {
+        _euclideanRhythm[i] = rhythm & 1;
+        rhythm >>= 1;
+    }
+    if (_euclideanStepIndex >= _euclideanParams.steps + _euclideanParams.pad) {
+        _euclideanStepIndex = 0;
+    }
+
+    if (scene.waveformType != _waveformType && _outputType == OutputType::DACOut) {
+        _waveformType = scene.waveformType;
+        _generateWave = _waveGenerators[_waveformType];
+        _triggerMode = IsEnvelopeType(_waveformType);
+        _waveActive = false;
+        _envState = EnvelopeState::Idle;
+        _waveValue = 0.0f;
+        _lastEnvValue = 0.0f;
+    }
+}
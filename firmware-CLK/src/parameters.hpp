@@ -0,0 +1,85 @@
+#pragma once
+#include <stdint.h>
+
+// Parameter IDs used by the serial protocol. The IDs are part of the protocol so new
+// parameters must be appended, scripts/forgectl.py keeps a copy of this list.
+enum ParamID : uint8_t {
+    // Global parameters (channel 0)
+    ParamBPM = 0,
+    ParamMasterState,
+    ParamExternalDivider,
+    ParamExternalClock, // Read only
+    ParamScene,
+    ParamSceneSync,
+    // Output parameters (channel = output index)
+    ParamDivider,
+    ParamDutyCycle,
+    ParamOutputState,
+    ParamLevel,
+    ParamOffset,
+    ParamSwingAmount,
+    ParamSwingEvery,
+    ParamProbability,
+    ParamEuclidean,
+    ParamEuclideanSteps,
+    ParamEuclideanTriggers,
+    ParamEuclideanRotation,
+    ParamEuclideanPadding,
+    ParamPhase,
+    ParamWaveform,
+    ParamAttack,  // ms
+    ParamDecay,   // ms
+    ParamSustain, // %
+    ParamRelease, // ms
+    ParamCurve,   // %
+    ParamRetrigger,
+    // CV input parameters (channel = CV input index)
+    ParamCVTarget,
+    ParamCVAttenuation,
+    ParamCVOffset,
+    // Global parameters added later (channel 0)
+    ParamTransportSync,
+    // Output parameters added later (channel = output index)
+    ParamGroove,
+    // Read only stats (the last IDs), read on request instead of streamed, writing one restarts them
+    ParamLoopDuty,        // Share of the time spent in the loop tasks in 0.01%
+    ParamTaskRuns,        // Channel = loop task index
+    ParamTaskMisses,      // Periods skipped because the task ran a whole period late
+    ParamTaskMaxLateness, // us after the deadline
+    ParamTaskMaxDuration, // us
+    ParamI2CSent,         // Channel = I2C client, 0 DAC and 1 display
+    ParamI2CDropped,      // Queue full or transaction too long
+    ParamI2CDepth,        // Transactions waiting now
+    ParamI2CMaxDepth,
+    ParamI2CMaxWait,      // Longest time (us) from the queue to the bus
+    ParamBootTime,        // us from reset to the first clock tick, 0 before it, not writable
+    ParamCount,
+};
+
+// Amount of channels for a parameter
+int ParamChannels(uint8_t id, int outputs, int cvInputs, int tasks, int i2cClients) {
+    if (id < ParamDivider || id == ParamTransportSync || id == ParamLoopDuty || id == ParamBootTime) {
+        return 1;
+    }
+    if (id < ParamCVTarget) {
+        return outputs;
+    }
+    if (id < ParamTransportSync) {
+        return cvInputs;
+    }
+    if (id == ParamGroove) {
+        return outputs;
+    }
+    if (id >= ParamTaskRuns && id <= ParamTaskMaxDuration) {
+        return tasks;
+    }
+    if (id >= ParamI2CSent && id <= ParamI2CMaxWait) {
+        return i2cClients;
+    }
+    return 0;
+}
+
+// Stats change all the time, they are not streamed
+bool ParamIsStat(uint8_t id) {
+    return id >= ParamLoopDuty && id < ParamCount;
+}
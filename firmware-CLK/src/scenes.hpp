@@ -0,0 +1,101 @@
+#pragma once
+#include <Arduino.h>
+
+#include "engine.hpp"
+#include "loadsave.hpp"
+#include "outputs.hpp"
+
+// Scene switch quantization
+enum SceneSync {
+    SyncBeat = 0,
+    SyncBar,
+};
+String SceneSyncDescriptions[] = {"BEAT", "BAR"};
+const int SceneSyncLength = sizeof(SceneSyncDescriptions) / sizeof(SceneSyncDescriptions[0]);
+
+// A preset slot decoded into ready-to-publish parameter blocks.
+// The output blocks are published by the clock ISR on a beat/bar boundary, the global settings
+// (BPM, external divider and CV inputs) are applied from the loop right after.
+struct Scene {
+    unsigned int BPM;
+    unsigned int externalClockDivIdx;
+    OutputScene outputs[NUM_OUTPUTS];
+    byte CVInputTarget[NUM_CV_INS];
+    int CVInputAttenuation[NUM_CV_INS];
+    int CVInputOffset[NUM_CV_INS];
+    GrooveTable userGroove;
+};
+
+Scene scenes[NUM_SLOTS];
+Scene *volatile pendingScene = nullptr; // Scene waiting for the next boundary
+Scene *volatile appliedScene = nullptr; // Scene published by the ISR, global settings still pending
+int activeScene = -1;                   // Last requested scene index
+SceneSync sceneSync = SceneSync::SyncBar;
+
+// Decode the preset params into a scene
+void DecodeScene(const LoadSaveParams &p, Scene &scene) {
+    scene.BPM = p.BPM;
+    scene.externalClockDivIdx = p.externalClockDivIdx;
+    for (int i = 0; i < NUM_OUTPUTS; i++) {
+        OutputScene &o = scene.outputs[i];
+        o.dividerIndex = p.divIdx[i];
+        o.dutyCycle = p.dutyCycle[i];
+        o.state = p.outputState[i];
+        o.level = p.outputLevel[i];
+        o.offset = p.outputOffset[i];
+        o.swingAmountIndex = p.swingIdx[i];
+        o.swingEvery = p.swingEvery[i];
+        o.pulseProbability = p.pulseProbability[i];
+        o.euclideanParams = p.euclideanParams[i];
+        o.phase = p.phaseShift[i];
+        o.waveformType = static_cast<WaveformType>(p.waveformType[i]);
+        o.envParams = p.envParams[i];
+        o.groove = p.groove[i];
+        Output::PrepareScene(o);
+    }
+    for (int i = 0; i < NUM_CV_INS; i++) {
+        scene.CVInputTarget[i] = p.CVInputTarget[i];
+        scene.CVInputAttenuation[i] = p.CVInputAttenuation[i];
+        scene.CVInputOffset[i] = p.CVInputOffset[i];
+    }
+    scene.userGroove = UserGroove(p.userGroove.offsets, p.userGroove.steps);
+}
+
+// Decode a preset into its scene slot. A pending switch is cancelled so the ISR never reads a half written scene.
+void StoreScene(const LoadSaveParams &p, int slot) {
+    if (slot < 0 || slot >= NUM_SLOTS)
+        return;
+    pendingScene = nullptr;
+    DecodeScene(p, scenes[slot]);
+}
+
+// Decode all preset slots from flash memory
+void LoadScenes() {
+    for (int i = 0; i < NUM_SLOTS; i++) {
+        DecodeScene(Load(i), scenes[i]);
+    }
+}
+
+// Queue a scene to be published on the next beat/bar boundary
+bool RequestScene(int slot) {
+    if (slot < 0 || slot >= NUM_SLOTS)
+        return false;
+    activeScene = slot;
+    pendingScene = &scenes[slot];
+    return true;
+}
+
+// Publish the pending scene to the outputs if the current tick is a switch boundary. Called from the clock ISR.
+template <size_t N>
+void PublishScene(Output (&outs)[N], unsigned long beat) {
+    Scene *scene = pendingScene;
+    if (scene == nullptr || (sceneSync == SceneSync::SyncBar && beat % BEATS_PER_BAR != 0)) {
+        return;
+    }
+    Output::SetUserGroove(scene->userGroove);
+    for (size_t i = 0; i < N; i++) {
+        outs[i].ApplyScene(scene->outputs[i]);
+    }
+    appliedScene = scene;
+    pendingScene = nullptr;
+}
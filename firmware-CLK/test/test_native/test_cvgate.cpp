@@ -0,0 +1,83 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "cvadc.hpp"
+#include "cvgate.hpp"
+
+#define MAXDAC 4095
+
+static const int cvPins[] = {8, 9};
+static std::vector<std::pair<int, int>> samples;
+
+static void Sample(int input, uint16_t value) { samples.push_back({input, value}); }
+
+// Scaled value as HandleCVTarget() computes it
+static float Scaled(int raw, float adcOffset, float adcCal, int attenuation, int offset) {
+    float calibrated = std::max((raw - adcOffset) * adcCal, 0.0f);
+    return std::min(std::max(calibrated * (100 - attenuation) / 100.0f + offset / 100.0f * MAXDAC, 0.0f), float(MAXDAC));
+}
+
+// Test the detector switches once per edge with the hysteresis
+TEST(CVGate, Hysteresis) {
+    GateDetector gate;
+    EXPECT_EQ(gate.Update(4000), 0); // Disabled
+    gate.Configure({2100, 1900}, true);
+    EXPECT_EQ(gate.Update(2050), 0);
+    EXPECT_EQ(gate.Update(2101), 1);
+    EXPECT_EQ(gate.Update(1950), 0); // Noise around the middle
+    EXPECT_EQ(gate.Update(2150), 0);
+    EXPECT_EQ(gate.Update(1899), -1);
+    EXPECT_EQ(gate.Update(2000), 0);
+    EXPECT_FALSE(gate.Level());
+
+    // Enabling again restarts low
+    gate.Update(3000);
+    gate.Configure({2100, 1900}, false);
+    gate.Configure({2100, 1900}, true);
+    EXPECT_FALSE(gate.Level());
+}
+
+// Test the raw thresholds match the middle of the scaled value
+TEST(CVGate, RawThresholds) {
+    const int settings[][2] = {{0, 0}, {50, 0}, {0, 25}, {30, 10}, {90, 45}};
+    for (const auto &setting : settings) {
+        GateThresholds thresholds = GateRawThresholds(MAXDAC / 2, 0, 23, 1.018f, (100 - setting[0]) / 100.0f, setting[1] / 100.0f * MAXDAC);
+        for (int raw = 0; raw <= MAXDAC; raw++) {
+            if (raw > thresholds.high + 1) {
+                ASSERT_GT(Scaled(raw, 23, 1.018f, setting[0], setting[1]), MAXDAC / 2) << raw;
+            } else if (raw < thresholds.high) {
+                ASSERT_LE(Scaled(raw, 23, 1.018f, setting[0], setting[1]), MAXDAC / 2) << raw;
+            }
+        }
+    }
+}
+
+// Test settings that keep the scaled value on one side
+TEST(CVGate, ConstantLevel) {
+    GateDetector gate;
+    gate.Configure(GateRawThresholds(MAXDAC / 2, 80, 23, 1.018f, 0, 0), true); // Fully attenuated
+    EXPECT_EQ(gate.Update(4095), 0);
+    gate.Configure(GateRawThresholds(MAXDAC / 2, 80, 23, 1.018f, 1, 0.9f * MAXDAC), true); // Offset above the middle
+    EXPECT_EQ(gate.Update(0), 1);
+    EXPECT_EQ(gate.Update(0), 0);
+}
+
+// Test the inputs are converted in turn and averaged for the loop
+TEST(CVADC, Rotation) {
+    samples.clear();
+    CVADCInit(cvPins, 2, Sample);
+    for (int i = 0; i < CVADC_SUM; i++) {
+        CVADCFakeConvert(1000 + i);
+        CVADCFakeConvert(3000);
+    }
+    ASSERT_EQ(samples.size(), 2u * CVADC_SUM);
+    EXPECT_EQ(samples[0], std::make_pair(0, 1000));
+    EXPECT_EQ(samples[1], std::make_pair(1, 3000));
+    EXPECT_EQ(CVADCRead(0), 1000 + (CVADC_SUM - 1) / 2);
+    EXPECT_EQ(CVADCRead(1), 3000);
+    EXPECT_EQ(cvADCFakeSelects, 2ul * CVADC_SUM); // The next input is selected from the result
+}
@@ -0,0 +1,90 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <stdio.h>
+#include <unistd.h>
+
+#include "cvreplay.hpp"
+
+static std::vector<TraceEvent> recording;
+
+static const TraceEvent &Sample(int index) { return recording[index]; }
+
+// Test the samples are replayed at their offsets from the first one and held
+TEST(CVReplay, Timing) {
+    recording = {{1000, 100, 0}, {1000, 2000, 1}, {3000, 4000, 0}, {7000, 50, 1}};
+    CVPlayer player;
+    uint16_t value;
+    EXPECT_FALSE(player.Read(0, 0, value));
+
+    player.Start(Sample, recording.size(), 0xFFFFF000); // Wraps during the replay
+    ASSERT_TRUE(player.Read(0xFFFFF000, 0, value));
+    EXPECT_EQ(100, value);
+    ASSERT_TRUE(player.Read(0xFFFFF000, 1, value));
+    EXPECT_EQ(2000, value);
+    ASSERT_TRUE(player.Read(0xFFFFF000 + 1999, 0, value));
+    EXPECT_EQ(100, value);
+    ASSERT_TRUE(player.Read(0xFFFFF000 + 2000, 0, value));
+    EXPECT_EQ(4000, value);
+    EXPECT_FALSE(player.Finished());
+    ASSERT_TRUE(player.Read(0xFFFFF000 + 9000, 1, value));
+    EXPECT_EQ(50, value);
+    EXPECT_TRUE(player.Finished());
+    ASSERT_TRUE(player.Read(0xFFFFF000 + 50000, 0, value));
+    EXPECT_EQ(4000, value);
+
+    player.Stop();
+    EXPECT_FALSE(player.Read(0, 0, value));
+}
+
+// Test an input without samples reads live until its first sample
+TEST(CVReplay, InputWithoutSample) {
+    recording = {{0, 10, 0}, {500, 20, 1}};
+    CVPlayer player;
+    uint16_t value;
+    player.Start(Sample, recording.size(), 100);
+    EXPECT_FALSE(player.Read(100, 1, value));
+    EXPECT_TRUE(player.Read(600, 1, value));
+    EXPECT_EQ(20, value);
+    EXPECT_FALSE(player.Read(600, CV_REPLAY_INPUTS, value));
+}
+
+// Test the due samples are played in time order, each one once
+TEST(CVReplay, Play) {
+    recording = {{0, 10, 0}, {100, 20, 1}, {200, 30, 0}, {300, 40, CV_REPLAY_INPUTS}, {400, 50, 0}};
+    CVPlayer player;
+    std::vector<std::pair<int, int>> played;
+    auto record = [&played](int input, uint16_t value) { played.push_back({input, value}); };
+    player.Play(1000, record); // Not running
+    EXPECT_TRUE(played.empty());
+
+    player.Start(Sample, recording.size(), 1000);
+    player.Play(1350, record);
+    EXPECT_EQ(played, (std::vector<std::pair<int, int>>{{0, 10}, {1, 20}, {0, 30}}));
+    uint16_t value;
+    ASSERT_TRUE(player.Read(1350, 0, value)); // Played already
+    EXPECT_EQ(30, value);
+    player.Play(1400, record);
+    EXPECT_EQ(played.size(), 4u);
+    EXPECT_EQ(played.back(), std::make_pair(0, 50));
+}
+
+// Test a CSV recording is loaded, the header skipped
+TEST(CVReplay, LoadCSV) {
+    char path[] = "/tmp/cvreplayXXXXXX";
+    int fd = mkstemp(path);
+    ASSERT_GE(fd, 0);
+    FILE *f = fdopen(fd, "w");
+    fputs("time,input,value\n120,0,4095\n2120,1,7\n", f);
+    fclose(f);
+
+    std::vector<TraceEvent> samples;
+    ASSERT_TRUE(LoadCVRecording(path, samples));
+    unlink(path);
+    ASSERT_EQ(2u, samples.size());
+    EXPECT_EQ(120u, samples[0].time);
+    EXPECT_EQ(4095, samples[0].value);
+    EXPECT_EQ(1, samples[1].channel);
+    EXPECT_FALSE(LoadCVRecording("/nonexistent/cv.csv", samples));
+}
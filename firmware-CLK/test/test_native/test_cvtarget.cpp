@@ -0,0 +1,111 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <vector>
+
+#include "cvtarget.hpp"
+
+// Outputs and transport of a module for the targets
+struct FakeOutput {
+    int divider = -1;
+    int level = -1;
+    std::vector<std::pair<bool, unsigned long>> triggers;
+    int GetDividerAmounts() { return 18; }
+    void SetDivider(int value) { divider = value; }
+    void SetLevel(int value) { level = value; }
+    void QueueExternalTrigger(bool state, unsigned long time) { triggers.push_back({state, time}); }
+    void SetExternalTrigger(bool state) { triggers.push_back({state, 0}); }
+    // Unused by the tests
+    void SetPulseProbability(int) {}
+    int GetSwingAmounts() { return 6; }
+    void SetSwingAmount(int) {}
+    int GetSwingEveryAmounts() { return 16; }
+    void SetSwingEvery(int) {}
+    void SetOffset(int) {}
+    void SetWaveformType(int) {}
+    void SetDutyCycle(int) {}
+};
+
+struct FakeModule {
+    static const int GateCount = 2;
+    static const int MinBPM = 10;
+    static const int MaxBPM = 300;
+    static const int SceneCount = 4;
+    static const int WaveformCount = 10;
+    typedef int Waveform;
+
+    FakeOutput outputs[4];
+    std::vector<int> transport; // 1 start, 0 stop, -1 reset
+    int bpm = 0;
+    int scene = -1;
+
+    void Transport(bool run) { transport.push_back(run); }
+    void Reset() { transport.push_back(-1); }
+    void SetBPM(int value) { bpm = value; }
+    void SelectScene(int value) { scene = value; }
+};
+
+// Test the raw gate thresholds match the middle of the scaled value
+TEST(CVTarget, GateThresholds) {
+    const int settings[][2] = {{0, 0}, {50, 0}, {0, 25}, {30, 10}, {90, 45}};
+    for (const auto &setting : settings) {
+        GateThresholds thresholds = CVGateThresholds(23, 1.018f, setting[0], setting[1]);
+        for (int raw = 0; raw <= CV_MAX; raw++) {
+            float scaled = CVScale(CVCalibrate(raw, 23, 1.018f), setting[0], setting[1]);
+            if (raw > thresholds.high + 1) {
+                ASSERT_GT(scaled, CV_MAX / 2 + CV_GATE_HYSTERESIS) << raw;
+            } else if (raw < thresholds.low) {
+                ASSERT_LT(scaled, CV_MAX / 2 - CV_GATE_HYSTERESIS + 1) << raw;
+            }
+        }
+    }
+}
+
+// Test the scaling keeps the value in range
+TEST(CVTarget, Scale) {
+    EXPECT_EQ(CVCalibrate(10, 23, 1.018f), 0);
+    EXPECT_FLOAT_EQ(CVScale(4000, 50, 0), 2000);
+    EXPECT_FLOAT_EQ(CVScale(4000, 0, 10), CV_MAX);
+    EXPECT_FLOAT_EQ(CVScale(0, 0, -10), 0);
+
+    float value = 0;
+    EXPECT_TRUE(CVSmooth(value, 100));
+    EXPECT_FLOAT_EQ(value, 50);
+    EXPECT_FALSE(CVSmooth(value, 60)); // Moves by 5
+}
+
+// Test the continuous targets, the reset fires once per rise
+TEST(CVTarget, Apply) {
+    FakeModule module;
+    CVTargetState state;
+    CVTargetApply(module, CVTarget::Reset, 3000, false, state);
+    CVTargetApply(module, CVTarget::Reset, 3500, false, state);
+    CVTargetApply(module, CVTarget::Reset, 1000, false, state);
+    CVTargetApply(module, CVTarget::Reset, 3000, false, state);
+    EXPECT_EQ(module.transport, (std::vector<int>{-1, -1}));
+    CVTargetApply(module, CVTarget::StartStop, 3000, true, state); // Detected on the gate edges
+    EXPECT_EQ(module.transport.size(), 2u);
+
+    CVTargetApply(module, CVTarget::Div2, CV_MAX, false, state);
+    EXPECT_EQ(module.outputs[1].divider, 17);
+    CVTargetApply(module, CVTarget::Output4Level, CV_MAX / 2, false, state);
+    EXPECT_EQ(module.outputs[3].level, 49);
+    CVTargetApply(module, CVTarget::SetBPM, CV_MAX, false, state);
+    EXPECT_EQ(module.bpm, 300);
+    CVTargetApply(module, CVTarget::SceneSelect, CV_MAX, false, state);
+    EXPECT_EQ(module.scene, 3);
+}
+
+// Test the gate edges
+TEST(CVTarget, GateApply) {
+    FakeModule module;
+    CVGateApply(module, CVTarget::StartStop, 1, 10);
+    CVGateApply(module, CVTarget::StartStop, -1, 20);
+    CVGateApply(module, CVTarget::Reset, 1, 30);
+    CVGateApply(module, CVTarget::Reset, -1, 40);
+    EXPECT_EQ(module.transport, (std::vector<int>{1, 0, -1}));
+    CVGateApply(module, CVTarget::Envelope2, 1, 50);
+    ASSERT_EQ(module.outputs[3].triggers.size(), 1u);
+    EXPECT_EQ(module.outputs[3].triggers[0], std::make_pair(true, 50ul));
+}
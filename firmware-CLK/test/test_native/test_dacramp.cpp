@@ -0,0 +1,49 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "dacramp.hpp"
+
+// Test the phase step is the refresh period in fractions of a tick
+TEST(DACRamp, Step) {
+    EXPECT_EQ(RampStep(500, 7812), (500ul << 16) / 7812); // 10 BPM
+    EXPECT_EQ(RampStep(500, 1000), RAMP_ONE / 2);
+    EXPECT_EQ(RampStep(500, 260), RAMP_ONE); // Ticks faster than the refresh, no glide
+    EXPECT_EQ(RampStep(500, 0), RAMP_ONE);
+}
+
+// Test a glide reaches the tick level in a tick and holds it
+TEST(DACRamp, Glide) {
+    DACRamp ramp;
+    int level;
+    ramp.Target(1000, false);
+    EXPECT_TRUE(ramp.Next(RAMP_ONE / 4, level));
+    EXPECT_EQ(level, 1000);
+    ramp.Target(2000, true);
+    for (int expected : {1250, 1500, 1750, 2000}) {
+        EXPECT_TRUE(ramp.Next(RAMP_ONE / 4, level));
+        EXPECT_EQ(level, expected);
+    }
+    EXPECT_FALSE(ramp.Next(RAMP_ONE / 4, level)); // Unchanged level isn't written again
+    EXPECT_EQ(level, 2000);
+
+    // Falling, from the level reached when the next tick comes early
+    ramp.Target(0, true);
+    ramp.Next(RAMP_ONE / 2, level);
+    EXPECT_EQ(level, 1000);
+    ramp.Target(800, true);
+    ramp.Next(RAMP_ONE / 2, level);
+    EXPECT_EQ(level, 900);
+}
+
+// Test a jump is written at the next refresh
+TEST(DACRamp, Jump) {
+    DACRamp ramp;
+    int level;
+    ramp.Target(4095, true);
+    ramp.Next(RAMP_ONE / 8, level);
+    EXPECT_EQ(level, 511);
+    ramp.Target(3000, false);
+    EXPECT_TRUE(ramp.Next(RAMP_ONE / 8, level));
+    EXPECT_EQ(level, 3000);
+}
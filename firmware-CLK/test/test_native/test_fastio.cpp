@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "fastio.hpp"
+
+static const int gatePins[] = {1, 2};
+
+// Test all gate edges are written together
+TEST(FastIO, SimultaneousEdges) {
+    FastGatesInit(gatePins, 2);
+    FastGatesWrite(0b11);
+    EXPECT_EQ(0b11u, fastIOFake.gateLevels);
+    EXPECT_EQ(1ul, fastIOFake.gateWrites);
+    // A rising and a falling edge are also a single write
+    FastGatesWrite(0b01);
+    FastGatesWrite(0b10);
+    EXPECT_EQ(0b10u, fastIOFake.gateLevels);
+    EXPECT_EQ(3ul, fastIOFake.gateWrites);
+}
+
+// Test unchanged levels don't touch the port
+TEST(FastIO, NoChange) {
+    FastGatesInit(gatePins, 2);
+    FastGatesWrite(0b01);
+    FastGatesWrite(0b01);
+    FastGatesWrite(0b101); // Bit out of the gates
+    EXPECT_EQ(0b01u, fastIOFake.gateLevels);
+    EXPECT_EQ(1ul, fastIOFake.gateWrites);
+}
+
+// Test single gate writes keep the other gates
+TEST(FastIO, SingleGate) {
+    FastGatesInit(gatePins, 2);
+    FastGateWrite(1, true);
+    EXPECT_EQ(0b10u, fastIOFake.gateLevels);
+    FastGateWrite(0, true);
+    FastGateWrite(1, false);
+    EXPECT_EQ(0b01u, fastIOFake.gateLevels);
+}
+
+// Test the DAC keeps 10 bits
+TEST(FastIO, DAC) {
+    FastDACInit(0);
+    FastDACWrite(4095 >> 2);
+    EXPECT_EQ(1023, fastIOFake.dacValue);
+    FastDACWrite(1024);
+    EXPECT_EQ(0, fastIOFake.dacValue);
+    EXPECT_EQ(2ul, fastIOFake.dacWrites);
+}
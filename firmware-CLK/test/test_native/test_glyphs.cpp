@@ -0,0 +1,88 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "glyphs.hpp"
+
+#define WIDTH 128
+#define HEIGHT 64
+
+// Adafruit GFX drawChar() at text size 1, one pixel at a time
+static void DrawCharReference(uint8_t buffer[], int x, int y, char c, bool color, bool background) {
+    auto drawPixel = [&](int px, int py, bool on) {
+        if (px < 0 || py < 0 || px >= WIDTH || py >= HEIGHT) {
+            return;
+        }
+        if (on) {
+            buffer[px + (py / 8) * WIDTH] |= 1 << (py & 7);
+        } else {
+            buffer[px + (py / 8) * WIDTH] &= ~(1 << (py & 7));
+        }
+    };
+    for (int i = 0; i < 5; i++) {
+        uint8_t line = GlyphFont[c - GLYPH_FIRST][i];
+        for (int j = 0; j < 8; j++, line >>= 1) {
+            if (line & 1) {
+                drawPixel(x + i, y + j, color);
+            } else if (background != color) {
+                drawPixel(x + i, y + j, background);
+            }
+        }
+    }
+    if (background != color) {
+        for (int j = 0; j < 8; j++) {
+            drawPixel(x + 5, y + j, background);
+        }
+    }
+}
+
+// Test the blitted text matches the per pixel drawing at any position and color
+TEST(Glyphs, MatchesReference) {
+    const char *text = "CV 1: Sw/Ph gjpqy~";
+    const int positions[][2] = {{0, 0}, {10, 20}, {3, 7}, {120, 60}, {-4, -3}, {50, 57}, {127, 1}};
+    const bool colors[][2] = {{true, true}, {false, false}, {true, false}, {false, true}};
+    for (auto &position : positions) {
+        for (auto &color : colors) {
+            uint8_t expected[WIDTH * HEIGHT / 8], actual[WIDTH * HEIGHT / 8];
+            for (unsigned int i = 0; i < sizeof(expected); i++) {
+                expected[i] = actual[i] = i * 37; // Background pattern
+            }
+            int x = position[0];
+            for (const char *c = text; *c; c++, x += GLYPH_WIDTH) {
+                DrawCharReference(expected, x, position[1], *c, color[0], color[1]);
+            }
+            EXPECT_EQ(int(strlen(text)) * GLYPH_WIDTH, BlitText(actual, WIDTH, HEIGHT, position[0], position[1], text, color[0], color[1]));
+            ASSERT_EQ(0, memcmp(expected, actual, sizeof(expected))) << "at " << position[0] << "," << position[1];
+        }
+    }
+}
+
+// Test characters without a glyph are drawn as '?'
+TEST(Glyphs, MissingGlyph) {
+    uint8_t columns[GLYPH_WIDTH * 2], expected[GLYPH_WIDTH];
+    EXPECT_EQ(GLYPH_WIDTH * 2, RenderGlyphs("\x7f\x01", columns, sizeof(columns)));
+    RenderGlyphs("?", expected, sizeof(expected));
+    EXPECT_EQ(0, memcmp(expected, columns, GLYPH_WIDTH));
+    EXPECT_EQ(0, memcmp(expected, columns + GLYPH_WIDTH, GLYPH_WIDTH));
+}
+
+// Test labels are rendered once and found by address
+TEST(Glyphs, LabelCache) {
+    static const char first[] = "- CLOCK -";
+    static const char second[] = "Swing";
+    LabelCache<2, 80> cache;
+    int count = 0;
+    const uint8_t *columns = cache.Get(first, count);
+    ASSERT_NE(nullptr, columns);
+    EXPECT_EQ(9 * GLYPH_WIDTH, count);
+    EXPECT_EQ(columns, cache.Get(first, count));
+    EXPECT_EQ(1, cache.GetEntries());
+
+    uint8_t expected[9 * GLYPH_WIDTH];
+    RenderGlyphs(first, expected, sizeof(expected));
+    EXPECT_EQ(0, memcmp(expected, columns, sizeof(expected)));
+
+    // Out of space, the label is drawn uncached
+    EXPECT_EQ(nullptr, cache.Get(second, count));
+    EXPECT_EQ(1, cache.GetEntries());
+}
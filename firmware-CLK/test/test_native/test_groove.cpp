@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "groove.hpp"
+
+#define PPQN 192
+
+// Test the 909 groove delays the first of every steps as the swing amount in 96ths did
+TEST(Groove, Shuffle) {
+    for (int amount = 0; amount <= 12; amount += 2) {
+        for (int every = 1; every <= 16; every++) {
+            GrooveTable groove = ShuffleGroove(amount, every);
+            if (amount == 0) {
+                EXPECT_EQ(groove.steps, 0);
+                continue;
+            }
+            ASSERT_EQ(groove.steps, every);
+            for (unsigned long step = 0; step < 64; step++) {
+                int expected = step % every == 0 ? amount * PPQN / 96 : 0;
+                EXPECT_EQ(groove.offsets[step % groove.steps] * PPQN / GROOVE_RESOLUTION, expected) << amount << " every " << every;
+            }
+        }
+    }
+}
+
+// Test the MPC grooves place the second 1/16th at the swing percentage of the 1/8th
+TEST(Groove, MPCSwing) {
+    const int expected[MPCSwingAmount] = {4, 8, 12, 15, 20, 24};
+    for (int i = 0; i < MPCSwingAmount; i++) {
+        GrooveTable groove = SwingGroove(MPCSwings[i]);
+        ASSERT_EQ(groove.steps, 2);
+        EXPECT_EQ(groove.offsets[0], 0);
+        EXPECT_EQ(groove.offsets[1], expected[i]) << int(MPCSwings[i]);
+    }
+    EXPECT_EQ(SwingGroove(50).steps, 0);
+}
+
+// Test the user pattern is copied up to the longest table
+TEST(Groove, User) {
+    uint8_t offsets[40];
+    for (int i = 0; i < 40; i++) {
+        offsets[i] = i;
+    }
+    GrooveTable groove = UserGroove(offsets, 3);
+    ASSERT_EQ(groove.steps, 3);
+    EXPECT_EQ(groove.offsets[2], 2);
+    EXPECT_EQ(groove.offsets[3], 0);
+    groove = UserGroove(offsets, 40);
+    ASSERT_EQ(groove.steps, GROOVE_MAX_STEPS);
+    EXPECT_EQ(groove.offsets[GROOVE_MAX_STEPS - 1], GROOVE_MAX_STEPS - 1);
+    EXPECT_EQ(UserGroove(offsets, 0).steps, 0);
+}
@@ -0,0 +1,152 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "displayflush.hpp"
+#include "i2carbiter.hpp"
+
+static DisplayFlush flush;
+static uint8_t frame[128 * 64 / 8];
+
+static void OnFlushDone() {
+    flush.OnTransferDone();
+}
+
+class DisplayFlushTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        i2cArbiter = I2CArbiter();
+        i2cArbiter.Begin();
+        flush = DisplayFlush();
+        flush.Begin(0x3C, 128, 64, OnFlushDone);
+        for (int i = 0; i < int(sizeof(frame)); i++) {
+            frame[i] = i;
+        }
+    }
+};
+
+// Test a frame is sent as the address commands followed by chunks of display data
+TEST_F(DisplayFlushTest, Chunks) {
+    ASSERT_TRUE(flush.Start(frame));
+    EXPECT_TRUE(flush.Busy());
+    EXPECT_FALSE(flush.Start(frame));
+    int transfers = 0;
+    while (flush.Busy() && transfers < 100) {
+        I2CDMAFakeComplete();
+        transfers++;
+    }
+    EXPECT_EQ(1 + 1024 / DISPLAY_FLUSH_CHUNK, transfers);
+    EXPECT_EQ(0x3C, i2cDMAFake.address);
+    EXPECT_EQ(1UL, flush.GetFrames());
+
+    const uint8_t commands[] = {0x00, 0x22, 0, 0xFF, 0x21, 0, 127};
+    EXPECT_EQ(0, memcmp(commands, i2cDMAFake.log, sizeof(commands)));
+    const uint8_t *chunk = i2cDMAFake.log + sizeof(commands);
+    for (int offset = 0; offset < 1024; offset += DISPLAY_FLUSH_CHUNK) {
+        ASSERT_EQ(0x40, chunk[0]);
+        EXPECT_EQ(0, memcmp(frame + offset, chunk + 1, DISPLAY_FLUSH_CHUNK));
+        chunk += DISPLAY_FLUSH_CHUNK + 1;
+    }
+}
+
+// Test the bus lock holds the next chunk until the bus is unlocked
+TEST_F(DisplayFlushTest, BusLock) {
+    flush.Start(frame);
+    I2CBusLock();
+    I2CDMAFakeComplete();
+    EXPECT_FALSE(I2CDMABusy());
+    EXPECT_EQ(1UL, i2cDMAFake.transfers);
+    I2CBusUnlock();
+    EXPECT_TRUE(I2CDMABusy());
+    EXPECT_EQ(2UL, i2cDMAFake.transfers);
+}
+
+static const uint8_t chunk[64] = {};
+static int displayDone = 0;
+
+// Chain display chunks like the display flush does
+static void OnDisplayDone() {
+    static const uint8_t stream = 0x40;
+    if (++displayDone < 4) {
+        i2cArbiter.Submit(I2CClientDisplay, 0x3C, &stream, 1, chunk, sizeof(chunk));
+    }
+}
+
+static void WriteDAC(int value) {
+    uint8_t bytes[2] = {uint8_t(value >> 8), uint8_t(value)};
+    i2cArbiter.Submit(I2CClientDAC, 0x60, bytes, 2, nullptr, 0, true);
+}
+
+class I2CArbiterTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        i2cArbiter = I2CArbiter();
+        i2cArbiter.Begin();
+        i2cArbiter.SetClient(I2CClientDisplay, OnDisplayDone);
+        displayDone = 0;
+    }
+
+    // Complete the transaction on the bus, returns the address of the next one
+    int Next() {
+        i2cDMAFake.micros += 500;
+        I2CDMAFakeComplete();
+        return I2CDMABusy() ? i2cDMAFake.address : -1;
+    }
+};
+
+// Test a DAC write goes right after the display chunk on the bus
+TEST_F(I2CArbiterTest, DACPriority) {
+    const uint8_t stream = 0x40;
+    i2cArbiter.Submit(I2CClientDisplay, 0x3C, &stream, 1, chunk, sizeof(chunk));
+    EXPECT_EQ(0x3C, i2cDMAFake.address);
+    WriteDAC(100);
+    EXPECT_EQ(1, i2cArbiter.GetDepth(I2CClientDAC));
+    EXPECT_EQ(0x60, Next());
+    EXPECT_EQ(0x3C, Next());
+    EXPECT_EQ(0x3C, Next());
+    WriteDAC(200);
+    EXPECT_EQ(0x60, Next());
+    EXPECT_EQ(0x3C, Next());
+    EXPECT_EQ(-1, Next());
+    EXPECT_EQ(4, displayDone);
+    EXPECT_EQ(2UL, i2cArbiter.GetStats(I2CClientDAC).sent);
+    EXPECT_EQ(500UL, i2cArbiter.GetStats(I2CClientDAC).maxWait);
+    EXPECT_EQ(4UL, i2cArbiter.GetStats(I2CClientDisplay).sent);
+}
+
+// Test a newer DAC value replaces the one still waiting
+TEST_F(I2CArbiterTest, LatestDACValue) {
+    const uint8_t stream = 0x40;
+    i2cArbiter.Submit(I2CClientDisplay, 0x3C, &stream, 1, chunk, sizeof(chunk));
+    WriteDAC(0x123);
+    WriteDAC(0x456);
+    EXPECT_EQ(1, i2cArbiter.GetDepth(I2CClientDAC));
+    EXPECT_EQ(1, i2cArbiter.GetStats(I2CClientDAC).maxDepth);
+    int logged = i2cDMAFake.logLength;
+    EXPECT_EQ(0x60, Next());
+    EXPECT_EQ(0x04, i2cDMAFake.log[logged]);
+    EXPECT_EQ(0x56, i2cDMAFake.log[logged + 1]);
+}
+
+// Test full queues drop the transaction and count it
+TEST_F(I2CArbiterTest, QueueFull) {
+    const uint8_t stream = 0x40;
+    for (int i = 0; i < I2C_QUEUE_LENGTH + 1; i++) {
+        EXPECT_TRUE(i2cArbiter.Submit(I2CClientDisplay, 0x3C, &stream, 1, chunk, sizeof(chunk)));
+    }
+    EXPECT_FALSE(i2cArbiter.Submit(I2CClientDisplay, 0x3C, &stream, 1, chunk, sizeof(chunk)));
+    EXPECT_EQ(I2C_QUEUE_LENGTH, i2cArbiter.GetStats(I2CClientDisplay).maxDepth);
+    EXPECT_EQ(1UL, i2cArbiter.GetStats(I2CClientDisplay).dropped);
+    i2cArbiter.ResetStats();
+    EXPECT_EQ(0UL, i2cArbiter.GetStats(I2CClientDisplay).dropped);
+}
+
+// Test transactions queued while the bus is locked start on unlock
+TEST_F(I2CArbiterTest, BusLock) {
+    I2CBusLock();
+    WriteDAC(1);
+    EXPECT_FALSE(I2CDMABusy());
+    I2CBusUnlock();
+    EXPECT_TRUE(I2CDMABusy());
+    EXPECT_EQ(0x60, i2cDMAFake.address);
+}
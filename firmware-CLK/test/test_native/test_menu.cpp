@@ -0,0 +1,141 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <string>
+
+#include "menu.hpp"
+
+// Drawing calls recorded as text
+struct FakeDisplay {
+    std::string text;
+    int cursors = 0;
+    int filledCursors = 0;
+
+    int width() const { return 128; }
+    void setCursor(int x, int y) { text += "@" + std::to_string(x) + "," + std::to_string(y) + " "; }
+    void print(const char *s) { text += s; }
+    void printLabel(const char *s) { text += s; }
+    void drawTriangle(int, int, int, int, int, int, int) { cursors++; }
+    void fillTriangle(int, int, int, int, int, int, int) { filledCursors++; }
+};
+
+static FakeDisplay fakeDisplay;
+static int32_t values[3] = {5, 0, 1};
+static int32_t otherTarget = 2;
+static int actions = 0;
+
+static int32_t GetValue(int arg) { return values[arg]; }
+static void SetValue(int arg, int32_t value) { values[arg] = value; }
+static void PrintValue(int, int32_t value) { fakeDisplay.print(std::to_string(value).c_str()); }
+static void RunAction(int, int32_t) { actions++; }
+static bool AcceptTarget(int, int32_t value) { return value == 0 || value != otherTarget; }
+
+static const MenuPage testPages[] = {
+    {"FIRST", 2, nullptr},
+    {nullptr, 3, nullptr},
+};
+
+static const MenuItem testItems[] = {
+    {"VALUE:", 10, 20, 70, 1, 0, MenuKind::Edit, MENU_PRESET, 0, 10, 1, GetValue, SetValue, PrintValue, nullptr},
+    {"TOGGLE:", 10, 29, 70, 1, 1, MenuKind::Action, MENU_PRESET, 0, 1, 1, GetValue, SetValue, PrintValue, nullptr},
+    {"TARGET:", 10, 9, 0, 1, 2, MenuKind::Select, MENU_WRAP, 0, 3, 1, GetValue, SetValue, PrintValue, AcceptTarget},
+    {"RUN", 10, 18, 0, 1, 0, MenuKind::Action, 0, 0, 0, 0, nullptr, RunAction, nullptr, nullptr},
+    {nullptr, 10, 27, 0, MENU_NO_CURSOR, 0, MenuKind::Action, 0, 0, 0, 0, nullptr, RunAction, nullptr, nullptr},
+};
+
+class MenuTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        values[0] = 5;
+        values[1] = 0;
+        values[2] = 1;
+        otherTarget = 2;
+        actions = 0;
+        fakeDisplay = FakeDisplay();
+    }
+
+    Menu menu{testItems, 5, testPages, 2, 0};
+};
+
+// Test navigation wraps around the items and finds their page
+TEST_F(MenuTest, Navigation) {
+    EXPECT_EQ(0, menu.GetPage());
+    EXPECT_FALSE(menu.Turn(-1, 1));
+    EXPECT_EQ(4, menu.GetItem());
+    EXPECT_EQ(1, menu.GetPage());
+    EXPECT_EQ(2, menu.GetPageFirstItem());
+    menu.Turn(1, 8);
+    EXPECT_EQ(0, menu.GetItem());
+    menu.Turn(1, 1);
+    EXPECT_EQ(0, menu.GetPage());
+    EXPECT_EQ(5, values[0]);
+}
+
+// Test edited values move by step times speed and stay in range
+TEST_F(MenuTest, Edit) {
+    EXPECT_FALSE(menu.Click());
+    EXPECT_TRUE(menu.IsEditing());
+    EXPECT_TRUE(menu.Turn(1, 2));
+    EXPECT_EQ(7, values[0]);
+    menu.Turn(1, 8);
+    EXPECT_EQ(10, values[0]);
+    menu.Turn(-1, 8);
+    menu.Turn(-1, 8);
+    EXPECT_EQ(0, values[0]);
+    EXPECT_FALSE(menu.Click());
+    EXPECT_FALSE(menu.IsEditing());
+    menu.Turn(1, 1);
+    EXPECT_EQ(1, menu.GetItem());
+}
+
+// Test actions step the value or run the setter without entering edit mode
+TEST_F(MenuTest, Action) {
+    menu.Select(1);
+    EXPECT_TRUE(menu.Click());
+    EXPECT_EQ(1, values[1]);
+    EXPECT_TRUE(menu.Click());
+    EXPECT_EQ(0, values[1]);
+    EXPECT_FALSE(menu.IsEditing());
+    menu.Select(3);
+    EXPECT_FALSE(menu.Click());
+    EXPECT_EQ(1, actions);
+}
+
+// Test selections wrap, skip the values not accepted and apply when leaving edit mode
+TEST_F(MenuTest, Select) {
+    menu.Select(2);
+    menu.Click();
+    menu.Turn(1, 8);
+    EXPECT_EQ(1, values[2]); // Not applied yet
+    EXPECT_EQ(3, menu.GetValue(2)); // 2 is skipped
+    menu.Turn(1, 1);
+    EXPECT_EQ(0, menu.GetValue(2));
+    menu.Turn(-1, 1);
+    menu.Turn(-1, 1);
+    EXPECT_EQ(1, menu.GetValue(2));
+    menu.Turn(1, 1);
+    menu.Click();
+    EXPECT_EQ(3, values[2]);
+    EXPECT_EQ(3, menu.GetValue(2));
+}
+
+// Test only the page of the selected item is drawn, with header and cursor
+TEST_F(MenuTest, Draw) {
+    menu.Draw(fakeDisplay);
+    EXPECT_EQ("@37,1 - FIRST -@10,20 VALUE:@70,20 5@10,29 TOGGLE:@70,29 0", fakeDisplay.text);
+    EXPECT_EQ(1, fakeDisplay.cursors);
+    EXPECT_EQ(0, fakeDisplay.filledCursors);
+
+    fakeDisplay = FakeDisplay();
+    menu.Select(2);
+    menu.Click();
+    menu.Draw(fakeDisplay);
+    EXPECT_EQ("@10,9 TARGET:1@10,18 RUN", fakeDisplay.text);
+    EXPECT_EQ(1, fakeDisplay.filledCursors);
+
+    fakeDisplay = FakeDisplay();
+    menu.Select(4);
+    menu.Draw(fakeDisplay);
+    EXPECT_EQ(0, fakeDisplay.cursors + fakeDisplay.filledCursors);
+}
@@ -0,0 +1,65 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "noise.hpp"
+
+// Test the segment ends on the random target after the period
+TEST(ValueNoise, ReachesTarget) {
+    Prng prng(42), reference(42);
+    ValueNoise noise;
+    noise.Start(prng, 96);
+    int32_t target = reference.Below(ValueNoise::Max + 1);
+    for (int i = 0; i < 96; i++) {
+        noise.Tick();
+    }
+    EXPECT_NEAR(target, noise.GetValue(), 1);
+    // Holds the target past the end of the segment
+    noise.Tick();
+    EXPECT_NEAR(target, noise.GetValue(), 1);
+}
+
+// Test the output is continuous and stays in range across segments
+TEST(ValueNoise, Continuous) {
+    Prng prng(7);
+    ValueNoise noise;
+    const int period = 48;
+    int32_t last = noise.GetValue();
+    for (int segment = 0; segment < 200; segment++) {
+        noise.Start(prng, period);
+        for (int i = 0; i < period; i++) {
+            int32_t value = noise.Tick();
+            ASSERT_GE(value, 0);
+            ASSERT_LE(value, ValueNoise::Max);
+            // Smoothstep slope peaks at 1.5x the linear slope
+            ASSERT_LE(abs(value - last), ValueNoise::Max * 3 / 2 / period + 2);
+            last = value;
+        }
+    }
+}
+
+// Test outputs with their own generators don't share state
+TEST(ValueNoise, Independent) {
+    Prng prngA(PRNG_DEFAULT_SEED + 1), prngB(PRNG_DEFAULT_SEED + 2), prngC(PRNG_DEFAULT_SEED + 1);
+    ValueNoise a, b, c;
+    // Ticking b in between must not change a, which matches c ticked alone
+    for (int segment = 0; segment < 10; segment++) {
+        a.Start(prngA, 24);
+        b.Start(prngB, 24);
+        c.Start(prngC, 24);
+        for (int i = 0; i < 24; i++) {
+            a.Tick();
+            b.Tick();
+            EXPECT_EQ(c.Tick(), a.GetValue());
+        }
+    }
+    EXPECT_NE(a.GetValue(), b.GetValue());
+}
+
+// Test a zero period jumps straight to the target
+TEST(ValueNoise, ZeroPeriod) {
+    Prng prng(3), reference(3);
+    ValueNoise noise;
+    noise.Start(prng, 0);
+    EXPECT_EQ(int32_t(reference.Below(ValueNoise::Max + 1)), noise.Tick());
+}
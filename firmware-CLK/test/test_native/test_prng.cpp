@@ -0,0 +1,81 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "prng.hpp"
+
+// Test the same seed always gives the same sequence
+TEST(Prng, Deterministic) {
+    Prng a(1234), b(1234);
+    for (int i = 0; i < 1000; i++) {
+        EXPECT_EQ(a.Next(), b.Next());
+    }
+    a.Seed(1234);
+    b.Seed(1234);
+    EXPECT_EQ(a.Next(), b.Next());
+}
+
+// Test close seeds give different sequences
+TEST(Prng, SeedsDiffer) {
+    Prng a(PRNG_DEFAULT_SEED + 1), b(PRNG_DEFAULT_SEED + 2);
+    int equal = 0;
+    for (int i = 0; i < 100; i++) {
+        equal += a.Below(100) == b.Below(100);
+    }
+    EXPECT_LT(equal, 10);
+}
+
+// Test a zero seed doesn't lock the generator
+TEST(Prng, ZeroSeed) {
+    Prng prng(0);
+    uint32_t first = prng.Next();
+    EXPECT_NE(0u, first);
+    EXPECT_NE(first, prng.Next());
+}
+
+// Test values stay in range and cover it evenly
+TEST(Prng, Range) {
+    Prng prng;
+    int histogram[10] = {0};
+    for (int i = 0; i < 100000; i++) {
+        uint32_t value = prng.Below(10);
+        ASSERT_LT(value, 10u);
+        histogram[value]++;
+    }
+    for (int i = 0; i < 10; i++) {
+        EXPECT_NEAR(10000, histogram[i], 500);
+    }
+
+    bool seenMax = false;
+    for (int i = 0; i < 100000; i++) {
+        uint32_t value = prng.Below(4096);
+        ASSERT_LT(value, 4096u);
+        seenMax |= value == 4095;
+    }
+    EXPECT_TRUE(seenMax);
+}
+
+// Test Between follows Arduino random(min, max)
+TEST(Prng, Between) {
+    Prng prng;
+    for (int i = 0; i < 1000; i++) {
+        int32_t value = prng.Between(-5, 5);
+        ASSERT_GE(value, -5);
+        ASSERT_LT(value, 5);
+    }
+    EXPECT_EQ(7, prng.Between(7, 7));
+    EXPECT_EQ(7, prng.Between(7, 3));
+}
+
+// Test bipolar values stay from -1 to 1 and average around 0
+TEST(Prng, Bipolar) {
+    Prng prng;
+    float sum = 0.0f;
+    for (int i = 0; i < 10000; i++) {
+        float value = prng.Bipolar();
+        ASSERT_GE(value, -1.0f);
+        ASSERT_LE(value, 1.0f);
+        sum += value;
+    }
+    EXPECT_NEAR(0.0f, sum / 10000, 0.05f);
+}
@@ -0,0 +1,465 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <fcntl.h>
+#include <poll.h>
+#include <termios.h>
+#include <thread>
+#include <unistd.h>
+
+#include "cvreplay.hpp"
+#include "protocol.hpp"
+
+// Test CRC-16/CCITT-FALSE check value
+TEST(Protocol, Crc16) {
+    const uint8_t data[] = {'1', '2', '3', '4', '5', '6', '7', '8', '9'};
+    EXPECT_EQ(0x29B1, Crc16(data, sizeof(data)));
+}
+
+// Test COBS round trip with zeros and blocks longer than 254 bytes
+TEST(Protocol, CobsRoundTrip) {
+    uint8_t data[600];
+    for (size_t i = 0; i < sizeof(data); i++) {
+        data[i] = i % 7 == 0 ? 0 : (i < 300 ? 0xAA : i & 0xFF);
+    }
+    uint8_t encoded[sizeof(data) + 8];
+    uint8_t decoded[sizeof(data) + 8];
+    size_t encodedLength = CobsEncode(data, sizeof(data), encoded);
+    for (size_t i = 0; i < encodedLength; i++) {
+        EXPECT_NE(0, encoded[i]);
+    }
+    ASSERT_EQ(sizeof(data), CobsDecode(encoded, encodedLength, decoded));
+    EXPECT_EQ(0, memcmp(data, decoded, sizeof(data)));
+}
+
+// Test that corrupted frames and text between frames are dropped
+TEST(Protocol, DecoderDropsBadFrames) {
+    FrameDecoder decoder;
+    uint8_t payload[] = {1, 0, 2, 3};
+    uint8_t frame[PROTOCOL_MAX_ENCODED];
+    size_t length = EncodeFrame(MsgSetParam, 7, payload, sizeof(payload), frame);
+
+    // Debug text on the same port
+    const char *text = "External clock connected";
+    for (const char *c = text; *c; c++) {
+        EXPECT_FALSE(decoder.Receive(*c));
+    }
+    // Corrupted frame
+    frame[3] ^= 0x10;
+    int frames = 0;
+    for (size_t i = 0; i < length; i++) {
+        frames += decoder.Receive(frame[i]);
+    }
+    EXPECT_EQ(0, frames);
+    EXPECT_GE(decoder.Errors(), 1ul);
+    // Valid frame
+    frame[3] ^= 0x10;
+    for (size_t i = 0; i < length; i++) {
+        frames += decoder.Receive(frame[i]);
+    }
+    ASSERT_EQ(1, frames);
+    EXPECT_EQ(MsgSetParam, decoder.Type());
+    EXPECT_EQ(7, decoder.Seq());
+    ASSERT_EQ(sizeof(payload), decoder.PayloadLength());
+    EXPECT_EQ(0, memcmp(payload, decoder.Payload(), sizeof(payload)));
+}
+
+// ---- Loopback over a pseudo terminal ----
+
+#define TEST_PRESETS 32
+#define TEST_PRESET_SIZE 388 // Same size as the ClockForge preset on the SAMD21
+
+static int deviceFd = -1;
+static int32_t deviceParams[4][4];
+static uint8_t devicePresets[TEST_PRESETS][TEST_PRESET_SIZE];
+
+static bool TestGetParam(uint8_t id, uint8_t ch, int32_t &value) {
+    if (id >= 4 || ch >= 4) {
+        return false;
+    }
+    value = deviceParams[id][ch];
+    return true;
+}
+
+static bool TestSetParam(uint8_t id, uint8_t ch, int32_t &value) {
+    if (id >= 4 || ch >= 4) {
+        return false;
+    }
+    deviceParams[id][ch] = value < 0 ? 0 : (value > 100 ? 100 : value);
+    value = deviceParams[id][ch];
+    return true;
+}
+
+static bool TestReadPreset(uint8_t slot, uint8_t *data) {
+    memcpy(data, devicePresets[slot], TEST_PRESET_SIZE);
+    return true;
+}
+
+static bool TestWritePreset(uint8_t slot, const uint8_t *data) {
+    memcpy(devicePresets[slot], data, TEST_PRESET_SIZE);
+    return true;
+}
+
+static void TestWrite(const uint8_t *data, size_t length) {
+    while (length > 0) {
+        ssize_t written = write(deviceFd, data, length);
+        if (written < 0) {
+            if (errno == EAGAIN || errno == EINTR) {
+                continue;
+            }
+            return;
+        }
+        data += written;
+        length -= written;
+    }
+}
+
+// Trace of TEST_TRACE_EVENTS events, event i at time 1000 * i on channel i % 4 with value i
+#define TEST_TRACE_EVENTS 30
+static std::atomic<int> traceCount{TEST_TRACE_EVENTS};
+
+static int TestReadTrace(uint8_t source, int first, uint8_t *out, int max) {
+    if (source != TraceOutputs) {
+        return -1;
+    }
+    int count = 0;
+    for (; count < max && first + count < traceCount; count++, out += PROTOCOL_TRACE_EVENT) {
+        int i = first + count;
+        PutU32(out, 1000u * i);
+        out[4] = i % 4;
+        PutU16(&out[5], i);
+    }
+    return count;
+}
+
+static void TestClearTrace(uint8_t) {
+    traceCount = 0;
+}
+
+// CV recording, the samples loaded in order
+static std::atomic<int> cvSource{0};
+static std::atomic<int> cvSamples{0};
+
+static bool TestSetCVSource(uint8_t source) {
+    if (source > 1) {
+        return false;
+    }
+    cvSource = source;
+    return true;
+}
+
+static bool TestWriteCVSamples(int first, const uint8_t *, int count) {
+    if (first == 0) {
+        cvSamples = 0;
+    }
+    if (first != cvSamples) {
+        return false;
+    }
+    cvSamples += count;
+    return true;
+}
+
+// User groove of up to 32 steps
+static uint8_t grooveOffsets[32];
+static std::atomic<int> grooveSteps{0};
+
+static int TestReadGroove(uint8_t *offsets) {
+    memcpy(offsets, grooveOffsets, grooveSteps);
+    return grooveSteps;
+}
+
+static bool TestWriteGroove(const uint8_t *offsets, int steps) {
+    if (steps > 32) {
+        return false;
+    }
+    memcpy(grooveOffsets, offsets, steps);
+    grooveSteps = steps;
+    return true;
+}
+
+static const ProtocolHandler testHandler = {TestGetParam, TestSetParam, TestReadPreset, TestWritePreset, TestWrite, TEST_PRESETS, TEST_PRESET_SIZE,
+                                            TestReadTrace, TestClearTrace, TestSetCVSource, TestWriteCVSamples, TestReadGroove, TestWriteGroove};
+
+class ProtocolLoopback : public ::testing::Test {
+  protected:
+    int hostFd = -1;
+    std::thread device;
+    std::atomic<bool> running{false};
+    std::atomic<bool> notify{false};
+    FrameDecoder decoder;
+    uint8_t rx[256];
+    ssize_t rxLength = 0;
+    ssize_t rxPos = 0;
+
+    void SetUp() override {
+        deviceFd = posix_openpt(O_RDWR | O_NOCTTY);
+        ASSERT_GE(deviceFd, 0);
+        ASSERT_EQ(0, grantpt(deviceFd));
+        ASSERT_EQ(0, unlockpt(deviceFd));
+        hostFd = open(ptsname(deviceFd), O_RDWR | O_NOCTTY);
+        ASSERT_GE(hostFd, 0);
+        // Raw mode, as the USB CDC port is on the module
+        termios tty;
+        tcgetattr(hostFd, &tty);
+        cfmakeraw(&tty);
+        tcsetattr(hostFd, TCSANOW, &tty);
+
+        memset(deviceParams, 0, sizeof(deviceParams));
+        for (int slot = 0; slot < TEST_PRESETS; slot++) {
+            for (int i = 0; i < TEST_PRESET_SIZE; i++) {
+                devicePresets[slot][i] = (slot * 31 + i) & 0xFF;
+            }
+        }
+        running = true;
+        device = std::thread([this] { DeviceLoop(); });
+    }
+
+    void TearDown() override {
+        running = false;
+        if (device.joinable()) {
+            device.join();
+        }
+        close(hostFd);
+        close(deviceFd);
+    }
+
+    // Module side, mirrors HandleSerial() in the firmware loop
+    void DeviceLoop() {
+        SerialProtocol protocol(testHandler);
+        uint8_t buffer[64];
+        while (running) {
+            pollfd pfd = {deviceFd, POLLIN, 0};
+            if (poll(&pfd, 1, 1) > 0) {
+                ssize_t length = read(deviceFd, buffer, sizeof(buffer));
+                if (length > 0) {
+                    protocol.Receive(buffer, length);
+                }
+            }
+            if (notify.exchange(false)) {
+                protocol.NotifyParam(2, 1, 42);
+            }
+        }
+    }
+
+    void Send(uint8_t type, uint8_t seq, const uint8_t *payload, size_t length) {
+        uint8_t out[PROTOCOL_MAX_ENCODED];
+        size_t encoded = EncodeFrame(type, seq, payload, length, out);
+        ASSERT_EQ((ssize_t)encoded, write(hostFd, out, encoded));
+    }
+
+    // Wait for the next valid frame
+    bool Next(int timeoutMs = 1000) {
+        while (true) {
+            while (rxPos < rxLength) {
+                if (decoder.Receive(rx[rxPos++])) {
+                    return true;
+                }
+            }
+            pollfd pfd = {hostFd, POLLIN, 0};
+            if (poll(&pfd, 1, timeoutMs) <= 0) {
+                return false;
+            }
+            rxLength = read(hostFd, rx, sizeof(rx));
+            rxPos = 0;
+            if (rxLength <= 0) {
+                return false;
+            }
+        }
+    }
+};
+
+// Test ping reports the preset layout
+TEST_F(ProtocolLoopback, Ping) {
+    Send(MsgPing, 1, nullptr, 0);
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgPong, decoder.Type());
+    EXPECT_EQ(1, decoder.Seq());
+    ASSERT_EQ(4u, decoder.PayloadLength());
+    EXPECT_EQ(PROTOCOL_VERSION, decoder.Payload()[0]);
+    EXPECT_EQ(TEST_PRESETS, decoder.Payload()[1]);
+    EXPECT_EQ(TEST_PRESET_SIZE, GetU16(&decoder.Payload()[2]));
+}
+
+// Test parameter write replies with the applied value and read back
+TEST_F(ProtocolLoopback, SetGetParam) {
+    uint8_t set[6] = {2, 1};
+    PutI32(&set[2], 150);
+    Send(MsgSetParam, 2, set, sizeof(set));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgParam, decoder.Type());
+    EXPECT_EQ(2, decoder.Seq());
+    EXPECT_EQ(100, GetI32(&decoder.Payload()[2]));
+
+    uint8_t get[2] = {2, 1};
+    Send(MsgGetParam, 3, get, sizeof(get));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgParam, decoder.Type());
+    EXPECT_EQ(100, GetI32(&decoder.Payload()[2]));
+
+    uint8_t bad[2] = {9, 0};
+    Send(MsgGetParam, 4, bad, sizeof(bad));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgNack, decoder.Type());
+    EXPECT_EQ(ErrBadParam, decoder.Payload()[1]);
+}
+
+// Test full preset backup and restore, both well under a second
+TEST_F(ProtocolLoopback, PresetBackupRestore) {
+    static uint8_t backup[TEST_PRESETS][TEST_PRESET_SIZE];
+    memset(backup, 0, sizeof(backup));
+
+    auto start = std::chrono::steady_clock::now();
+    uint8_t request[2] = {0, TEST_PRESETS};
+    Send(MsgReadPresets, 5, request, sizeof(request));
+    size_t received = 0;
+    while (true) {
+        ASSERT_TRUE(Next());
+        if (decoder.Type() == MsgAck) {
+            break;
+        }
+        ASSERT_EQ(MsgPresetChunk, decoder.Type());
+        uint8_t slot = decoder.Payload()[0];
+        uint16_t offset = GetU16(&decoder.Payload()[1]);
+        size_t length = decoder.PayloadLength() - 3;
+        ASSERT_LT(slot, TEST_PRESETS);
+        ASSERT_LE(offset + length, (size_t)TEST_PRESET_SIZE);
+        memcpy(&backup[slot][offset], &decoder.Payload()[3], length);
+        received += length;
+    }
+    auto backupTime = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(sizeof(backup), received);
+    EXPECT_EQ(0, memcmp(backup, devicePresets, sizeof(backup)));
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(backupTime).count(), 500);
+
+    // Restore a modified backup, chunks are streamed and only completed presets are acked
+    for (int slot = 0; slot < TEST_PRESETS; slot++) {
+        backup[slot][0] = 0xF0 | (slot & 0x0F);
+    }
+    start = std::chrono::steady_clock::now();
+    for (int slot = 0; slot < TEST_PRESETS; slot++) {
+        for (int offset = 0; offset < TEST_PRESET_SIZE; offset += PROTOCOL_CHUNK_SIZE) {
+            int length = std::min(PROTOCOL_CHUNK_SIZE, TEST_PRESET_SIZE - offset);
+            uint8_t chunk[PROTOCOL_CHUNK_SIZE + 3];
+            chunk[0] = slot;
+            PutU16(&chunk[1], offset);
+            memcpy(&chunk[3], &backup[slot][offset], length);
+            Send(MsgPresetChunk, 6, chunk, length + 3);
+        }
+    }
+    for (int slot = 0; slot < TEST_PRESETS; slot++) {
+        ASSERT_TRUE(Next());
+        EXPECT_EQ(MsgAck, decoder.Type());
+    }
+    auto restoreTime = std::chrono::steady_clock::now() - start;
+    EXPECT_EQ(0, memcmp(backup, devicePresets, sizeof(backup)));
+    EXPECT_LT(std::chrono::duration_cast<std::chrono::milliseconds>(restoreTime).count(), 500);
+}
+
+// Test an upload with a missing chunk is rejected
+TEST_F(ProtocolLoopback, PresetUploadOutOfOrder) {
+    uint8_t chunk[PROTOCOL_CHUNK_SIZE + 3] = {3};
+    PutU16(&chunk[1], PROTOCOL_CHUNK_SIZE);
+    Send(MsgPresetChunk, 7, chunk, sizeof(chunk));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgNack, decoder.Type());
+    EXPECT_EQ(ErrOutOfOrder, decoder.Payload()[1]);
+}
+
+// Test parameter changes are only streamed when enabled
+TEST_F(ProtocolLoopback, Streaming) {
+    notify = true;
+    EXPECT_FALSE(Next(50));
+
+    uint8_t enable = 1;
+    Send(MsgStream, 8, &enable, 1);
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgAck, decoder.Type());
+    notify = true;
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgParam, decoder.Type());
+    EXPECT_EQ(0, decoder.Seq());
+    EXPECT_EQ(42, GetI32(&decoder.Payload()[2]));
+}
+
+// Test trace read in chunks, then cleared
+TEST_F(ProtocolLoopback, ReadTrace) {
+    traceCount = TEST_TRACE_EVENTS;
+    uint8_t clear = 1;
+    Send(MsgReadTrace, 9, &clear, 1);
+    int events = 0;
+    while (true) {
+        ASSERT_TRUE(Next());
+        EXPECT_EQ(9, decoder.Seq());
+        if (decoder.Type() == MsgAck) {
+            break;
+        }
+        ASSERT_EQ(MsgTraceChunk, decoder.Type());
+        const uint8_t *payload = decoder.Payload();
+        EXPECT_EQ(events, GetU16(payload));
+        for (size_t offset = 2; offset < decoder.PayloadLength(); offset += PROTOCOL_TRACE_EVENT, events++) {
+            EXPECT_EQ(1000 * events, GetI32(&payload[offset]));
+            EXPECT_EQ(events % 4, payload[offset + 4]);
+            EXPECT_EQ(events, GetU16(&payload[offset + 5]));
+        }
+    }
+    EXPECT_EQ(TEST_TRACE_EVENTS, events);
+    EXPECT_EQ(0, traceCount);
+}
+
+// Test a CV recording is loaded in order and the source selected
+TEST_F(ProtocolLoopback, CVRecording) {
+    uint8_t samples[2 + 3 * PROTOCOL_TRACE_EVENT] = {};
+    Send(MsgCVSamples, 10, samples, sizeof(samples));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgAck, decoder.Type());
+    PutU16(samples, 3);
+    Send(MsgCVSamples, 11, samples, sizeof(samples));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgAck, decoder.Type());
+    PutU16(samples, 9);
+    Send(MsgCVSamples, 12, samples, sizeof(samples));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgNack, decoder.Type());
+    EXPECT_EQ(ErrOutOfOrder, decoder.Payload()[1]);
+    EXPECT_EQ(6, cvSamples);
+
+    uint8_t source = CVReplay;
+    Send(MsgCVSource, 13, &source, 1);
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgAck, decoder.Type());
+    EXPECT_EQ(CVReplay, cvSource);
+    source = 7;
+    Send(MsgCVSource, 14, &source, 1);
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgNack, decoder.Type());
+    EXPECT_EQ(ErrBadParam, decoder.Payload()[1]);
+}
+
+// Test the user groove is loaded and read back
+TEST_F(ProtocolLoopback, Groove) {
+    const uint8_t groove[] = {4, 0, 8, 0, 16};
+    Send(MsgGroove, 20, groove, sizeof(groove));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgAck, decoder.Type());
+    Send(MsgGroove, 21, nullptr, 0);
+    ASSERT_TRUE(Next());
+    ASSERT_EQ(MsgGroove, decoder.Type());
+    ASSERT_EQ(sizeof(groove), decoder.PayloadLength());
+    EXPECT_EQ(0, memcmp(groove, decoder.Payload(), sizeof(groove)));
+
+    const uint8_t truncated[] = {4, 0, 8};
+    Send(MsgGroove, 22, truncated, sizeof(truncated));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgNack, decoder.Type());
+    EXPECT_EQ(ErrBadLength, decoder.Payload()[1]);
+    uint8_t tooLong[34] = {33};
+    Send(MsgGroove, 23, tooLong, sizeof(tooLong));
+    ASSERT_TRUE(Next());
+    EXPECT_EQ(MsgNack, decoder.Type());
+    EXPECT_EQ(ErrBadParam, decoder.Payload()[1]);
+    EXPECT_EQ(4, grooveSteps);
+}
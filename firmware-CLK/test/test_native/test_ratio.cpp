@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "ratio.hpp"
+
+#define PPQN 192
+
+// Test period k of every ratio starts on tick ceil(k * num / den) over a whole cycle of num ticks
+TEST(Ratio, PeriodStarts) {
+    for (unsigned long multiply = 1; multiply <= 64; multiply++) {
+        for (unsigned long divide = 1; divide <= 64; divide++) {
+            unsigned long num = PPQN * divide, den = multiply;
+            unsigned long period = 0, start = 0;
+            for (unsigned long tick = 0; tick < 2 * num; tick++) {
+                if ((period * num + den - 1) / den == tick) {
+                    start = tick;
+                    period++;
+                }
+                ASSERT_EQ(PeriodOffset(tick, num, den), tick - start) << multiply << ":" << divide << " tick " << tick;
+                ASSERT_EQ(PeriodIndex(tick, num, den), period - 1) << multiply << ":" << divide << " tick " << tick;
+            }
+        }
+    }
+}
+
+// Test the periods stay locked to the master over hours of ticks
+TEST(Ratio, NoDrift) {
+    const unsigned long ratios[][2] = {{5, 7}, {2, 3}, {64, 63}, {3, 1}};
+    for (const auto &ratio : ratios) {
+        unsigned long num = PPQN * ratio[1], den = ratio[0];
+        unsigned long starts = 0, ticks = 8ul * 3600 * 1536; // 8 hours at 120 BPM
+        for (unsigned long tick = 0; tick < ticks; tick++) {
+            if (PeriodOffset(tick, num, den) == 0) {
+                starts++;
+            }
+        }
+        EXPECT_EQ(starts, (ticks * den + num - 1) / num);
+        EXPECT_EQ(PeriodIndex(ticks, num, den), ticks * den / num);
+    }
+}
+
+// Test whole periods are the plain modulo
+TEST(Ratio, WholePeriods) {
+    for (unsigned long tick = 0; tick < 10000; tick++) {
+        EXPECT_EQ(PeriodOffset(tick, 96, 1), tick % 96);
+        EXPECT_EQ(PeriodOffset(tick, 384, 4), tick % 96);
+        EXPECT_EQ(PeriodIndex(tick, 384, 4), tick / 96);
+    }
+}
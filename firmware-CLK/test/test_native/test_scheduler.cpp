@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <string>
+
+#include "scheduler.hpp"
+
+static unsigned long now = 0;
+static std::string order;
+
+static unsigned long Clock() { return now; }
+static void Fast() { order += "F"; }
+static void Slow() { order += "S"; }
+static void Idle() { order += "I"; }
+static void Long() {
+    order += "L";
+    now += 300;
+}
+
+class SchedulerTest : public ::testing::Test {
+  protected:
+    void SetUp() override {
+        now = 0;
+        order.clear();
+    }
+
+    Scheduler scheduler{Clock};
+};
+
+// Test periodic tasks run at their rate, by priority, and best effort tasks after them
+TEST_F(SchedulerTest, Rates) {
+    scheduler.Add("fast", Fast, 1000, 0);
+    scheduler.Add("slow", Slow, 2000, 1);
+    scheduler.Add("idle", Idle, 0, 0);
+    for (; now < 4000; now += 500) {
+        while (scheduler.Run())
+            ;
+    }
+    EXPECT_EQ("FSIFIFSIFI", order);
+    EXPECT_EQ(4ul, scheduler.GetTask(0).runs);
+    EXPECT_EQ(2ul, scheduler.GetTask(1).runs);
+    EXPECT_EQ(0ul, scheduler.GetTask(0).misses);
+}
+
+// Test late tasks count the skipped periods and keep their phase
+TEST_F(SchedulerTest, Misses) {
+    scheduler.Add("fast", Fast, 1000, 0);
+    scheduler.Add("long", Long, 1000, 1);
+    EXPECT_TRUE(scheduler.Run());
+    EXPECT_TRUE(scheduler.Run());
+    EXPECT_FALSE(scheduler.Run());
+    EXPECT_EQ(300ul, scheduler.GetTask(1).maxDuration);
+
+    now = 3500;
+    scheduler.Run();
+    EXPECT_EQ(2ul, scheduler.GetTask(0).misses);
+    EXPECT_EQ(2500ul, scheduler.GetTask(0).maxLateness);
+    EXPECT_EQ(4000ul, scheduler.GetTask(0).next);
+    scheduler.ResetStats();
+    EXPECT_EQ(0ul, scheduler.GetTask(0).misses);
+}
+
+// Test tasks beyond the table size are refused
+TEST_F(SchedulerTest, Full) {
+    for (int i = 0; i < SCHEDULER_MAX_TASKS; i++) {
+        EXPECT_EQ(i, scheduler.Add("task", Fast, 1000, 0));
+    }
+    EXPECT_EQ(-1, scheduler.Add("task", Fast, 1000, 0));
+}
+
+// Test Run() reports idle once the best effort tasks had their turn, until a periodic run
+TEST_F(SchedulerTest, Idle) {
+    scheduler.Add("fast", Fast, 1000, 0);
+    scheduler.Add("idle", Idle, 0, 0);
+    EXPECT_TRUE(scheduler.Run());
+    EXPECT_TRUE(scheduler.Run());
+    EXPECT_FALSE(scheduler.Run());
+    now = 400;
+    EXPECT_FALSE(scheduler.Run());
+    now = 1000;
+    EXPECT_TRUE(scheduler.Run());
+    EXPECT_TRUE(scheduler.Run());
+    EXPECT_EQ("FIFI", order);
+}
+
+// Test the duty cycle is the share of the time spent in the tasks
+TEST_F(SchedulerTest, DutyCycle) {
+    scheduler.Add("long", Long, 1000, 0);
+    scheduler.Run();
+    now = 1000;
+    scheduler.Run();
+    now = 2000;
+    EXPECT_FLOAT_EQ(0.3f, scheduler.GetDutyCycle());
+    scheduler.ResetStats();
+    now = 2500;
+    EXPECT_FLOAT_EQ(0.0f, scheduler.GetDutyCycle());
+}
@@ -0,0 +1,33 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <math.h>
+
+#include "tables.hpp"
+
+static constexpr auto squares = MakeTable<uint16_t, 8>([](size_t i) { return i * i; });
+static_assert(squares[7] == 49, "Tables are built at compile time");
+
+// Test the constexpr exponential against the library one
+TEST(Tables, Exp) {
+    for (double x = -8; x <= 8; x += 0.25) {
+        EXPECT_NEAR(exp(x), TableExp(x), exp(x) * 1e-9);
+    }
+}
+
+// Test rounding goes half away from zero
+TEST(Tables, Round) {
+    EXPECT_EQ(3, TableRound(2.5));
+    EXPECT_EQ(-3, TableRound(-2.5));
+    EXPECT_EQ(2, TableRound(2.49));
+}
+
+// Test the generators reach their ends
+TEST(Tables, Generators) {
+    EXPECT_EQ(0, ExpRise(0, 200, 70.0, 1020));
+    EXPECT_EQ(1020, ExpRise(199, 200, 70.0, 1020));
+    EXPECT_LT(ExpRise(100, 200, 70.0, 1020), ExpRise(101, 200, 70.0, 1020));
+    EXPECT_EQ(68, LinearStep(1, 4096.0 / 60, 4095));
+    EXPECT_EQ(4095, LinearStep(60, 4096.0 / 60, 4095));
+}
@@ -0,0 +1,125 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include "tempo.hpp"
+
+// Clock pulses from 1ms to 2s, same range as the clock input
+static TempoEstimator NewEstimator() {
+    return TempoEstimator(1000, 2000000);
+}
+
+// Test a steady clock gives the exact tempo with full confidence
+TEST(TempoEstimator, SteadyClock) {
+    TempoEstimator tempo = NewEstimator();
+    unsigned long time = 0;
+    for (int i = 0; i <= TEMPO_WINDOW; i++, time += 500000) {
+        tempo.AddEvent(time);
+    }
+    EXPECT_EQ(500000ul, tempo.GetInterval());
+    EXPECT_FLOAT_EQ(120.0f, tempo.GetBPM());
+    EXPECT_FLOAT_EQ(1.0f, tempo.GetConfidence());
+}
+
+// Test the estimate is available from the second event
+TEST(TempoEstimator, FirstInterval) {
+    TempoEstimator tempo = NewEstimator();
+    EXPECT_FALSE(tempo.AddEvent(1000));
+    EXPECT_EQ(0ul, tempo.GetInterval());
+    EXPECT_TRUE(tempo.AddEvent(1000 + 600000));
+    EXPECT_FLOAT_EQ(100.0f, tempo.GetBPM());
+}
+
+// Test fractional tempos are kept
+TEST(TempoEstimator, FractionalBPM) {
+    TempoEstimator tempo = NewEstimator();
+    unsigned long interval = 60000000 / 123.5f;
+    for (int i = 0; i <= TEMPO_WINDOW; i++) {
+        tempo.AddEvent(i * interval);
+    }
+    EXPECT_NEAR(123.5f, tempo.GetBPM(), 0.01f);
+}
+
+// Test jitter averages out
+TEST(TempoEstimator, Jitter) {
+    TempoEstimator tempo = NewEstimator();
+    const long jitter[] = {3000, -2000, 1000, -3000, 2500, -1500, 0, 2000, -2500, 1500};
+    for (int i = 0; i < 10; i++) {
+        tempo.AddEvent(i * 500000 + jitter[i]);
+    }
+    EXPECT_NEAR(120.0f, tempo.GetBPM(), 0.5f);
+    EXPECT_GT(tempo.GetConfidence(), 0.8f);
+}
+
+// Test a single late pulse doesn't move the tempo
+TEST(TempoEstimator, OutlierRejected) {
+    TempoEstimator tempo = NewEstimator();
+    unsigned long time = 0;
+    for (int i = 0; i <= TEMPO_WINDOW; i++, time += 500000) {
+        tempo.AddEvent(time);
+    }
+    tempo.AddEvent(time + 150000); // Late pulse
+    time += 500000;
+    tempo.AddEvent(time);
+    EXPECT_NEAR(120.0f, tempo.GetBPM(), 0.5f);
+    EXPECT_LT(tempo.GetConfidence(), 1.0f);
+}
+
+// Test a tempo change locks after two intervals instead of flushing the window
+TEST(TempoEstimator, TempoChange) {
+    TempoEstimator tempo = NewEstimator();
+    unsigned long time = 0;
+    for (int i = 0; i <= TEMPO_WINDOW; i++, time += 500000) {
+        tempo.AddEvent(time);
+    }
+    time -= 500000;
+    for (int i = 0; i < 2; i++) {
+        time += 400000;
+        tempo.AddEvent(time);
+    }
+    EXPECT_FLOAT_EQ(150.0f, tempo.GetBPM());
+    EXPECT_FLOAT_EQ(2.0f / TEMPO_WINDOW, tempo.GetConfidence());
+}
+
+// Test the estimate locks on the second interval of a new tempo
+TEST(TempoEstimator, LockAfterChange) {
+    TempoEstimator tempo = NewEstimator();
+    unsigned long time = 0;
+    for (int i = 0; i <= TEMPO_WINDOW; i++, time += 500000) {
+        tempo.AddEvent(time);
+    }
+    EXPECT_TRUE(tempo.IsLocked());
+    time -= 500000;
+    time += 400000;
+    tempo.AddEvent(time);
+    EXPECT_FLOAT_EQ(120.0f, tempo.GetBPM());
+    time += 400000;
+    tempo.AddEvent(time);
+    EXPECT_EQ(TEMPO_LOCK, tempo.GetAgreeing());
+    EXPECT_TRUE(tempo.IsLocked());
+    EXPECT_FLOAT_EQ(150.0f, tempo.GetBPM());
+}
+
+// Test a fast 48 PPQN clock is within range and locks on its second interval
+TEST(TempoEstimator, FastClock) {
+    TempoEstimator tempo = NewEstimator();
+    const unsigned long interval = 60000000 / 300 / 48; // 4166us
+    tempo.AddEvent(0);
+    tempo.AddEvent(interval);
+    EXPECT_FALSE(tempo.IsLocked());
+    tempo.AddEvent(2 * interval);
+    EXPECT_TRUE(tempo.IsLocked());
+    EXPECT_EQ(interval, tempo.GetInterval());
+}
+
+// Test intervals out of range restart the estimation
+TEST(TempoEstimator, OutOfRange) {
+    TempoEstimator tempo = NewEstimator();
+    tempo.AddEvent(0);
+    tempo.AddEvent(500000);
+    tempo.AddEvent(500000 + 3000000);
+    EXPECT_EQ(0, tempo.GetCount());
+    EXPECT_EQ(0ul, tempo.GetInterval());
+    tempo.AddEvent(500000 + 3000000 + 250000);
+    EXPECT_FLOAT_EQ(240.0f, tempo.GetBPM());
+}
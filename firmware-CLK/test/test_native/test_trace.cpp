@@ -0,0 +1,70 @@
+#include <gtest/gtest.h>
+// uncomment line below if you plan to use GMock
+// #include <gmock/gmock.h>
+
+#include <string>
+
+#include "trace.hpp"
+
+static const TraceChannel channels[] = {{"out1", 1}, {"out3", 12}};
+
+// Test only the changes of each channel are recorded
+TEST(Trace, RecordsChanges) {
+    TraceRecorder<8> trace;
+    trace.Record(10, 0, 1);
+    trace.Record(20, 0, 1);
+    trace.Record(30, 1, 0);
+    trace.Record(40, 0, 0);
+    trace.Record(50, 1, 0);
+    ASSERT_EQ(3, trace.GetCount());
+    EXPECT_EQ(10u, trace.Get(0).time);
+    EXPECT_EQ(1, trace.Get(1).channel);
+    EXPECT_EQ(40u, trace.Get(2).time);
+    EXPECT_EQ(0, trace.Get(2).value);
+
+    trace.SetEnabled(false);
+    trace.Record(60, 0, 1);
+    EXPECT_EQ(3, trace.GetCount());
+}
+
+// Test the oldest events are overwritten when full and Clear() starts over
+TEST(Trace, Wraps) {
+    TraceRecorder<4> trace;
+    for (int i = 0; i < 6; i++) {
+        trace.Record(i, 0, i);
+    }
+    ASSERT_EQ(4, trace.GetCount());
+    EXPECT_EQ(2u, trace.GetOverwritten());
+    for (int i = 0; i < 4; i++) {
+        EXPECT_EQ(i + 2, trace.Get(i).value);
+    }
+
+    trace.Clear();
+    EXPECT_EQ(0, trace.GetCount());
+    trace.Record(100, 0, 5); // Same value as before the clear
+    ASSERT_EQ(1, trace.GetCount());
+    EXPECT_EQ(100u, trace.Get(0).time);
+}
+
+// Test the VCD text, times relative to the first event and unwrapped
+TEST(Trace, WriteVCD) {
+    TraceRecorder<8> trace;
+    trace.Record(0xFFFFFF00, 0, 1);
+    trace.Record(0xFFFFFF00, 1, 2048);
+    trace.Record(0x00000010, 0, 0);
+    trace.Record(0x00000010, 5, 1); // Channel not written
+    std::string vcd;
+    WriteVCD(trace, channels, 2, [&vcd](const char *text) { vcd += text; });
+    EXPECT_EQ("$timescale 1us $end\n"
+              "$scope module forge $end\n"
+              "$var wire 1 ! out1 $end\n"
+              "$var wire 12 \" out3 $end\n"
+              "$upscope $end\n"
+              "$enddefinitions $end\n"
+              "#0\n"
+              "1!\n"
+              "b100000000000 \"\n"
+              "#272\n"
+              "0!\n",
+              vcd);
+}
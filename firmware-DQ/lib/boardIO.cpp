@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "fastio.hpp"
 #include "pinouts.hpp"
 
 // Add prototypes for functions defined in this file
@@ -36,6 +37,8 @@ void InitIO() {
     pinMode(ENCODER_SW, INPUT_PULLUP);   // push sw
     pinMode(OUT_PIN_1, OUTPUT);          // CH1 EG out
     pinMode(OUT_PIN_2, OUTPUT);          // CH2 EG out
+    FastGatesInit(OUT_PINS, NUM_OUTS);
+    FastDACInit(DAC_INTERNAL_PIN);
 
     // Initialize the DAC
     dac.begin(0x60);
@@ -43,7 +46,7 @@ void InitIO() {
 
 // Handle DAC Outputs
 void InternalDAC(int intDAC_OUT) {
-    analogWrite(DAC_INTERNAL_PIN, intDAC_OUT / 4); // "/4" -> 12bit to 10bit
+    FastDACWrite(intDAC_OUT >> 2); // 12bit to 10bit
 }
 
 void MCP(int MCP_OUT) {
@@ -85,10 +88,8 @@ void PWMWrite(int pin, int value) {
 void SetPin(int pin, int value) {
     switch (pin) {
     case 0:
-        value ? digitalWrite(OUT_PIN_1, LOW) : digitalWrite(OUT_PIN_1, HIGH);
-        break;
     case 1:
-        value ? digitalWrite(OUT_PIN_2, LOW) : digitalWrite(OUT_PIN_2, HIGH);
+        FastGateWrite(pin, !value); // Gate outputs are inverted by the output stage
         break;
     case 2:
         value ? InternalDAC(4095) : InternalDAC(0);
@@ -0,0 +1,117 @@
+#pragma once
+#include <stdint.h>
+
+// Fast output layer for the gate outputs and the internal DAC
+//
+// digitalWrite()/analogWrite() look up the pin mapping and check its configuration on every
+// call. Here the gate pins are resolved once at init and all gates are written with a single
+// PORT OUTTGL access, so edges that should coincide change on the same bus write. The internal
+// DAC is written straight to DAC->DATA without waiting for the register sync.
+// Native builds (unit tests, benchmarks) use a fake that records the written levels.
+
+#define FASTIO_MAX_GATES 8
+
+void FastGatesInit(const int pins[], int count);
+void FastGatesWrite(uint32_t levels); // Bit i is the level of pins[i]
+void FastGateWrite(int index, bool level);
+void FastDACInit(int pin);
+void FastDACWrite(int value); // 10 bit
+
+#if defined(ARDUINO_ARCH_SAMD)
+#include <Arduino.h>
+
+struct FastIOPorts {
+    uint32_t masks[FASTIO_MAX_GATES]; // Pin bit in its port group
+    uint8_t groups[FASTIO_MAX_GATES]; // Port group of each pin
+    uint32_t groupMasks[2];           // All gate pins of each port group
+    int count;
+};
+FastIOPorts fastIOPorts;
+
+// Resolve the port group and bit of each gate pin, pins must already be outputs
+void FastGatesInit(const int pins[], int count) {
+    fastIOPorts.count = count < FASTIO_MAX_GATES ? count : FASTIO_MAX_GATES;
+    fastIOPorts.groupMasks[0] = fastIOPorts.groupMasks[1] = 0;
+    for (int i = 0; i < fastIOPorts.count; i++) {
+        const PinDescription &pin = g_APinDescription[pins[i]];
+        fastIOPorts.groups[i] = pin.ulPort;
+        fastIOPorts.masks[i] = 1ul << pin.ulPin;
+        fastIOPorts.groupMasks[pin.ulPort] |= fastIOPorts.masks[i];
+    }
+}
+
+void FastGatesWrite(uint32_t levels) {
+    uint32_t high[2] = {0, 0};
+    for (int i = 0; i < fastIOPorts.count; i++) {
+        if (levels & (1ul << i)) {
+            high[fastIOPorts.groups[i]] |= fastIOPorts.masks[i];
+        }
+    }
+    // Toggle only the gates that change, rising and falling edges on the same write
+    for (int g = 0; g < 2; g++) {
+        if (fastIOPorts.groupMasks[g]) {
+            uint32_t toggle = (PORT->Group[g].OUT.reg ^ high[g]) & fastIOPorts.groupMasks[g];
+            if (toggle) {
+                PORT->Group[g].OUTTGL.reg = toggle;
+            }
+        }
+    }
+}
+
+void FastGateWrite(int index, bool level) {
+    if (level) {
+        PORT->Group[fastIOPorts.groups[index]].OUTSET.reg = fastIOPorts.masks[index];
+    } else {
+        PORT->Group[fastIOPorts.groups[index]].OUTCLR.reg = fastIOPorts.masks[index];
+    }
+}
+
+// Let the core configure and enable the DAC once
+void FastDACInit(int pin) {
+    analogWrite(pin, 0);
+}
+
+// The write is synchronized by the DAC, the bus only stalls if the previous one is still pending
+void FastDACWrite(int value) {
+    DAC->DATA.reg = value & 0x3FF;
+}
+
+#else
+// Native fake, the state is inspected by the tests
+struct FastIOFake {
+    uint32_t gateLevels;      // Bit i is the level of gate i
+    int gateCount;
+    unsigned long gateWrites; // Port writes that changed the gates
+    int dacValue;
+    unsigned long dacWrites;
+};
+FastIOFake fastIOFake;
+
+void FastGatesInit(const int pins[], int count) {
+    (void)pins;
+    fastIOFake = FastIOFake();
+    fastIOFake.gateCount = count < FASTIO_MAX_GATES ? count : FASTIO_MAX_GATES;
+}
+
+void FastGatesWrite(uint32_t levels) {
+    uint32_t mask = (1ul << fastIOFake.gateCount) - 1;
+    if ((fastIOFake.gateLevels ^ levels) & mask) {
+        fastIOFake.gateWrites++;
+    }
+    fastIOFake.gateLevels = levels & mask;
+}
+
+void FastGateWrite(int index, bool level) {
+    FastGatesWrite(level ? fastIOFake.gateLevels | (1ul << index) : fastIOFake.gateLevels & ~(1ul << index));
+}
+
+void FastDACInit(int pin) {
+    (void)pin;
+    fastIOFake.dacValue = 0;
+}
+
+void FastDACWrite(int value) {
+    fastIOFake.dacValue = value & 0x3FF;
+    fastIOFake.dacWrites++;
+}
+#endif
@@ -1,3 +1,5 @@
+#pragma once
+
 // Pinout definitions for SEEED XIAO (SAMD21)
 #define CLK_IN_PIN 7  // Clock input pin
 #define CV_1_IN_PIN 8 // channel 1 analog in
@@ -9,6 +11,9 @@
 #define OUT_PIN_2 2
 #define DAC_INTERNAL_PIN A0 // DAC output pin (internal)
 
+#define NUM_OUTS 2
+int OUT_PINS[] = {OUT_PIN_1, OUT_PIN_2};
+
 // Pin definitions for simulator
 #ifdef IN_SIMULATOR
 #define CLK_IN_PIN 12
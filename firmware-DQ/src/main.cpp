@@ -14,6 +14,7 @@
 #include "quantizer.cpp"
 #include "scales.cpp"
 #include "splash.hpp"
+#include "tables.hpp"
 #include "version.hpp"
 
 // ADC Calibration settings
@@ -53,9 +54,13 @@ float offsetScale[2][2]; // [channel][0: offset, 1: scale]
 float CVOutput[2], oldCVOutput[2] = {0, 0}; // CV output
 long gateTimer[2] = {0, 0};                 // EG curve progress speed
 
-// envelope curve setting
-int ADEnvelopeTable[200] = { // envelope table
-    0, 15, 30, 44, 59, 73, 87, 101, 116, 130, 143, 157, 170, 183, 195, 208, 220, 233, 245, 257, 267, 279, 290, 302, 313, 324, 335, 346, 355, 366, 376, 386, 397, 405, 415, 425, 434, 443, 452, 462, 470, 479, 488, 495, 504, 513, 520, 528, 536, 544, 552, 559, 567, 573, 581, 589, 595, 602, 609, 616, 622, 629, 635, 642, 648, 654, 660, 666, 672, 677, 683, 689, 695, 700, 706, 711, 717, 722, 726, 732, 736, 741, 746, 751, 756, 760, 765, 770, 774, 778, 783, 787, 791, 796, 799, 803, 808, 811, 815, 818, 823, 826, 830, 834, 837, 840, 845, 848, 851, 854, 858, 861, 864, 866, 869, 873, 876, 879, 881, 885, 887, 890, 893, 896, 898, 901, 903, 906, 909, 911, 913, 916, 918, 920, 923, 925, 927, 929, 931, 933, 936, 938, 940, 942, 944, 946, 948, 950, 952, 954, 955, 957, 960, 961, 963, 965, 966, 968, 969, 971, 973, 975, 976, 977, 979, 980, 981, 983, 984, 986, 988, 989, 990, 991, 993, 994, 995, 996, 997, 999, 1000, 1002, 1003, 1004, 1005, 1006, 1007, 1008, 1009, 1010, 1012, 1013, 1014, 1014, 1015, 1016, 1017, 1018, 1019, 1020};
+// envelope curve setting, PWM duty of the attack (rising) and the decay (1021 - table)
+#define ENVELOPE_STEPS 200
+#define ENVELOPE_TIME_CONSTANT 70.0 // Steps, lower is a sharper curve
+#define ENVELOPE_TOP 1020
+constexpr auto ADEnvelopeTable = MakeTable<uint16_t, ENVELOPE_STEPS>([](size_t i) {
+    return ExpRise(i, ENVELOPE_STEPS, ENVELOPE_TIME_CONSTANT, ENVELOPE_TOP);
+});
 
 int adcValues[2] = {0, 0}; // PWM DUTY reference
 bool ADTrigger[2] = {0, 0};
@@ -78,6 +83,19 @@ bool activeNotes[2][12] = {{false}}; // 1=note valid,0=note invalid
 bool displayRefresh = 1;     // 0=not refresh display , 1= refresh display , countermeasure of display refresh busy
 bool unsavedChanges = false; // Unsaved changes flag
 
+// Boot screens, shown from the loop while the quantizer already runs
+#define BOOT_SPLASH_MS 2000
+#define BOOT_NAME_MS 1500
+enum BootScreen {
+    BootSplash,
+    BootName,
+    BootDone,
+};
+BootScreen bootScreen = BootSplash;
+unsigned long bootScreenTime = 0;    // Time (ms) the boot screen was shown
+unsigned long firstOutputMicros = 0; // Time (us) of the first quantized output since reset
+bool bootTimeReported = false;
+
 // Function prototypes
 void HandleEncoderPosition();
 void HandleEncoderClick();
@@ -609,6 +627,46 @@ void HandleInputs() {
     }
 }
 
+// Splash logo, then the module name
+void DrawBootScreen(BootScreen screen) {
+    display.clearDisplay();
+    if (screen == BootSplash) {
+        display.drawBitmap(30, 0, VFM_Splash, 68, 64, 1);
+    } else {
+        display.setTextSize(2);
+        display.setTextColor(WHITE);
+        display.setCursor(10, 20);
+        display.print("NoteForge");
+        display.setTextSize(1);
+        display.setCursor(80, 54);
+        display.print("V" VERSION);
+    }
+    display.display();
+    bootScreen = screen;
+    bootScreenTime = millis();
+}
+
+// Show the next boot screen when it's time, then the keyboards
+void HandleBootScreen() {
+    unsigned long elapsed = millis() - bootScreenTime;
+    if (bootScreen == BootSplash && elapsed >= BOOT_SPLASH_MS) {
+        DrawBootScreen(BootName);
+    } else if (bootScreen == BootName && elapsed >= BOOT_NAME_MS) {
+        bootScreen = BootDone;
+        displayRefresh = 1;
+    }
+}
+
+// Report the boot time once the port is open (DTR, testing Serial itself waits 10 ms)
+void ReportBootTime() {
+    if (!bootTimeReported && Serial.dtr()) {
+        Serial.print(F("Boot to first output: "));
+        Serial.print(firstOutputMicros);
+        Serial.println(F("us"));
+        bootTimeReported = true;
+    }
+}
+
 // Handle IO without the display
 void HandleIO() {
     HandleEncoderClick();
@@ -621,7 +679,13 @@ void HandleIO() {
 void loop() {
     HandleIO();
 
-    HandleOLED();
+    if (bootScreen != BootDone) {
+        HandleBootScreen();
+    } else {
+        HandleOLED();
+    }
+
+    ReportBootTime();
 }
 
 void setup() {
@@ -632,23 +696,6 @@ void setup() {
 
     // OLED initialize
     display.begin(SSD1306_SWITCHCAPVCC, OLED_ADDRESS, false, true);
-    display.clearDisplay();
-
-    display.clearDisplay();
-    display.drawBitmap(30, 0, VFM_Splash, 68, 64, 1);
-    display.display();
-    delay(2000);
-    // Print module name in the middle of the screen
-    display.clearDisplay();
-    display.setTextSize(2);
-    display.setTextColor(WHITE);
-    display.setCursor(10, 20);
-    display.print("NoteForge");
-    display.setTextSize(1);
-    display.setCursor(80, 54);
-    display.print("V" VERSION);
-    display.display();
-    delay(1500);
 
     // Load scale and note settings from flash memory
     LoadSaveParams p = {
@@ -666,4 +713,9 @@ void setup() {
     Load(p, activeNotes[0], activeNotes[1]);
     BuildQuantBuffer(activeNotes[0], quantizerThresholdBuff[0]);
     BuildQuantBuffer(activeNotes[1], quantizerThresholdBuff[1]);
+
+    // Quantize once before the splash, the loop shows the boot screens while it keeps quantizing
+    HandleInputs();
+    firstOutputMicros = micros();
+    DrawBootScreen(BootSplash);
 }
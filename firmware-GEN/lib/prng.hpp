@@ -0,0 +1,45 @@
+#pragma once
+#include <stdint.h>
+
+// Seed used when no entropy is given. Building with -D PRNG_DETERMINISTIC keeps every
+// generator on its default seed so runs are reproducible (native simulation, regression tests)
+#define PRNG_DEFAULT_SEED 0x2545F491
+
+// Small and fast pseudo random generator (xorshift32) for use inside interrupts.
+// Unlike random()/rand() there is no shared state, lock or division: each user keeps its own
+// generator and ranges are reduced with a multiply and shift.
+class Prng {
+  public:
+    Prng(uint32_t seed = PRNG_DEFAULT_SEED) { Seed(seed); }
+
+    // Restart the sequence, the same seed always gives the same sequence
+    void Seed(uint32_t seed) {
+        // Mix the seed so close seeds (like consecutive output IDs) give unrelated sequences
+        seed ^= seed >> 16;
+        seed *= 0x7FEB352D;
+        seed ^= seed >> 15;
+        seed *= 0x846CA68B;
+        seed ^= seed >> 16;
+        _state = seed ? seed : PRNG_DEFAULT_SEED; // Zero would lock xorshift on zero
+    }
+
+    // Random 32 bit value
+    uint32_t Next() {
+        _state ^= _state << 13;
+        _state ^= _state >> 17;
+        _state ^= _state << 5;
+        return _state;
+    }
+
+    // Random value from 0 to range - 1, range up to 65536
+    uint32_t Below(uint32_t range) { return ((Next() >> 16) * range) >> 16; }
+
+    // Random value from min to max - 1, same as Arduino random(min, max)
+    int32_t Between(int32_t min, int32_t max) { return min >= max ? min : min + int32_t(Below(max - min)); }
+
+    // Random value from -1 to 1
+    float Bipolar() { return int32_t(Next()) * (1.0f / 2147483648.0f); }
+
+  private:
+    uint32_t _state;
+};
@@ -6,6 +6,8 @@
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
 
+#include "prng.hpp"
+
 #define OLED_ADDRESS 0x3C
 #define SCREEN_WIDTH 128
 #define SCREEN_HEIGHT 64
@@ -48,6 +50,9 @@ Encoder myEnc(ENC_PIN_1, ENC_PIN_2); // rotary encoder library setting
 float oldPosition = -999;            // rotary encoder library setting
 float newPosition = -999;            // rotary encoder library setting
 
+// Random generator for the patterns and the lottery
+Prng prng;
+
 // Amount of menu items
 int menuItems = 5;
 // i is the current position of the encoder
@@ -142,14 +147,19 @@ void setup()
   REG_ADC_AVGCTRL |= ADC_AVGCTRL_SAMPLENUM_1;
   ADC->AVGCTRL.reg = ADC_AVGCTRL_SAMPLENUM_128 | ADC_AVGCTRL_ADJRES(4);
 
+#ifndef PRNG_DETERMINISTIC
+  // Seed from the CV input noise and boot time so each power up starts a different pattern
+  prng.Seed(micros() ^ (analogRead(CV_1_IN_PIN) << 12) ^ (analogRead(CV_2_IN_PIN) << 20));
+#endif
+
   for (i = 0; i < 2; i = i + 1)
   {
     for (j = 0; j < 16; j = j + 1)
     {
-      stgAgate[i][j] = random(2);
-      stgBgate[i][j] = random(2);
-      stgAcv[i][j] = random(4096);
-      stgBcv[i][j] = random(4096);
+      stgAgate[i][j] = prng.Below(2);
+      stgBgate[i][j] = prng.Below(2);
+      stgAcv[i][j] = prng.Below(4096);
+      stgBcv[i][j] = prng.Below(4096);
     }
   }
 }
@@ -602,13 +612,13 @@ void lottery()
   {
     for (k = 0; k <= chance; k = k + 1)
     {
-      lottery_stepA = random(length_set);
+      lottery_stepA = prng.Below(length_set);
       stgAgate[0][lottery_stepA] = 1 - stgAgate[0][lottery_stepA];
-      stgAcv[0][lottery_stepA] = random(4096);
+      stgAcv[0][lottery_stepA] = prng.Below(4096);
 
-      lottery_stepB = random(length_set);
+      lottery_stepB = prng.Below(length_set);
       stgBgate[0][lottery_stepB] = 1 - stgBgate[0][lottery_stepB];
-      stgBcv[0][lottery_stepB] = random(4096);
+      stgBcv[0][lottery_stepB] = prng.Below(4096);
     }
   }
 }
@@ -4,6 +4,7 @@
 #include <Arduino.h>
 #include <Wire.h>
 
+#include "fastio.hpp"
 #include "pinouts.hpp"
 
 // Add prototypes for functions defined in this file
@@ -53,6 +54,8 @@ void InitIO() {
     for (int i = 0; i < NUM_OUTS; i++) {
         pinMode(OUT_PINS[i], OUTPUT); // Gate out
     }
+    FastGatesInit(OUT_PINS, NUM_OUTS);
+    FastDACInit(DAC_INTERNAL_PIN);
 
     // Initialize the DAC
     if (!dac.begin(0x60)) { // 0x60 is the default I2C address for MCP4725
@@ -61,15 +64,14 @@ void InitIO() {
             ;
     }
     Serial.println("MCP4725 initialized.");
-    MCP(0);                       // Set the DAC output to 0
-    InternalDAC(0);               // Set the internal DAC output to 0
-    digitalWrite(OUT_PIN_1, LOW); // Initialize the output pins to low
-    digitalWrite(OUT_PIN_2, LOW); // Initialize the output pins to low
+    MCP(0);            // Set the DAC output to 0
+    InternalDAC(0);    // Set the internal DAC output to 0
+    FastGatesWrite(0); // Initialize the output pins to low
 }
 
 // Handle DAC Outputs
 void InternalDAC(int value) {
-    analogWrite(DAC_INTERNAL_PIN, value / 4); // "/4" -> 12bit to 10bit
+    FastDACWrite(value >> 2); // 12bit to 10bit
 }
 
 void MCP(int value) {
@@ -111,10 +113,8 @@ void PWMWrite(int pin, int value) {
 void SetPin(int pin, int value) {
     switch (pin) {
     case 0: // Gate Output 1
-        digitalWrite(OUT_PINS[0], value > 0 ? LOW : HIGH);
-        break;
     case 1: // Gate Output 2
-        digitalWrite(OUT_PINS[1], value > 0 ? LOW : HIGH);
+        FastGateWrite(pin, value <= 0); // Gate outputs are inverted by the output stage
         break;
     case 2: // Internal DAC Output
         DACWrite(0, value);
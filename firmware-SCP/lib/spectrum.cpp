@@ -0,0 +1,20 @@
+#pragma once
+
+#include <Arduino.h>
+#include <fix_fft.h>
+
+#define SPECTRUM_SAMPLES 128
+#define SPECTRUM_BINS 64
+
+// Run the FFT over the sampled signal and compute the bin magnitudes
+// Inputs:
+//   data: SPECTRUM_SAMPLES signed samples, overwritten by the real part
+//   im: SPECTRUM_SAMPLES imaginary samples (zeroed), overwritten by the imaginary part
+// Outputs:
+//   levels: SPECTRUM_BINS magnitudes
+void ComputeSpectrum(char data[], char im[], int levels[]) {
+    fix_fft(data, im, 7, 0);
+    for (byte i = 0; i < SPECTRUM_BINS; i++) {
+        levels[i] = sqrt(data[i] * data[i] + im[i] * im[i]);
+    }
+}
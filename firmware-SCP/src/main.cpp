@@ -12,6 +12,7 @@
 #include "boardIO.cpp"
 #include "definitions.hpp"
 #include "pinouts.hpp"
+#include "spectrum.cpp"
 #include "splash.hpp"
 #include "version.hpp"
 
@@ -54,6 +55,20 @@ unsigned long hideTimer = 0; // hide parameter count
 bool hide = 0;               // 1=hide GUI,0=not hide
 
 char data[128], im[128], cv[2][128]; // data and im are used for spectrum , cv is used for oscilo.
+int levels[SPECTRUM_BINS];                // spectrum bin magnitudes
+
+// Boot screens, shown from the loop, any encoder action goes straight to the display mode
+#define BOOT_SPLASH_MS 2000
+#define BOOT_NAME_MS 1500
+enum BootScreen {
+    BootSplash,
+    BootName,
+    BootDone,
+};
+BootScreen bootScreen = BootSplash;
+unsigned long bootScreenTime = 0;   // Time (ms) the boot screen was shown
+unsigned long firstFrameMicros = 0; // Time (us) of the first display frame since reset, 0 before it
+bool bootTimeReported = false;
 
 // Draw a horizontal dashed line
 void DrawHDashedLine(int x0, int y0, int width, int color) {
@@ -173,11 +188,10 @@ void HandleDisplay() {
             data[i] = spec / 4 - 128;
             im[i] = 0;
         };
-        fix_fft(data, im, 7, 0);
+        ComputeSpectrum(data, im, levels);
         display.clearDisplay();
-        for (byte i = 0; i < 64; i++) {
-            int level = sqrt(data[i] * data[i] + im[i] * im[i]);
-            ;
+        for (byte i = 0; i < SPECTRUM_BINS; i++) {
+            int level = levels[i];
             if (level >= param2) {
                 display.fillRect(i * 2, 63 - (level + i * (param1 - 1) / 8), 2, (level + i * (param1 - 1) / 8), WHITE); // i * (param1 - 1) / 8 is high freq amp
             }
@@ -415,6 +429,45 @@ void HandleEncoderPosition() {
     }
 }
 
+// Splash logo, then the module name
+void DrawBootScreen(BootScreen screen) {
+    display.clearDisplay();
+    if (screen == BootSplash) {
+        display.drawBitmap(30, 0, VFM_Splash, 68, 64, 1);
+    } else {
+        display.setTextSize(2);
+        display.setTextColor(WHITE);
+        display.setCursor(4, 20);
+        display.print("ForgeView");
+        display.setTextSize(1);
+        display.setCursor(80, 54);
+        display.print("V" VERSION);
+    }
+    display.display();
+    bootScreen = screen;
+    bootScreenTime = millis();
+}
+
+// Show the next boot screen when it's time, the encoder skips them
+void HandleBootScreen() {
+    unsigned long elapsed = millis() - bootScreenTime;
+    if (hideTimer != 0 || (bootScreen == BootName && elapsed >= BOOT_NAME_MS)) {
+        bootScreen = BootDone;
+    } else if (bootScreen == BootSplash && elapsed >= BOOT_SPLASH_MS) {
+        DrawBootScreen(BootName);
+    }
+}
+
+// Report the boot time once the port is open (DTR, testing Serial itself waits 10 ms)
+void ReportBootTime() {
+    if (!bootTimeReported && firstFrameMicros != 0 && Serial.dtr()) {
+        Serial.print(F("Boot to first frame: "));
+        Serial.print(firstFrameMicros);
+        Serial.println(F("us"));
+        bootTimeReported = true;
+    }
+}
+
 void setup() {
     // Initialize serial port
     Serial.begin(115200);
@@ -429,24 +482,10 @@ void setup() {
             ; // Don't proceed, loop forever
     }
     Wire.setClock(1000000);
-    display.clearDisplay();
     display.setTextWrap(false);
 
-    display.clearDisplay();
-    display.drawBitmap(30, 0, VFM_Splash, 68, 64, 1);
-    display.display();
-    delay(2000);
-    // Print module name in the middle of the screen
-    display.clearDisplay();
-    display.setTextSize(2);
-    display.setTextColor(WHITE);
-    display.setCursor(4, 20);
-    display.print("ForgeView");
-    display.setTextSize(1);
-    display.setCursor(80, 54);
-    display.print("V" VERSION);
-    display.display();
-    delay(1500);
+    // The loop shows the boot screens and takes the encoder meanwhile
+    DrawBootScreen(BootSplash);
 }
 
 // // Handle IO without the display
@@ -460,5 +499,14 @@ void HandleIO() {
 void loop() {
     HandleIO();
 
-    HandleDisplay();
+    if (bootScreen != BootDone) {
+        HandleBootScreen();
+    } else {
+        HandleDisplay();
+        if (firstFrameMicros == 0) {
+            firstFrameMicros = micros();
+        }
+    }
+
+    ReportBootTime();
 }
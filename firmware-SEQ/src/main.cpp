@@ -6,6 +6,8 @@
 #include <Adafruit_SSD1306.h>
 #include <Adafruit_GFX.h>
 
+#include "tables.hpp"
+
 // Display setting
 #define OLED_ADDRESS 0x3C
 #define SCREEN_WIDTH 128
@@ -59,15 +61,18 @@ byte select_div_ch1 = 0;
 byte select_div_ch2 = 0;
 
 // CV setting
-const int cv_qnt_out[61] = {
-    0, 68, 137, 205, 273, 341, 410, 478, 546, 614, 683, 751,
-    819, 887, 956, 1024, 1092, 1161, 1229, 1297, 1365, 1434, 1502, 1570,
-    1638, 1707, 1775, 1843, 1911, 1980, 2048, 2116, 2185, 2253, 2321, 2389,
-    2458, 2526, 2594, 2662, 2731, 2799, 2867, 2935, 3004, 3072, 3140, 3209,
-    3277, 3345, 3413, 3482, 3550, 3618, 3686, 3755, 3823, 3891, 3959, 4028, 4095}; // output pre-quantize
-
-const int cv_qnt_thr[62] = {
-    0, 9, 26, 43, 60, 77, 94, 111, 128, 145, 162, 179, 196, 213, 230, 247, 264, 281, 298, 315, 332, 349, 366, 383, 400, 417, 434, 451, 468, 485, 502, 519, 536, 553, 570, 587, 604, 621, 638, 655, 672, 689, 706, 723, 740, 757, 774, 791, 808, 825, 842, 859, 876, 893, 910, 927, 944, 961, 978, 995, 1012, 1024}; // input quantize
+#define QNT_NOTES 60       // 5 octaves of semitones
+#define QNT_DAC_RANGE 4096 // 12 bit DAC, 1 V/oct over 5 V
+#define QNT_ADC_RANGE 1024 // 10 bit ADC
+constexpr auto cv_qnt_out = MakeTable<uint16_t, QNT_NOTES + 1>([](size_t i) {
+    return LinearStep(i, double(QNT_DAC_RANGE) / QNT_NOTES, QNT_DAC_RANGE - 1);
+}); // output pre-quantize
+
+// Note i is read from cv_qnt_thr[i] to cv_qnt_thr[i + 1], thresholds half a step below each note
+constexpr auto cv_qnt_thr = MakeTable<uint16_t, QNT_NOTES + 2>([](size_t i) {
+    constexpr int step = QNT_ADC_RANGE / QNT_NOTES;
+    return i == 0 ? 0 : i == QNT_NOTES + 1 ? QNT_ADC_RANGE : i * step - step / 2;
+}); // input quantize
 
 byte search_qnt = 0;
 byte rec_step = 0;